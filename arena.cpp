@@ -0,0 +1,77 @@
+///
+/// file: arena.cpp
+/// Implementation for the Arena class
+///
+/// @author Dominick Banasik
+
+#include <stdlib.h>
+
+#include "arena.hpp"
+
+#ifndef _ARENA_IMPL_
+#define _ARENA_IMPL_
+
+/// Adds a block large enough for an allocation. Each new block is at
+/// least as large as everything before it, so an equation needs only a
+/// logarithmic number of blocks.
+
+void Arena::grow(size_t bytes, size_t alignment) {
+    size_t size = capacity > ARENA_BLOCK ? capacity : ARENA_BLOCK;
+    if (size < bytes + alignment) size = bytes + alignment;
+
+    Block* block = (Block*) malloc(sizeof(Block) + size);
+    if (!block) throw std::bad_alloc();
+    block->next = blocks;
+    block->size = size;
+    blocks = block;
+    capacity += size;
+    cursor = (char*) (block + 1);
+    limit = cursor + size;
+}
+
+/// Destroys the objects made by create() and takes back every allocation.
+
+void Arena::reset() {
+    for (Cleanup* cleanup = cleanups; cleanup; cleanup = cleanup->next) {
+        cleanup->destroy(cleanup->objects, cleanup->count);
+    }
+    cleanups = NULL;
+
+    if (blocks->next) {
+        while (blocks) {
+            Block* next = blocks->next;
+            free(blocks);
+            blocks = next;
+        }
+        size_t size = capacity;
+        capacity = 0;
+        grow(size, 1);
+    }
+
+    cursor = (char*) (blocks + 1);
+    limit = cursor + blocks->size;
+}
+
+/// Returns the number of bytes the arena holds.
+
+size_t Arena::getCapacity() const {
+    return capacity;
+}
+
+/// Constructor for the Arena class.
+
+Arena::Arena(size_t capacity) {
+    blocks = NULL;
+    cleanups = NULL;
+    this->capacity = 0;
+    grow(capacity, 1);
+}
+
+/// Destructor for the Arena class.
+
+Arena::~Arena() {
+    reset();
+    free(blocks);
+}
+
+#endif
@@ -0,0 +1,242 @@
+///
+/// file: arena.hpp
+/// Header file for the Arena class and ArenaAllocator
+///
+/// @author Dominick Banasik
+
+#ifndef _ARENA_H_
+#define _ARENA_H_
+
+#include <stddef.h>
+#include <stdlib.h>
+
+#include <new>
+#include <type_traits>
+
+#define ARENA_BLOCK (64 << 10)
+
+/// The Arena class hands out memory for everything built while balancing
+/// one equation by bumping a pointer through a block, and takes it all
+/// back at once when reset. Objects with destructors that are made with
+/// create() are destroyed on reset; plain allocations are simply
+/// forgotten.
+///
+/// When an equation needs more than one block, the next reset replaces
+/// the blocks with a single block as large as all of them, so a process
+/// that keeps balancing equations settles on one block and every reset
+/// after that is a pointer assignment.
+
+class Arena {
+    private:
+        /// The Block struct heads each block of memory, which continues
+        /// directly after it.
+
+        struct Block {
+            Block* next;
+            size_t size;
+        };
+
+        /// The Cleanup struct records an array of objects to destroy on
+        /// reset.
+
+        struct Cleanup {
+            void (*destroy)(void* objects, int count);
+            void* objects;
+            int count;
+            Cleanup* next;
+        };
+
+        Block* blocks;
+        char* cursor;
+        char* limit;
+        size_t capacity;
+        Cleanup* cleanups;
+
+        /// Adds a block large enough for an allocation.
+        ///
+        /// @param bytes the size of the allocation
+        /// @param alignment the alignment of the allocation
+
+        void grow(size_t bytes, size_t alignment);
+
+        /// Destroys an array of objects made by create().
+        ///
+        /// @tparam T the type of the objects
+        /// @param objects the array
+        /// @param count the number of objects
+
+        template <typename T>
+        static void destroy(void* objects, int count);
+
+    public:
+        /// Constructor for the Arena class.
+        ///
+        /// @param capacity the size of the first block in bytes
+
+        Arena(size_t capacity = ARENA_BLOCK);
+
+        /// Destructor for the Arena class.
+
+        ~Arena();
+
+        Arena(const Arena& copy) = delete;
+        Arena& operator=(const Arena& copy) = delete;
+
+        /// Allocates memory from the arena.
+        ///
+        /// @param bytes the size of the allocation
+        /// @param alignment the alignment of the allocation, a power of two
+        /// @return the memory, valid until the next reset
+
+        void* allocate(size_t bytes, size_t alignment = alignof(max_align_t));
+
+        /// Allocates an uninitialized array from the arena.
+        ///
+        /// @tparam T the type of the elements
+        /// @param count the number of elements
+        /// @return the array, valid until the next reset
+
+        template <typename T>
+        T* allocate(int count);
+
+        /// Allocates and default constructs an array of objects that are
+        /// destroyed on the next reset.
+        ///
+        /// @tparam T the type of the objects
+        /// @param count the number of objects
+        /// @return the array, valid until the next reset
+
+        template <typename T>
+        T* create(int count);
+
+        /// Destroys the objects made by create() and takes back every
+        /// allocation.
+
+        void reset();
+
+        /// Returns the number of bytes the arena holds.
+        ///
+        /// @return the total size of the blocks
+
+        size_t getCapacity() const;
+};
+
+/// The ArenaAllocator class lets standard containers allocate from an
+/// arena. Freeing is a no-op, since the arena takes everything back on
+/// reset. Without an arena it falls back to malloc and free.
+///
+/// @tparam T the type of the elements
+
+template <typename T>
+class ArenaAllocator {
+    private:
+        Arena* arena;
+
+        template <typename U>
+        friend class ArenaAllocator;
+
+    public:
+        typedef T value_type;
+
+        /// Constructor for the ArenaAllocator class.
+        ///
+        /// @param arena the arena to allocate from, or NULL for the heap
+
+        ArenaAllocator(Arena* arena = NULL) : arena(arena) {
+        }
+
+        /// Converting constructor for the ArenaAllocator class.
+        ///
+        /// @param other the allocator to share the arena of
+
+        template <typename U>
+        ArenaAllocator(const ArenaAllocator<U>& other) : arena(other.arena) {
+        }
+
+        /// Allocates an array of elements.
+        ///
+        /// @param count the number of elements
+        /// @return the array
+
+        T* allocate(size_t count) {
+            if (arena) return arena->allocate<T>((int) count);
+            T* elements = (T*) malloc(count * sizeof(T));
+            if (!elements) throw std::bad_alloc();
+            return elements;
+        }
+
+        /// Frees an array of elements. The count is part of the allocator
+        /// interface but neither free nor the arena needs it.
+        ///
+        /// @param elements the array
+
+        void deallocate(T* elements, size_t /*count*/) {
+            if (!arena) free(elements);
+        }
+
+        /// Checks whether two allocators can free each other's memory.
+        ///
+        /// @param other the allocator to compare with
+        /// @return whether they share an arena
+
+        template <typename U>
+        bool operator==(const ArenaAllocator<U>& other) const {
+            return arena == other.arena;
+        }
+
+        template <typename U>
+        bool operator!=(const ArenaAllocator<U>& other) const {
+            return arena != other.arena;
+        }
+};
+
+/// Allocates an uninitialized array from the arena.
+
+template <typename T>
+inline T* Arena::allocate(int count) {
+    return (T*) allocate(count * sizeof(T), alignof(T));
+}
+
+/// Destroys an array of objects made by create().
+
+template <typename T>
+void Arena::destroy(void* objects, int count) {
+    T* array = (T*) objects;
+    for (int i = 0; i < count; i++) {
+        array[i].~T();
+    }
+}
+
+/// Allocates and default constructs an array of objects.
+
+template <typename T>
+inline T* Arena::create(int count) {
+    T* objects = allocate<T>(count);
+    for (int i = 0; i < count; i++) {
+        new (&objects[i]) T();
+    }
+
+    if (!std::is_trivially_destructible<T>::value) {
+        Cleanup* cleanup = allocate<Cleanup>(1);
+        cleanup->destroy = destroy<T>;
+        cleanup->objects = objects;
+        cleanup->count = count;
+        cleanup->next = cleanups;
+        cleanups = cleanup;
+    }
+    return objects;
+}
+
+/// Allocates memory from the arena.
+
+inline void* Arena::allocate(size_t bytes, size_t alignment) {
+    char* start = (char*) (((size_t) cursor + alignment - 1) & ~(alignment - 1));
+    if (start + bytes > limit) {
+        grow(bytes, alignment);
+        start = (char*) (((size_t) cursor + alignment - 1) & ~(alignment - 1));
+    }
+    cursor = start + bytes;
+    return start;
+}
+
+#endif
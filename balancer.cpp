@@ -9,15 +9,42 @@
 #include <string.h>
 #include <unistd.h>
 
+#include <thread>
+
 #include "molecule.hpp"
 #include "matrix.hpp"
 #include "solution.hpp"
 #include "equation.hpp"
+#include "network.hpp"
+#include "reader.hpp"
+#include "pool.hpp"
+#include "cache.hpp"
+#include "server.hpp"
+#include "stats.hpp"
+
+#define OUTPUT_BUFFER_SIZE (1 << 16)
+#define LINES_PER_THREAD 64
+#define FORMULA_CAPACITY (1 << 16)
+
+/// The Options struct holds the settings chosen on the command line.
+
+struct Options {
+    bool batch;
+    bool network;
+    char* path;
+    char* socket;
+    int threads;
+    long cache;
+    Engine engine;
+    StatsFormat stats;
+};
 
 /// Prints a usage message.
 
 void usage() {
-    fprintf(stderr, "usage: ./balancer [-h]\n");
+    fprintf(stderr, "usage: ./balancer [-h] [-e engine] [-m format] [-b [-t threads] [-c capacity] [file]]\n");
+    fprintf(stderr, "       ./balancer [-e engine] [-m format] [-t threads] [-c capacity] -s socket\n");
+    fprintf(stderr, "       ./balancer [-e engine] [-m format] -n [file]\n");
 }
 
 /// Prints a message explaining how to enter input.
@@ -25,26 +52,252 @@ void usage() {
 void help() {
     printf("Enter an equation of the form:\n");
     printf("\t_H20 = _H2 + _O2\n");
+    printf("Use -b to balance one equation per line from a file or stdin,\n");
+    printf("and -t to choose how many threads share the work.\n");
+    printf("Use -c to remember the solutions of up to this many equations\n");
+    printf("when balancing a file in which equations repeat.\n");
+    printf("Use -e to choose the elimination engine: sparse (default), bareiss,\n");
+    printf("gauss, or modular for very large equations.\n");
+    printf("Use -n to read one reaction network, one reaction per line, and\n");
+    printf("report its unbalanced reactions and conservation laws.\n");
+    printf("Use -s to serve clients of a Unix domain socket, one equation per\n");
+    printf("line and one result line back per equation, until interrupted.\n");
+    printf("Use -m to write stats as json or prometheus to stderr when done,\n");
+    printf("or on SIGUSR1 when serving. Stats must be compiled in with\n");
+    printf("-DBALANCER_STATS.\n");
+}
+
+/// Parses the name of an elimination engine.
+///
+/// @param name the name given on the command line
+/// @param engine where to store the engine
+/// @return whether or not the name was recognized
+
+bool parseEngine(const char* name, Engine* engine) {
+    if (!strcmp(name, "bareiss")) {
+        *engine = FRACTION_FREE;
+    } else if (!strcmp(name, "gauss")) {
+        *engine = GAUSS_JORDAN;
+    } else if (!strcmp(name, "modular")) {
+        *engine = MODULAR;
+    } else if (!strcmp(name, "sparse")) {
+        *engine = SPARSE;
+    } else {
+        return false;
+    }
+    return true;
 }
 
 /// Processes all command line flags.
 ///
 /// @param argc the number of command line arguments
 /// @param argv the array of command line arguments
+/// @param options the options to fill in
 
-void processFlags(int argc, char** argv) {
+void processFlags(int argc, char** argv, Options* options) {
     int opt;
 
-    while ((opt = getopt(argc, argv, "h")) != -1) {
+    options->batch = false;
+    options->network = false;
+    options->path = NULL;
+    options->socket = NULL;
+    options->threads = std::thread::hardware_concurrency();
+    options->cache = 0;
+    options->engine = SPARSE;
+    options->stats = STATS_NONE;
+
+    while ((opt = getopt(argc, argv, "hbnt:c:e:s:m:")) != -1) {
         switch (opt) {
             case 'h':
                 help();
                 exit(0);
+            case 'b':
+                options->batch = true;
+                break;
+            case 'n':
+                options->network = true;
+                break;
+            case 't':
+                options->threads = atoi(optarg);
+                if (options->threads < 1) {
+                    usage();
+                    exit(1);
+                }
+                break;
+            case 'c':
+                options->cache = atol(optarg);
+                if (options->cache < 1) {
+                    usage();
+                    exit(1);
+                }
+                break;
+            case 's':
+                options->socket = optarg;
+                break;
+            case 'm':
+                if (!strcmp(optarg, "json")) {
+                    options->stats = STATS_JSON;
+                } else if (!strcmp(optarg, "prometheus")) {
+                    options->stats = STATS_PROMETHEUS;
+                } else {
+                    usage();
+                    exit(1);
+                }
+                if (!Stats::getEnabled()) {
+                    fprintf(stderr, "stats were not compiled in; rebuild with -DBALANCER_STATS\n");
+                    exit(1);
+                }
+                break;
+            case 'e':
+                if (!parseEngine(optarg, &options->engine)) {
+                    usage();
+                    exit(1);
+                }
+                break;
             default:
                 usage();
                 exit(1);
         }
     }
+
+    if (options->batch + options->network + (options->socket != NULL) > 1) {
+        usage();
+        exit(1);
+    }
+
+    if (optind < argc) {
+        if (!(options->batch || options->network) || optind + 1 < argc) {
+            usage();
+            exit(1);
+        }
+        options->path = argv[optind];
+    }
+}
+
+/// Removes a trailing newline (and carriage return) from a line.
+///
+/// @param line the line to trim
+/// @param length the length of the line
+/// @return the new length of the line
+
+ssize_t trimLine(char* line, ssize_t length) {
+    while (length > 0 && (line[length - 1] == '\n' || line[length - 1] == '\r')) {
+        line[--length] = 0;
+    }
+    return length;
+}
+
+/// Writes the stats of every thread to stderr.
+///
+/// @param format the format to write them in, or STATS_NONE
+
+void printStats(StatsFormat format) {
+    if (format == STATS_NONE) return;
+    std::string output;
+    Stats::exportAs(format, output);
+    fputs(output.c_str(), stderr);
+}
+
+/// Balances a single equation and prints the result.
+///
+/// @param equation the equation to parse the line into
+/// @param line the equation to balance
+/// @param engine the elimination to balance with
+/// @param cache the cache of earlier solutions, or NULL
+
+void balanceLine(Equation& equation, std::string_view line, Engine engine, ResultCache* cache) {
+    equation.assign(line);
+    Solution solution = equation.balance(engine, cache);
+    equation.printSolution(solution);
+}
+
+/// Balances every line of a stream, printing one result line per
+/// input line. Blank input lines produce blank output lines.
+///
+/// @param input the stream to read equations from
+/// @param options the options chosen on the command line
+
+void balanceStream(FILE* input, Options* options) {
+    FormulaCache formulas(FORMULA_CAPACITY);
+    Equation equation(&formulas);
+    ResultCache* cache = options->cache > 0 ? new ResultCache(options->cache) : NULL;
+    setvbuf(stdout, NULL, _IOFBF, OUTPUT_BUFFER_SIZE);
+
+    if (options->threads > 1) {
+        BatchBalancer balancer(options->threads, options->threads * LINES_PER_THREAD, options->engine, cache,
+                &formulas);
+        balancer.run(input, stdout);
+    } else {
+        LineReader reader(input);
+        std::string_view line;
+        while (reader.next(&line)) {
+            if (line.empty()) {
+                putchar('\n');
+                continue;
+            }
+            balanceLine(equation, line, options->engine, cache);
+        }
+    }
+    fflush(stdout);
+
+    if (cache) {
+        fprintf(stderr, "cache: %ld hits, %ld misses, %ld evictions\n",
+                cache->getHits(), cache->getMisses(), cache->getEvictions());
+        delete cache;
+    }
+    printStats(options->stats);
+}
+
+/// Reads a reaction network from a stream, one reaction per line, and
+/// prints a report on it. Lines that are not reactions of the network
+/// are reported first.
+///
+/// @param input the stream to read reactions from
+/// @param options the options chosen on the command line
+
+void analyzeNetwork(FILE* input, Options* options) {
+    FormulaCache formulas(FORMULA_CAPACITY);
+    Network network(&formulas, options->engine);
+    LineReader reader(input);
+    std::string output;
+    std::string_view line;
+    int number = 0;
+
+    while (reader.next(&line)) {
+        number++;
+        if (line.empty()) continue;
+        Status status = network.addReaction(line, number);
+        if (status != SOLVED) {
+            output += "line " + std::to_string(number) + ": ";
+            appendStatus(status, output);
+        }
+    }
+
+    network.formatReport(output);
+    fwrite(output.data(), 1, output.size(), stdout);
+    printStats(options->stats);
+}
+
+/// Serves clients of a Unix domain socket until interrupted, keeping the
+/// caches warm between requests.
+///
+/// @param options the options chosen on the command line
+/// @return whether or not the socket could be set up
+
+bool serve(Options* options) {
+    FormulaCache formulas(FORMULA_CAPACITY);
+    ResultCache* cache = options->cache > 0 ? new ResultCache(options->cache) : NULL;
+    Server server(options->socket, options->threads, options->engine, cache, &formulas,
+            options->stats == STATS_NONE ? STATS_JSON : options->stats);
+    bool served = server.run();
+
+    if (cache) {
+        fprintf(stderr, "cache: %ld hits, %ld misses, %ld evictions\n",
+                cache->getHits(), cache->getMisses(), cache->getEvictions());
+        delete cache;
+    }
+    printStats(options->stats);
+    return served;
 }
 
 /// The main function...
@@ -55,21 +308,42 @@ void processFlags(int argc, char** argv) {
 
 int main(int argc, char** argv) {
     /// process command line flags
-    processFlags(argc, argv);
+    Options options;
+    processFlags(argc, argv, &options);
+
+    if (options.socket) {
+        return serve(&options) ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    if (options.batch || options.network) {
+        FILE* input = stdin;
+        if (options.path) {
+            input = fopen(options.path, "r");
+            if (!input) {
+                perror(options.path);
+                return EXIT_FAILURE;
+            }
+        }
+        if (options.network) {
+            analyzeNetwork(input, &options);
+        } else {
+            balanceStream(input, &options);
+        }
+        if (input != stdin) fclose(input);
+        return EXIT_SUCCESS;
+    }
 
     /// get input
     printf("Enter an equation to balance:\n");
-    char string[256];
-    fgets(string, sizeof(string), stdin);
- 
-    /// create a matrix from the equation
-    Equation equation(string);
-    Matrix matrix = equation.createMatrixFromEquation();
-
-    /// balance the equation
-    matrix.reduce();
-    Solution solution = matrix.solve();
-    equation.printSolution(solution);
+    char* line = NULL;
+    size_t capacity = 0;
+    ssize_t length = getline(&line, &capacity, stdin);
+    if (length == -1) return EXIT_FAILURE;
+    trimLine(line, length);
+
+    Equation equation;
+    balanceLine(equation, line, options.engine, NULL);
+    free(line);
 
     return 0;
 }
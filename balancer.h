@@ -0,0 +1,123 @@
+/*
+ * file: balancer.h
+ * C interface to the equation balancer library. Every call is reentrant;
+ * threads that balance at the same time each need their own result.
+ *
+ * @author Dominick Banasik
+ */
+
+#ifndef _BALANCER_H_
+#define _BALANCER_H_
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* The statuses a result may have, matching the Status enum. */
+
+#define BALANCER_BALANCED 0
+#define BALANCER_UNBALANCED 1
+#define BALANCER_SOLVED 2
+#define BALANCER_UNSOLVED 3
+#define BALANCER_OVERFLOWED 4
+#define BALANCER_INVALID 5
+
+/* The result of balancing one equation. */
+
+typedef struct balancer_result balancer_result;
+
+/*
+ * Creates an empty result.
+ *
+ * @return the result, or NULL if out of memory
+ */
+
+balancer_result* balancer_result_create(void);
+
+/*
+ * Frees a result.
+ *
+ * @param result the result to free
+ */
+
+void balancer_result_free(balancer_result* result);
+
+/*
+ * Balances an equation into a result, replacing what it held.
+ *
+ * @param result the result to fill
+ * @param equation the equation to balance, which need not end in a NUL
+ * @param length the number of bytes in the equation
+ * @return the status of the solution, or -1 if out of memory
+ */
+
+int balancer_balance(balancer_result* result, const char* equation, size_t length);
+
+/*
+ * Returns the number of molecules in the equation, reactants first.
+ *
+ * @param result the result
+ * @return the number of molecules
+ */
+
+int balancer_result_count(balancer_result* result);
+
+/*
+ * Returns the number of reactants in the equation.
+ *
+ * @param result the result
+ * @return the number of reactants
+ */
+
+int balancer_result_reactants(balancer_result* result);
+
+/*
+ * Returns the coefficient of a molecule as a fraction, whose denominator
+ * is 1 unless fixed coefficients force a fraction.
+ *
+ * @param result the result
+ * @param index the index of the molecule
+ * @param numerator where to store the numerator
+ * @param denominator where to store the denominator, or NULL
+ * @return 0, or -1 if the equation was not solved or the index is out
+ *         of range
+ */
+
+int balancer_result_coefficient(balancer_result* result, int index, long long* numerator,
+        long long* denominator);
+
+/*
+ * Returns the balanced equation, or the statement of why it could not be
+ * balanced, as the balancer prints it. Valid until the result changes.
+ *
+ * @param result the result
+ * @return the formatted result, ending in a newline
+ */
+
+const char* balancer_result_text(balancer_result* result);
+
+/* The formats stats may be written in. */
+
+#define BALANCER_STATS_JSON 1
+#define BALANCER_STATS_PROMETHEUS 2
+
+/*
+ * Writes the stats of every thread that has balanced. They are empty
+ * unless the library was built with -DBALANCER_STATS.
+ *
+ * @param format BALANCER_STATS_JSON or BALANCER_STATS_PROMETHEUS
+ * @param buffer where to write them, NUL terminated, or NULL
+ * @param size the size of the buffer
+ * @return the length of the stats, which were cut short if it is not
+ *         less than the size
+ */
+
+size_t balancer_stats(int format, char* buffer, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,736 @@
+///
+/// file: benchmark.cpp
+/// Microbenchmarks for the arithmetic and parsing used by the equation
+/// balancer. Build separately from the balancer, for example:
+///
+///     g++ -std=c++17 -O2 -pthread -o benchmark benchmark.cpp arena.cpp cache.cpp composition.cpp
+///         equation.cpp factor.cpp hash.cpp integer.cpp kernels.cpp live.cpp matrix.cpp modular.cpp
+///         molecule.cpp network.cpp rational.cpp reader.cpp solution.cpp stats.cpp team.cpp
+///
+/// @author Dominick Banasik
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "fraction.hpp"
+#include "rational.hpp"
+#include "equation.hpp"
+#include "kernels.hpp"
+#include "live.hpp"
+#include "factor.hpp"
+#include "network.hpp"
+#include "reader.hpp"
+
+#define OPERATIONS 2000000
+#define VALUES 1024
+#define PARSE_BYTES (64 << 20)
+#define ROW_LENGTH 4096
+#define ROW_UPDATES 20000
+#define SYSTEM_SIZE 160
+#define NETWORK_SIZE 1000
+#define LIVE_ELEMENTS 40
+#define LIVE_SPECIES 80
+#define LIVE_EDITS 200
+#define SCENARIO_COMPOUNDS 40
+#define SCENARIO_ELEMENTS 30
+#define SCENARIO_FACTORS 20
+#define SCENARIOS 10000
+#define CONSERVATION_SPECIES 10000
+#define CONSERVATION_REACTIONS 100000
+
+/// The LegacyFraction class is the original int based Fraction, with a
+/// linear time gcd and lcm, kept so the two can be compared.
+
+class LegacyFraction {
+    private:
+        int numerator;
+        int denominator;
+
+        static int gcd(int m, int n) {
+            int g = 1;
+            for (int i = 1; i <= m && i <= n; i++) {
+                if (m % i == 0 && n % i == 0) g = i;
+            }
+            return g;
+        }
+
+        static int lcm(int m, int n) {
+            int l = m > n ? m : n;
+            while (l % m != 0 || l % n != 0) l++;
+            return l;
+        }
+
+        void simplify() {
+            if (numerator == 0) {
+                denominator = 1;
+                return;
+            }
+            int g = gcd(abs(numerator), abs(denominator));
+            if (g > 1) {
+                numerator /= g;
+                denominator /= g;
+            }
+            if (denominator < 0) {
+                numerator *= -1;
+                denominator *= -1;
+            }
+        }
+
+    public:
+        LegacyFraction(int num, int den) : numerator(num), denominator(den) {
+            simplify();
+        }
+
+        int getNum() {
+            return numerator;
+        }
+
+        void multiply(LegacyFraction other) {
+            numerator *= other.numerator;
+            denominator *= other.denominator;
+            simplify();
+        }
+
+        void add(LegacyFraction other) {
+            int lcd = lcm(abs(denominator), abs(other.denominator));
+            numerator = numerator * (lcd / denominator) + other.numerator * (lcd / other.denominator);
+            denominator = lcd;
+            simplify();
+        }
+};
+
+/// Returns a numerator as a machine word for the benchmark checksum.
+///
+/// @param num the numerator
+/// @return the numerator as a machine word
+
+long long checksum(long long num) {
+    return num;
+}
+
+/// Returns a numerator as a machine word for the benchmark checksum.
+///
+/// @param num the numerator
+/// @return the numerator as a machine word
+
+long long checksum(const Integer& num) {
+    return num.toLong();
+}
+
+/// Fills arrays with random numerators and denominators.
+///
+/// @param nums the numerators to fill
+/// @param dens the denominators to fill
+/// @param limit the largest magnitude to generate
+
+void fillValues(int* nums, int* dens, int limit) {
+    for (int i = 0; i < VALUES; i++) {
+        nums[i] = rand() % (2 * limit + 1) - limit;
+        dens[i] = rand() % limit + 1;
+    }
+}
+
+/// Times a benchmark and prints the latency of each operation.
+///
+/// @param name the name of the benchmark
+/// @param operations the number of operations the benchmark performs
+/// @param body the benchmark to run
+
+template <typename Body>
+void measure(const char* name, long operations, Body body) {
+    auto start = std::chrono::steady_clock::now();
+    long long sink = body();
+    auto end = std::chrono::steady_clock::now();
+    double ns = std::chrono::duration<double, std::nano>(end - start).count();
+    printf("%-32s %10.2f ns/op  (checksum %lld)\n", name, ns / operations, sink);
+}
+
+/// Runs the add, multiply and construct benchmarks for one kind of fraction.
+///
+/// @param label the kind of fraction being measured
+/// @param nums the numerators to use
+/// @param dens the denominators to use
+/// @param operations the number of operations to perform
+
+template <typename T>
+void runFraction(const char* label, int* nums, int* dens, long operations) {
+    char name[64];
+
+    snprintf(name, sizeof(name), "%s construct", label);
+    measure(name, operations, [&] {
+        long long sink = 0;
+        for (long i = 0; i < operations; i++) {
+            T f(nums[i % VALUES], dens[(i * 7) % VALUES]);
+            sink += checksum(f.getNum());
+        }
+        return sink;
+    });
+
+    snprintf(name, sizeof(name), "%s add", label);
+    measure(name, operations, [&] {
+        long long sink = 0;
+        for (long i = 0; i < operations; i++) {
+            T f(nums[i % VALUES], dens[(i * 7) % VALUES]);
+            f.add(T(nums[(i * 3) % VALUES], dens[(i * 5) % VALUES]));
+            sink += checksum(f.getNum());
+        }
+        return sink;
+    });
+
+    snprintf(name, sizeof(name), "%s multiply", label);
+    measure(name, operations, [&] {
+        long long sink = 0;
+        for (long i = 0; i < operations; i++) {
+            T f(nums[i % VALUES], dens[(i * 7) % VALUES]);
+            f.multiply(T(nums[(i * 3) % VALUES], dens[(i * 5) % VALUES]));
+            sink += checksum(f.getNum());
+        }
+        return sink;
+    });
+}
+
+/// Runs a chain of multiply-adds on one kind of fraction, as a row update
+/// or back substitution does, reading the value only at the end of each
+/// chain. This is where lazy normalization saves the most.
+///
+/// @param label the kind of fraction being measured
+/// @param nums the numerators to use
+/// @param dens the denominators to use
+/// @param length the number of multiply-adds in each chain
+/// @param operations the number of multiply-adds to perform
+
+template <typename T>
+void runChain(const char* label, int* nums, int* dens, int length, long operations) {
+    char name[64];
+    snprintf(name, sizeof(name), "%s chain of %d", label, length);
+    measure(name, operations, [&] {
+        long long sink = 0;
+        for (long i = 0; i < operations; i += length) {
+            T f(nums[i % VALUES], dens[(i * 7) % VALUES]);
+            for (int k = 0; k < length; k++) {
+                long j = i + k;
+                f.multiply(T(nums[(j * 3) % VALUES], dens[(j * 5) % VALUES]));
+                f.add(T(nums[(j * 11) % VALUES], dens[(j * 13) % VALUES]));
+            }
+            sink += checksum(f.getNum());
+        }
+        return sink;
+    });
+}
+
+/// Builds a formula nested a number of groups deep, such as a polymer
+/// chain or a layered mineral.
+///
+/// @param depth the number of nested groups
+/// @param formula the string to append to
+
+void nestFormula(int depth, std::string& formula) {
+    for (int i = 0; i < depth; i++) {
+        formula += '(';
+    }
+    formula += "CH2";
+    for (int i = 0; i < depth; i++) {
+        formula += "O)";
+        formula += std::to_string(i % 3 + 2);
+    }
+}
+
+/// Times how fast equations are parsed, in megabytes of input per second.
+///
+/// @param name the name of the benchmark
+/// @param line the equation to parse over and over
+/// @param formulas the cache of parsed formulas, or NULL
+
+void measureParse(const char* name, const std::string& line, FormulaCache* formulas) {
+    Equation equation(formulas);
+    long repeats = PARSE_BYTES / line.size() + 1;
+    long long sink = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    for (long i = 0; i < repeats; i++) {
+        equation.assign(line);
+        sink += equation.getAtoms()[0];
+    }
+    auto end = std::chrono::steady_clock::now();
+    double seconds = std::chrono::duration<double>(end - start).count();
+    printf("%-32s %10.2f MB/s   (checksum %lld)\n", name, repeats * line.size() / seconds / 1e6, sink);
+}
+
+/// Runs the parse benchmarks on common, mineral and deeply nested
+/// equations.
+
+void runParse() {
+    std::string nested = "_";
+    nestFormula(64, nested);
+    nested += " + _O2 = _CO2 + _H2O";
+
+    std::string combustion = "_C6H12O6 + _O2 = _CO2 + _H2O";
+    std::string minerals = "_Ca5(PO4)3(OH) + _H3PO4 + _H2O = _Ca(H2PO4)2(H2O)";
+    FormulaCache formulas(VALUES);
+
+    printf("parsing\n");
+    measureParse("parse combustion", combustion, NULL);
+    measureParse("parse minerals", minerals, NULL);
+    measureParse("parse nested", nested, NULL);
+    measureParse("parse combustion, cached", combustion, &formulas);
+    measureParse("parse minerals, cached", minerals, &formulas);
+    measureParse("parse nested, cached", nested, &formulas);
+}
+
+/// Times how fast the lines of a file are read, in megabytes per second.
+///
+/// @param name the name of the benchmark
+/// @param bytes the size of the file
+/// @param body the benchmark to run, returning a checksum
+
+template <typename Body>
+void measureRead(const char* name, long bytes, Body body) {
+    auto start = std::chrono::steady_clock::now();
+    long long sink = body();
+    auto end = std::chrono::steady_clock::now();
+    double seconds = std::chrono::duration<double>(end - start).count();
+    printf("%-32s %10.2f MB/s   (checksum %lld)\n", name, bytes / seconds / 1e6, sink);
+}
+
+/// Times reading a large file of equations line by line with getline
+/// against reading it through a mapping, with each level of kernel.
+
+void runLines() {
+    const char* equations[] = {
+        "_C6H12O6 + _O2 = _CO2 + _H2O\n",
+        "_Ca5(PO4)3(OH) + _H3PO4 + _H2O = _Ca(H2PO4)2(H2O)\n",
+        "\n",
+        "_K4Fe(CN)6 + _KMnO4 + _H2SO4 = _KHSO4 + _Fe2(SO4)3 + _MnSO4 + _HNO3 + _CO2 + _H2O\n"
+    };
+    FILE* file = tmpfile();
+    if (!file) return;
+    long bytes = 0;
+    for (int i = 0; bytes < PARSE_BYTES; i++) {
+        bytes += fputs(equations[i % 4], file) >= 0 ? strlen(equations[i % 4]) : 0;
+    }
+    fflush(file);
+
+    printf("reading lines\n");
+    measureRead("getline", bytes, [&] {
+        rewind(file);
+        char* line = NULL;
+        size_t capacity = 0;
+        long long sink = 0;
+        while (getline(&line, &capacity, file) != -1) {
+            sink++;
+        }
+        free(line);
+        return sink;
+    });
+    KernelLevel supported = Kernels::getSupported();
+    for (int level = KERNEL_SCALAR; level <= supported; level++) {
+        char name[64];
+        snprintf(name, sizeof(name), "mapped, %s", Kernels::getName(Kernels::setLevel((KernelLevel) level)));
+        measureRead(name, bytes, [&] {
+            rewind(file);
+            LineReader reader(file);
+            std::string_view line;
+            long long sink = 0;
+            while (reader.next(&line)) {
+                sink++;
+            }
+            return sink;
+        });
+    }
+    Kernels::setLevel(supported);
+    fclose(file);
+}
+
+/// Times how fast a row kernel updates cells, in nanoseconds per cell.
+///
+/// @param name the name of the benchmark
+/// @param body the benchmark to run, given the number of the update
+
+template <typename Body>
+void measureRow(const char* name, Body body) {
+    auto start = std::chrono::steady_clock::now();
+    for (long i = 0; i < ROW_UPDATES; i++) {
+        body(i);
+    }
+    auto end = std::chrono::steady_clock::now();
+    double ns = std::chrono::duration<double, std::nano>(end - start).count();
+    printf("%-32s %10.3f ns/cell\n", name, ns / ((double) ROW_UPDATES * ROW_LENGTH));
+}
+
+/// Runs the row kernels and a modular elimination of a dense system at
+/// every level the CPU supports, so the vector kernels can be compared
+/// with the scalar ones on the same machine.
+
+void runKernels() {
+    unsigned int* residues = new unsigned int[ROW_LENGTH];
+    unsigned int* source = new unsigned int[ROW_LENGTH];
+    int* cells = new int[ROW_LENGTH];
+    int* pivotCells = new int[ROW_LENGTH];
+    short* shorts = new short[ROW_LENGTH];
+    short* pivotShorts = new short[ROW_LENGTH];
+    unsigned int prime = 2147483629U;
+
+    Integer* system = new Integer[SYSTEM_SIZE * (SYSTEM_SIZE + 1)];
+    for (int i = 0; i < SYSTEM_SIZE * (SYSTEM_SIZE + 1); i++) {
+        system[i] = (long long) (rand() % 10);
+    }
+
+    printf("row kernels, %d cells\n", ROW_LENGTH);
+    for (int level = KERNEL_SCALAR; level <= Kernels::getSupported(); level++) {
+        Kernels::setLevel((KernelLevel) level);
+        const char* label = Kernels::getName((KernelLevel) level);
+        char name[64];
+
+        for (int j = 0; j < ROW_LENGTH; j++) {
+            residues[j] = (unsigned int) rand() % prime;
+            source[j] = (unsigned int) rand() % prime;
+            cells[j] = rand() % 2001 - 1000;
+            pivotCells[j] = rand() % 2001 - 1000;
+            shorts[j] = (short) (rand() % 201 - 100);
+            pivotShorts[j] = (short) (rand() % 201 - 100);
+        }
+
+        // Each update is undone by the next, pivot 1 over a previous
+        // pivot of 1, so the cells stay in range however long it runs.
+        snprintf(name, sizeof(name), "%s modular axpy", label);
+        measureRow(name, [&](long i) {
+            Kernels::addScaledMod(residues, source, ROW_LENGTH, i % 2 ? prime - 12345 : 12345, prime);
+        });
+        snprintf(name, sizeof(name), "%s bareiss 32-bit", label);
+        measureRow(name, [&](long i) {
+            Kernels::bareissRow(cells, pivotCells, ROW_LENGTH, 1, i % 2 ? -3 : 3, 1);
+        });
+        snprintf(name, sizeof(name), "%s bareiss 16-bit", label);
+        measureRow(name, [&](long i) {
+            Kernels::bareissRow(shorts, pivotShorts, ROW_LENGTH, (short) 1, (short) (i % 2 ? -3 : 3), (short) 1);
+        });
+
+        snprintf(name, sizeof(name), "%s modular rref %dx%d", label, SYSTEM_SIZE, SYSTEM_SIZE + 1);
+        measure(name, 1, [&] {
+            ModularReducer reducer(system, SYSTEM_SIZE, SYSTEM_SIZE + 1);
+            reducer.reduce();
+            return (long long) reducer.getRank();
+        });
+    }
+    Kernels::setLevel(Kernels::getSupported());
+
+    delete[] system;
+    delete[] pivotShorts;
+    delete[] shorts;
+    delete[] pivotCells;
+    delete[] cells;
+    delete[] source;
+    delete[] residues;
+}
+
+/// Runs a modular elimination of a system the size of a reaction network
+/// on one thread and then on more, up to one per core. The system is
+/// [B | BX] for a sparse B with a heavy diagonal and a dense X of small
+/// values, so its rref is [I | X] and a single prime is enough.
+
+void runNetwork() {
+    int n = NETWORK_SIZE;
+    int* sparse = new int[n * n];
+    int* dense = new int[n * n];
+    for (int i = 0; i < n * n; i++) {
+        sparse[i] = rand() % 8 == 0 ? rand() % 5 - 2 : 0;
+        dense[i] = rand() % 7 - 3;
+    }
+    for (int i = 0; i < n; i++) {
+        sparse[i * n + i] = rand() % 3 + 1;
+    }
+
+    Integer* system = new Integer[n * 2 * n];
+    for (int i = 0; i < n; i++) {
+        for (int j = 0; j < n; j++) {
+            long long sum = 0;
+            for (int k = 0; k < n; k++) {
+                sum += (long long) sparse[i * n + k] * dense[k * n + j];
+            }
+            system[i * 2 * n + j] = (long long) sparse[i * n + j];
+            system[i * 2 * n + n + j] = sum;
+        }
+    }
+
+    printf("modular rref %dx%d\n", n, 2 * n);
+    int cores = std::thread::hardware_concurrency();
+    for (int threads = 1; threads == 1 || threads <= cores; threads *= 2) {
+        char name[64];
+        snprintf(name, sizeof(name), "%d thread%s", threads, threads > 1 ? "s" : "");
+        ModularReducer::setThreadCount(threads);
+        measure(name, 1, [&] {
+            ModularReducer reducer(system, n, 2 * n);
+            reducer.reduce();
+            return (long long) reducer.getRank();
+        });
+    }
+    ModularReducer::setThreadCount(0);
+
+    delete[] system;
+    delete[] dense;
+    delete[] sparse;
+}
+
+/// Builds a large equation in which every molecule holds two of the
+/// elements, like the species of a reaction network.
+///
+/// @param species the number of molecules, half of them reactants
+/// @param elements the number of elements to choose from
+/// @param fixedEvery how often a molecule is fixed rather than free
+/// @return the equation
+
+std::string makeNetwork(int species, int elements, int fixedEvery) {
+    std::string line;
+    for (int i = 0; i < species; i++) {
+        if (i == species / 2) {
+            line += " = ";
+        } else if (i > 0) {
+            line += " + ";
+        }
+        if (i % fixedEvery != fixedEvery - 1) line += '_';
+        line += PeriodicTable::symbol(rand() % elements + 1);
+        line += std::to_string(rand() % 3 + 1);
+        line += PeriodicTable::symbol(rand() % elements + 1);
+    }
+    return line;
+}
+
+/// Times edits to a large equation made through a live equation against
+/// rebuilding and balancing the equation after each one.
+
+void runLive() {
+    std::string line = makeNetwork(LIVE_SPECIES, LIVE_ELEMENTS, LIVE_SPECIES + 1);
+    LiveEquation live;
+    Equation equation;
+    live.assign(line);
+    printf("edits to %d species of %d elements, rank %d\n", LIVE_SPECIES, LIVE_ELEMENTS, live.getRank());
+
+    measure("live add and remove", 2 * LIVE_EDITS, [&] {
+        long long sink = 0;
+        for (int i = 0; i < LIVE_EDITS; i++) {
+            std::string formula = "_";
+            formula += PeriodicTable::symbol(i % LIVE_ELEMENTS + 1);
+            formula += PeriodicTable::symbol((i * 7) % LIVE_ELEMENTS + 1);
+            live.removeMolecule(live.addMolecule(formula, i % 2));
+            sink += live.getRank();
+        }
+        return sink;
+    });
+    measure("live fix and free", 2 * LIVE_EDITS, [&] {
+        long long sink = 0;
+        for (int i = 0; i < LIVE_EDITS; i++) {
+            int index = (i * 13) % LIVE_SPECIES;
+            live.fixCoefficient(index, i % 3 + 1);
+            live.freeCoefficient(index);
+            sink += live.getRank();
+        }
+        return sink;
+    });
+    measure("live balance", LIVE_EDITS, [&] {
+        long long sink = 0;
+        for (int i = 0; i < LIVE_EDITS; i++) {
+            sink += live.balance().getStatus();
+        }
+        return sink;
+    });
+    measure("rebuild and balance", LIVE_EDITS / 10, [&] {
+        long long sink = 0;
+        for (int i = 0; i < LIVE_EDITS / 10; i++) {
+            equation.assign(line);
+            sink += equation.balance(GAUSS_JORDAN).getStatus();
+        }
+        return sink;
+    });
+}
+
+/// Builds the decomposition of fixed compounds into free elements. Every
+/// element is in some compound, so the fixed coefficients determine the
+/// free ones.
+///
+/// @param compounds the number of compounds, at least the elements
+/// @param elements the number of elements
+/// @return the equation
+
+std::string makeDecomposition(int compounds, int elements) {
+    std::string line;
+    for (int i = 0; i < compounds; i++) {
+        if (i > 0) line += " + ";
+        line += PeriodicTable::symbol(i % elements + 1);
+        line += PeriodicTable::symbol(rand() % elements + 1);
+        line += std::to_string(rand() % 3 + 1);
+        line += PeriodicTable::symbol(rand() % elements + 1);
+    }
+    line += " = ";
+    for (int i = 0; i < elements; i++) {
+        if (i > 0) line += " + ";
+        line += '_';
+        line += PeriodicTable::symbol(i + 1);
+        line += '2';
+    }
+    return line;
+}
+
+/// Times balancing one equation for many choices of its fixed
+/// coefficients from a single factorization against balancing each
+/// choice from scratch.
+
+void runScenarios() {
+    std::string line = makeDecomposition(SCENARIO_COMPOUNDS, SCENARIO_ELEMENTS);
+    Equation equation;
+    equation.assign(line);
+    Factorization factorization(equation);
+    int fixedCount = factorization.getFixedCount();
+    long long* coefficients = new long long[(long) SCENARIOS * fixedCount];
+    for (long i = 0; i < (long) SCENARIOS * fixedCount; i++) {
+        coefficients[i] = rand() % 9 + 1;
+    }
+    printf("scenarios of %d compounds of %d elements\n", SCENARIO_COMPOUNDS, SCENARIO_ELEMENTS);
+
+    measure("factor", SCENARIO_FACTORS, [&] {
+        long long sink = 0;
+        for (int i = 0; i < SCENARIO_FACTORS; i++) {
+            Factorization again(equation);
+            sink += again.getRank();
+        }
+        return sink;
+    });
+    measure("scenario from factorization", SCENARIOS, [&] {
+        long long sink = 0;
+        factorization.solveAll(coefficients, SCENARIOS, [&](int /*index*/, Solution solution) {
+            sink += solution.getStatus();
+        });
+        return sink;
+    });
+
+    // Writing the coefficients into the equation makes the same scenarios
+    // for Equation::balance.
+    int rebuilt = SCENARIOS / 100;
+    measure("scenario from scratch", rebuilt, [&] {
+        long long sink = 0;
+        std::string scenario;
+        for (int i = 0; i < rebuilt; i++) {
+            scenario.clear();
+            int fixed = 0;
+            for (size_t start = 0; start < line.size();) {
+                size_t end = line.find_first_of("+=", start);
+                if (end == std::string::npos) end = line.size();
+                size_t text = line.find_first_not_of(' ', start);
+                if (line[text] != '_') scenario += std::to_string(coefficients[(long) i * fixedCount + fixed++]);
+                scenario.append(line, text, end - text);
+                if (end < line.size()) scenario += line[end];
+                start = end + 1;
+            }
+            equation.assign(scenario);
+            sink += equation.balance(FRACTION_FREE).getStatus();
+        }
+        return sink;
+    });
+    delete[] coefficients;
+}
+
+/// Builds the reactions of a network over compounds of the elements. Each
+/// compound forms from two simpler species, and the other reactions trade
+/// the parts of one compound for another, so every reaction is balanced
+/// and the elements are all the network conserves.
+///
+/// @param species the number of species, at least the elements
+/// @param reactions the number of reactions, at least the compounds
+/// @param elements the number of elements
+/// @return the reactions
+
+std::vector<std::string> makeReactions(int species, int reactions, int elements) {
+    std::vector<std::string> names;
+    std::vector<int> parts;
+    for (int i = 0; i < elements; i++) {
+        names.push_back(std::string(PeriodicTable::symbol(i + 1)) + "2");
+        parts.push_back(-1);
+        parts.push_back(-1);
+    }
+    while ((int) names.size() < species) {
+        int simpler = std::min((int) names.size(), 4 * elements);
+        int a = rand() % simpler;
+        int b = rand() % simpler;
+        names.push_back(names[a] + names[b]);
+        parts.push_back(a);
+        parts.push_back(b);
+    }
+
+    std::vector<std::string> lines;
+    for (int i = elements; i < species; i++) {
+        lines.push_back(names[parts[2 * i]] + " + " + names[parts[2 * i + 1]] + " = " + names[i]);
+    }
+    while ((int) lines.size() < reactions) {
+        int first = elements + rand() % (species - elements);
+        int second = elements + rand() % (species - elements);
+        std::string k = std::to_string(rand() % 3 + 1);
+        std::string m = std::to_string(rand() % 3 + 1);
+        lines.push_back(k + names[first] + " + " + m + names[parts[2 * second]] + " + " + m
+                + names[parts[2 * second + 1]] + " = " + m + names[second] + " + " + k + names[parts[2 * first]]
+                + " + " + k + names[parts[2 * first + 1]]);
+    }
+    return lines;
+}
+
+/// Times reading a large reaction network and finding its conservation
+/// laws.
+
+void runConservation() {
+    std::vector<std::string> lines = makeReactions(CONSERVATION_SPECIES, CONSERVATION_REACTIONS,
+            SCENARIO_ELEMENTS);
+    FormulaCache formulas(1 << 16);
+    Network network(&formulas);
+    printf("network of %d reactions\n", (int) lines.size());
+
+    measure("add reaction", (long) lines.size(), [&] {
+        long long sink = 0;
+        for (size_t i = 0; i < lines.size(); i++) {
+            sink += network.addReaction(lines[i], (int) i + 1);
+        }
+        return sink;
+    });
+    measure("conservation laws", 1, [&] {
+        return (long long) network.getLawCount();
+    });
+}
+
+/// The main function runs every benchmark for small and large values.
+///
+/// @return EXIT_SUCCESS
+
+int main() {
+    int nums[VALUES];
+    int dens[VALUES];
+
+    srand(1);
+    fillValues(nums, dens, 100);
+    printf("values up to 100\n");
+    runFraction<LegacyFraction>("legacy", nums, dens, OPERATIONS / 100);
+    runFraction<Fraction>("fraction", nums, dens, OPERATIONS);
+    runFraction<Rational>("rational", nums, dens, OPERATIONS);
+    runChain<Fraction>("fraction", nums, dens, 2, OPERATIONS);
+    runChain<Fraction>("fraction", nums, dens, 4, OPERATIONS);
+
+    fillValues(nums, dens, 10000);
+    printf("values up to 10000\n");
+    runFraction<LegacyFraction>("legacy", nums, dens, OPERATIONS / 100000);
+    runFraction<Fraction>("fraction", nums, dens, OPERATIONS);
+    runFraction<Rational>("rational", nums, dens, OPERATIONS);
+    runChain<Fraction>("fraction", nums, dens, 2, OPERATIONS);
+
+    runParse();
+    runLines();
+    runKernels();
+    runNetwork();
+    runLive();
+    runScenarios();
+    runConservation();
+
+    return EXIT_SUCCESS;
+}
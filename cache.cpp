@@ -0,0 +1,179 @@
+///
+/// file: cache.cpp
+/// Implementation for the ResultCache and FormulaCache classes
+///
+/// @author Dominick Banasik
+
+#include <ctype.h>
+
+#include <functional>
+
+#include "cache.hpp"
+
+#ifndef _CACHE_IMPL_
+#define _CACHE_IMPL_
+
+/// Looks up the solution of an equation.
+
+bool ResultCache::find(std::string_view key, std::string_view order, Solution& solution) {
+    std::lock_guard<std::mutex> guard(lock);
+    auto found = index.find(key);
+    if (found == index.end() || (!found->second->unique && found->second->order != order)) {
+        misses++;
+        return false;
+    }
+
+    hits++;
+    entries.splice(entries.begin(), entries, found->second);
+    const Entry& entry = *found->second;
+    solution.setStatus(entry.status);
+    solution.setUnique(entry.unique);
+    for (size_t i = 0; i < entry.values.size(); i++) {
+        solution.setValue(entry.values[i], i);
+    }
+    return true;
+}
+
+/// Adds the solution of an equation.
+
+void ResultCache::insert(std::string_view key, std::string_view order, Solution& solution, int size) {
+    if (capacity == 0) return;
+
+    std::lock_guard<std::mutex> guard(lock);
+    auto found = index.find(key);
+    if (found != index.end()) {
+        entries.splice(entries.begin(), entries, found->second);
+        if (found->second->unique) return;
+    } else {
+        if (entries.size() == capacity) {
+            index.erase(entries.back().key);
+            entries.pop_back();
+            evictions++;
+        }
+        entries.emplace_front();
+        entries.front().key = key;
+        index.emplace(entries.front().key, entries.begin());
+    }
+
+    Entry& entry = entries.front();
+    entry.order = order;
+    entry.status = solution.getStatus();
+    entry.unique = solution.getUnique();
+    entry.values.clear();
+    entry.values.reserve(size);
+    for (int i = 0; i < size; i++) {
+        entry.values.push_back(solution.getValue(i));
+    }
+}
+
+/// Returns the number of lookups that found a solution.
+
+long ResultCache::getHits() {
+    std::lock_guard<std::mutex> guard(lock);
+    return hits;
+}
+
+/// Returns the number of lookups that found nothing.
+
+long ResultCache::getMisses() {
+    std::lock_guard<std::mutex> guard(lock);
+    return misses;
+}
+
+/// Returns the number of solutions evicted to make room.
+
+long ResultCache::getEvictions() {
+    std::lock_guard<std::mutex> guard(lock);
+    return evictions;
+}
+
+/// Returns the number of solutions in the cache.
+
+size_t ResultCache::getSize() {
+    std::lock_guard<std::mutex> guard(lock);
+    return entries.size();
+}
+
+/// Constructor for the ResultCache class.
+
+ResultCache::ResultCache(size_t capacity) {
+    this->capacity = capacity;
+    hits = 0;
+    misses = 0;
+    evictions = 0;
+    index.reserve(capacity);
+}
+
+/// Removes the spaces around a formula and the '_' that frees its
+/// coefficient.
+
+std::string_view FormulaCache::trim(std::string_view formula) {
+    size_t start = 0;
+    size_t end = formula.size();
+    while (start < end && (formula[start] == '_' || isspace((unsigned char) formula[start]))) start++;
+    while (end > start && isspace((unsigned char) formula[end - 1])) end--;
+    return formula.substr(start, end - start);
+}
+
+/// Returns the shard a formula belongs to.
+
+FormulaCache::Shard& FormulaCache::shardOf(std::string_view formula) {
+    size_t hash = std::hash<std::string_view>()(formula);
+    return shards[(hash >> 16) % FORMULA_SHARDS];
+}
+
+/// Looks up the composition of a formula.
+
+const Composition* FormulaCache::find(std::string_view formula, bool* valid) {
+    formula = trim(formula);
+    Shard& shard = shardOf(formula);
+    std::shared_lock<std::shared_mutex> guard(shard.lock);
+    auto found = shard.entries.find(formula);
+    if (found == shard.entries.end()) return NULL;
+    *valid = found->second->valid;
+    return &found->second->composition;
+}
+
+/// Adds the composition of a formula.
+
+const Composition* FormulaCache::insert(std::string_view formula, const Composition& composition, bool valid) {
+    if (size.load() >= capacity) return NULL;
+    formula = trim(formula);
+    Shard& shard = shardOf(formula);
+    std::unique_lock<std::shared_mutex> guard(shard.lock);
+    if (shard.entries.count(formula)) return NULL;
+
+    Entry* entry = new Entry;
+    entry->formula = formula;
+    entry->composition = composition;
+    entry->valid = valid;
+    shard.entries.emplace(entry->formula, entry);
+    size++;
+    return &entry->composition;
+}
+
+/// Returns the number of formulas in the cache.
+
+long FormulaCache::getSize() {
+    return size.load();
+}
+
+/// Constructor for the FormulaCache class.
+
+FormulaCache::FormulaCache(long capacity) {
+    this->capacity = capacity;
+    size = 0;
+}
+
+/// Destructor for the FormulaCache class.
+
+FormulaCache::~FormulaCache() {
+    for (int i = 0; i < FORMULA_SHARDS; i++) {
+        for (auto& item : shards[i].entries) {
+            item.second->composition.release();
+            delete item.second;
+        }
+    }
+}
+
+#endif
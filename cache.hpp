@@ -0,0 +1,208 @@
+///
+/// file: cache.hpp
+/// Header file for the ResultCache and FormulaCache classes
+///
+/// @author Dominick Banasik
+
+#ifndef _CACHE_H_
+#define _CACHE_H_
+
+#include <atomic>
+#include <list>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "rational.hpp"
+#include "solution.hpp"
+#include "composition.hpp"
+#include "hash.hpp"
+
+#define FORMULA_SHARDS 16
+
+/// The ResultCache class remembers the solutions of recently balanced
+/// equations, so an equation seen again is answered without building or
+/// reducing its matrix. Equations are looked up by a key describing their
+/// canonical matrix, which Equation builds, and once the cache is full the
+/// least recently used solution is evicted. Every method may be called
+/// from any thread.
+///
+/// A unique solution serves every order of the molecules. Otherwise the
+/// solution depends on the order of the columns, so it only serves
+/// equations whose columns are in the same order.
+
+class ResultCache {
+    private:
+        /// The KeyHash struct buckets keys by their 128-bit hash. Lookups
+        /// still compare the whole key, so equations whose hashes collide
+        /// never share a solution.
+
+        struct KeyHash {
+            size_t operator()(std::string_view key) const {
+                return hashBytes(key.data(), key.size()).low;
+            }
+        };
+
+        /// The Entry struct holds one cached solution.
+
+        struct Entry {
+            std::string key;
+            std::string order;
+            Status status;
+            bool unique;
+            std::vector<Rational> values;
+        };
+
+        std::mutex lock;
+        std::list<Entry> entries;
+        std::unordered_map<std::string_view, std::list<Entry>::iterator, KeyHash> index;
+        size_t capacity;
+        long hits;
+        long misses;
+        long evictions;
+
+    public:
+        /// Constructor for the ResultCache class.
+        ///
+        /// @param capacity the number of solutions to keep
+
+        ResultCache(size_t capacity);
+
+        ResultCache(const ResultCache& copy) = delete;
+        ResultCache& operator=(const ResultCache& copy) = delete;
+
+        /// Looks up the solution of an equation and marks it as the most
+        /// recently used.
+        ///
+        /// @param key the key of the equation
+        /// @param order the key of the order of its columns
+        /// @param solution where to copy the solution, which must have
+        ///                 room for every coefficient
+        /// @return whether the equation was found
+
+        bool find(std::string_view key, std::string_view order, Solution& solution);
+
+        /// Adds the solution of an equation, replacing one for another
+        /// order of its columns, or evicting the least recently used one
+        /// if the cache is full.
+        ///
+        /// @param key the key of the equation
+        /// @param order the key of the order of its columns
+        /// @param solution the solution to copy
+        /// @param size the number of coefficients in the solution
+
+        void insert(std::string_view key, std::string_view order, Solution& solution, int size);
+
+        /// Returns the number of lookups that found a solution.
+        ///
+        /// @return the number of hits
+
+        long getHits();
+
+        /// Returns the number of lookups that found nothing.
+        ///
+        /// @return the number of misses
+
+        long getMisses();
+
+        /// Returns the number of solutions evicted to make room.
+        ///
+        /// @return the number of evictions
+
+        long getEvictions();
+
+        /// Returns the number of solutions in the cache.
+        ///
+        /// @return the number of entries
+
+        size_t getSize();
+};
+
+/// The FormulaCache class maps the formula of each molecule to its
+/// composition, so a formula that appears in many equations is parsed
+/// only once. Compositions in the cache never change, and molecules point
+/// at them instead of keeping a copy. The formulas are spread over shards
+/// with their own locks, so lookups from many threads rarely wait. Once
+/// the cache is full, new formulas are simply not added.
+
+class FormulaCache {
+    private:
+        /// The Entry struct holds the composition of one formula.
+
+        struct Entry {
+            std::string formula;
+            Composition composition;
+            bool valid;
+        };
+
+        /// The Shard struct holds the formulas whose hashes fall in it.
+
+        struct Shard {
+            std::shared_mutex lock;
+            std::unordered_map<std::string_view, Entry*> entries;
+        };
+
+        Shard shards[FORMULA_SHARDS];
+        std::atomic<long> size;
+        long capacity;
+
+        /// Removes the spaces around a formula and the '_' that frees its
+        /// coefficient, which do not change its composition.
+        ///
+        /// @param formula the formula
+        /// @return the part of the formula that is cached
+
+        static std::string_view trim(std::string_view formula);
+
+        /// Returns the shard a formula belongs to.
+        ///
+        /// @param formula the trimmed formula
+        /// @return the shard
+
+        Shard& shardOf(std::string_view formula);
+
+    public:
+        /// Constructor for the FormulaCache class.
+        ///
+        /// @param capacity the number of formulas to keep
+
+        FormulaCache(long capacity);
+
+        /// Destructor for the FormulaCache class.
+
+        ~FormulaCache();
+
+        FormulaCache(const FormulaCache& copy) = delete;
+        FormulaCache& operator=(const FormulaCache& copy) = delete;
+
+        /// Looks up the composition of a formula.
+        ///
+        /// @param formula the formula
+        /// @param valid where to store whether every symbol is an element
+        /// @return the composition, or NULL if the formula is not cached
+
+        const Composition* find(std::string_view formula, bool* valid);
+
+        /// Adds the composition of a formula. The cache takes over any
+        /// memory the composition spilled to the heap, so on success the
+        /// caller must forget its copy without releasing it.
+        ///
+        /// @param formula the formula
+        /// @param composition the composition parsed from the formula
+        /// @param valid whether every symbol is an element
+        /// @return the cached composition, or NULL if the cache is full or
+        ///         another thread added the formula first
+
+        const Composition* insert(std::string_view formula, const Composition& composition, bool valid);
+
+        /// Returns the number of formulas in the cache.
+        ///
+        /// @return the number of entries
+
+        long getSize();
+};
+
+#endif
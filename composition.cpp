@@ -0,0 +1,98 @@
+///
+/// file: composition.cpp
+/// Implementation for the Composition class
+///
+/// @author Dominick Banasik
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "composition.hpp"
+#include "element.hpp"
+
+#ifndef _COMPOSITION_IMPL_
+#define _COMPOSITION_IMPL_
+
+/// Inserts a new pair, spilling to the heap if the inline arrays are full.
+
+void Composition::insert(int position, int element, int count) {
+    if (size == capacity) {
+        capacity *= 2;
+        if (!spillElements) {
+            spillElements = (unsigned char*) malloc(capacity * sizeof(unsigned char));
+            spillCounts = (int*) malloc(capacity * sizeof(int));
+            memcpy(spillElements, inlineElements, size * sizeof(unsigned char));
+            memcpy(spillCounts, inlineCounts, size * sizeof(int));
+        } else {
+            spillElements = (unsigned char*) realloc(spillElements, capacity * sizeof(unsigned char));
+            spillCounts = (int*) realloc(spillCounts, capacity * sizeof(int));
+        }
+    }
+
+    unsigned char* elements = spillElements ? spillElements : inlineElements;
+    int* counts = getCounts();
+    memmove(elements + position + 1, elements + position, (size - position) * sizeof(unsigned char));
+    memmove(counts + position + 1, counts + position, (size - position) * sizeof(int));
+    elements[position] = (unsigned char) element;
+    counts[position] = count;
+    size++;
+}
+
+/// Adds a multiple of another composition by merging the two sorted
+/// lists of pairs. Element IDs are unique, so the merge never holds
+/// more pairs than there are elements. The merge is built on the side,
+/// so a count that overflows leaves the composition as it was.
+
+bool Composition::add(const Composition& other, int multiplier) {
+    unsigned char mergedElements[ELEMENT_COUNT];
+    int mergedCounts[ELEMENT_COUNT];
+    const unsigned char* elements = getElements();
+    const unsigned char* otherElements = other.getElements();
+    const int* counts = getCounts();
+    int a = 0;
+    int b = 0;
+    int merged = 0;
+
+    while (a < size || b < other.size) {
+        if (b == other.size || (a < size && elements[a] < otherElements[b])) {
+            mergedElements[merged] = elements[a];
+            mergedCounts[merged++] = counts[a++];
+        } else if (a == size || otherElements[b] < elements[a]) {
+            mergedElements[merged] = otherElements[b];
+            if (__builtin_mul_overflow(other.getCount(b++), multiplier, &mergedCounts[merged++])) return false;
+        } else {
+            int scaled;
+            mergedElements[merged] = elements[a];
+            if (__builtin_mul_overflow(other.getCount(b++), multiplier, &scaled)
+                    || __builtin_add_overflow(counts[a++], scaled, &mergedCounts[merged++])) {
+                return false;
+            }
+        }
+    }
+
+    if (merged > capacity) {
+        while (capacity < merged) capacity *= 2;
+        free(spillElements);
+        free(spillCounts);
+        spillElements = (unsigned char*) malloc(capacity * sizeof(unsigned char));
+        spillCounts = (int*) malloc(capacity * sizeof(int));
+    }
+    memcpy(spillElements ? spillElements : inlineElements, mergedElements, merged * sizeof(unsigned char));
+    memcpy(getCounts(), mergedCounts, merged * sizeof(int));
+    size = merged;
+    return true;
+}
+
+/// Frees the heap arrays of a spilled composition and empties it.
+
+void Composition::release() {
+    free(spillElements);
+    free(spillCounts);
+    memset(inlineElements, 0, sizeof(inlineElements));
+    spillElements = NULL;
+    spillCounts = NULL;
+    size = 0;
+    capacity = INLINE_ELEMENTS;
+}
+
+#endif
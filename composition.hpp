@@ -0,0 +1,197 @@
+///
+/// file: composition.hpp
+/// Header file for the Composition class
+///
+/// @author Dominick Banasik
+
+#ifndef _COMPOSITION_H_
+#define _COMPOSITION_H_
+
+#define INLINE_ELEMENTS 8
+
+/// The Composition class holds how many atoms of each element a molecule
+/// contains, as (element, count) pairs sorted by element ID. The elements
+/// and counts are kept in separate arrays, and up to eight pairs are
+/// stored inline, so almost every molecule fits in one cache line and
+/// never touches the heap. Larger compositions spill both arrays to the
+/// heap.
+///
+/// A composition is copied bit for bit like the rest of a molecule, so
+/// it has no destructor; whoever owns it calls release().
+
+class Composition {
+    private:
+        unsigned char inlineElements[INLINE_ELEMENTS];
+        int inlineCounts[INLINE_ELEMENTS];
+        unsigned char* spillElements;
+        int* spillCounts;
+        int size;
+        int capacity;
+
+        /// Returns the array of elements.
+        ///
+        /// @return the elements, in increasing order
+
+        const unsigned char* getElements() const;
+
+        /// Returns the array of counts.
+        ///
+        /// @return the counts, in the order of the elements
+
+        int* getCounts();
+
+        /// Inserts a new pair, spilling to the heap if the inline arrays
+        /// are full.
+        ///
+        /// @param position the index to insert at
+        /// @param element the element ID
+        /// @param count the number of atoms
+
+        void insert(int position, int element, int count);
+
+    public:
+        /// Constructor for the Composition class.
+
+        Composition();
+
+        /// Frees the heap arrays of a spilled composition and empties it.
+
+        void release();
+
+        /// Returns the number of different elements.
+        ///
+        /// @return the number of pairs
+
+        int getSize() const;
+
+        /// Returns the element of a pair.
+        ///
+        /// @param index the index of the pair
+        /// @return the element ID
+
+        int getElement(int index) const;
+
+        /// Returns the count of a pair.
+        ///
+        /// @param index the index of the pair
+        /// @return the number of atoms
+
+        int getCount(int index) const;
+
+        /// Finds the pair for an element. The inline elements are compared
+        /// all at once, which compiles to a single vector comparison.
+        ///
+        /// @param element the element ID
+        /// @return the index of the pair, or -1 if the element is absent
+
+        int find(int element) const;
+
+        /// Returns the number of atoms of an element.
+        ///
+        /// @param element the element ID
+        /// @return the number of atoms, or 0 if the element is absent
+
+        int getCountOf(int element) const;
+
+        /// Adds atoms of an element.
+        ///
+        /// @param element the element ID
+        /// @param count the number of atoms to add
+
+        void add(int element, int count);
+
+        /// Adds a multiple of another composition by merging the two
+        /// sorted lists of pairs.
+        ///
+        /// @param other the composition to add
+        /// @param multiplier the number of times to add it
+        /// @return whether every count still fits in an int; if not, the
+        ///         composition is left unchanged
+
+        bool add(const Composition& other, int multiplier);
+};
+
+/// Returns the array of elements.
+
+inline const unsigned char* Composition::getElements() const {
+    return spillElements ? spillElements : inlineElements;
+}
+
+/// Returns the array of counts.
+
+inline int* Composition::getCounts() {
+    return spillCounts ? spillCounts : inlineCounts;
+}
+
+/// Returns the number of different elements.
+
+inline int Composition::getSize() const {
+    return size;
+}
+
+/// Returns the element of a pair.
+
+inline int Composition::getElement(int index) const {
+    return getElements()[index];
+}
+
+/// Returns the count of a pair.
+
+inline int Composition::getCount(int index) const {
+    return spillCounts ? spillCounts[index] : inlineCounts[index];
+}
+
+/// Finds the pair for an element.
+
+inline int Composition::find(int element) const {
+    if (!spillElements) {
+        unsigned int mask = 0;
+        for (int i = 0; i < INLINE_ELEMENTS; i++) {
+            mask |= (unsigned int) (inlineElements[i] == element) << i;
+        }
+        return element && mask ? __builtin_ctz(mask) : -1;
+    }
+
+    int low = 0;
+    int high = size - 1;
+    while (low <= high) {
+        int middle = (low + high) / 2;
+        if (spillElements[middle] == element) return middle;
+        if (spillElements[middle] < element) {
+            low = middle + 1;
+        } else {
+            high = middle - 1;
+        }
+    }
+    return -1;
+}
+
+/// Returns the number of atoms of an element.
+
+inline int Composition::getCountOf(int element) const {
+    int index = find(element);
+    return index == -1 ? 0 : getCount(index);
+}
+
+/// Adds atoms of an element.
+
+inline void Composition::add(int element, int count) {
+    int index = find(element);
+    if (index != -1) {
+        getCounts()[index] += count;
+        return;
+    }
+
+    const unsigned char* elements = getElements();
+    int position = size;
+    while (position > 0 && elements[position - 1] > element) position--;
+    insert(position, element, count);
+}
+
+/// Constructor for the Composition class.
+
+inline Composition::Composition() : inlineElements(), inlineCounts(), spillElements(0), spillCounts(0),
+        size(0), capacity(INLINE_ELEMENTS) {
+}
+
+#endif
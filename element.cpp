@@ -0,0 +1,67 @@
+///
+/// file: element.cpp
+/// Implementation for the periodic table
+///
+/// @author Dominick Banasik
+
+#include "element.hpp"
+
+#ifndef _ELEMENT_IMPL_
+#define _ELEMENT_IMPL_
+
+/// The symbols of the elements, indexed by atomic number.
+
+inline constexpr const char* ELEMENT_SYMBOLS[ELEMENT_COUNT + 1] = {
+    "",
+    "H", "He", "Li", "Be", "B", "C", "N", "O", "F", "Ne",
+    "Na", "Mg", "Al", "Si", "P", "S", "Cl", "Ar", "K", "Ca",
+    "Sc", "Ti", "V", "Cr", "Mn", "Fe", "Co", "Ni", "Cu", "Zn",
+    "Ga", "Ge", "As", "Se", "Br", "Kr", "Rb", "Sr", "Y", "Zr",
+    "Nb", "Mo", "Tc", "Ru", "Rh", "Pd", "Ag", "Cd", "In", "Sn",
+    "Sb", "Te", "I", "Xe", "Cs", "Ba", "La", "Ce", "Pr", "Nd",
+    "Pm", "Sm", "Eu", "Gd", "Tb", "Dy", "Ho", "Er", "Tm", "Yb",
+    "Lu", "Hf", "Ta", "W", "Re", "Os", "Ir", "Pt", "Au", "Hg",
+    "Tl", "Pb", "Bi", "Po", "At", "Rn", "Fr", "Ra", "Ac", "Th",
+    "Pa", "U", "Np", "Pu", "Am", "Cm", "Bk", "Cf", "Es", "Fm",
+    "Md", "No", "Lr", "Rf", "Db", "Sg", "Bh", "Hs", "Mt", "Ds",
+    "Rg", "Cn", "Nh", "Fl", "Mc", "Lv", "Ts", "Og"
+};
+
+/// Returns the slot a symbol hashes to.
+
+constexpr int PeriodicTable::slot(char first, char second) {
+    if (first < 'A' || first > 'Z') return -1;
+    if (second != 0 && (second < 'a' || second > 'z')) return -1;
+    return (first - 'A') * 27 + (second ? second - 'a' + 1 : 0);
+}
+
+/// Constructor for the PeriodicTable class.
+
+constexpr PeriodicTable::PeriodicTable() : ids() {
+    for (int id = 1; id <= ELEMENT_COUNT; id++) {
+        const char* name = ELEMENT_SYMBOLS[id];
+        ids[slot(name[0], name[1])] = (unsigned char) id;
+    }
+}
+
+/// Returns the ID of an element.
+
+constexpr int PeriodicTable::lookup(char first, char second) const {
+    int index = slot(first, second);
+    return index < 0 ? 0 : ids[index];
+}
+
+/// Returns the symbol of an element.
+
+constexpr const char* PeriodicTable::symbol(int id) {
+    return id > 0 && id <= ELEMENT_COUNT ? ELEMENT_SYMBOLS[id] : "?";
+}
+
+/// The periodic table, built at compile time.
+
+inline constexpr PeriodicTable PERIODIC_TABLE;
+
+static_assert(PERIODIC_TABLE.lookup('O', 'g') == ELEMENT_COUNT, "the periodic table is incomplete");
+static_assert(PERIODIC_TABLE.lookup('X', 0) == 0, "unknown symbols must not be found");
+
+#endif
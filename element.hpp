@@ -0,0 +1,54 @@
+///
+/// file: element.hpp
+/// Header file for the periodic table
+///
+/// @author Dominick Banasik
+
+#ifndef _ELEMENT_H_
+#define _ELEMENT_H_
+
+#define ELEMENT_COUNT 118
+#define SYMBOL_SLOTS (26 * 27)
+
+/// The PeriodicTable class maps element symbols to their atomic numbers,
+/// which serve as the element IDs everywhere after parsing. A symbol is
+/// an upper case letter and an optional lower case one, so it hashes to a
+/// slot of a 26 by 27 table without collisions. The table is built at
+/// compile time and every lookup is a single load.
+
+class PeriodicTable {
+    private:
+        unsigned char ids[SYMBOL_SLOTS];
+
+        /// Returns the slot a symbol hashes to.
+        ///
+        /// @param first the upper case letter of the symbol
+        /// @param second the lower case letter of the symbol, or 0
+        /// @return the slot, or -1 if the characters cannot form a symbol
+
+        static constexpr int slot(char first, char second);
+
+    public:
+        /// Constructor for the PeriodicTable class.
+
+        constexpr PeriodicTable();
+
+        /// Returns the ID of an element.
+        ///
+        /// @param first the upper case letter of the symbol
+        /// @param second the lower case letter of the symbol, or 0
+        /// @return the atomic number, or 0 if there is no such element
+
+        constexpr int lookup(char first, char second) const;
+
+        /// Returns the symbol of an element.
+        ///
+        /// @param id the atomic number of the element
+        /// @return the symbol
+
+        static constexpr const char* symbol(int id);
+};
+
+#include "element.cpp"
+
+#endif
@@ -7,73 +7,253 @@
 #include <string.h>
 #include <stdio.h>
 
+#include <algorithm>
+
 #include "equation.hpp"
 
 #ifndef _EQUATION_IMPL_
 #define _EQUATION_IMPL_
 
-/// Fills the last column of a matrix with the fixed number of a certain
-/// atom in the entire equation.
+/// Fills a matrix with the number of each atom in each molecule.
 
-void Equation::fillLastColumn(Matrix matrix) {
-    int col = freeReactantCount + freeProductCount;
+template <typename M>
+void Equation::fillMatrix(M& matrix) {
+    int last = freeReactantCount + freeProductCount;
+    int col = 0;
 
-    for (int i = 0; i < atomCount; i++) {
-        matrix.setValue(atoms[i], col, 0);
-    }
+    for (int side = 0; side < 2; side++) {
+        bool isReactant = side == 0;
+        int mult = isReactant ? 1 : -1;
+        int moleculeCount = isReactant ? reactantCount : productCount;
+        Molecule* molecules = isReactant ? reactants : products;
 
-    for (int i = 0; i < reactantCount; i++) {
-        Molecule molecule = reactants[i];
-        if (molecule.getFixed()) {
-            for (int j = 0; j < atomCount; j++) {
-                char* atom = atoms[j];
-                Fraction f = matrix.getValue(j, col);
-                matrix.setValue(atom, col, molecule.getCountOfAtom(atom) + f.getNum());
+        for (int i = 0; i < moleculeCount; i++) {
+            Molecule& molecule = molecules[i];
+            const Composition& composition = molecule.getComposition();
+            int target = molecule.getFixed() ? last : col++;
+
+            for (int j = 0; j < composition.getSize(); j++) {
+                matrix.addValue(atomRows[composition.getElement(j)], target, mult * composition.getCount(j));
             }
         }
     }
+}
+
+/// Generates a matrix from the chemical equation.
 
+Matrix<Rational> Equation::createMatrixFromEquation() {
+    Matrix<Rational> matrix(atoms, atomCount, freeReactantCount + freeProductCount + 1, &arena);
+    fillMatrix(matrix);
+    return matrix;
+}
+
+/// Generates a sparse matrix from the chemical equation.
+
+SparseMatrix<Rational> Equation::createSparseMatrixFromEquation() {
+    SparseMatrix<Rational> matrix(atoms, atomCount, freeReactantCount + freeProductCount + 1, &arena);
+    fillMatrix(matrix);
+    return matrix;
+}
+
+/// Compares two molecules by whether they are fixed and then by their
+/// compositions, element by element.
+///
+/// @param a the first molecule
+/// @param b the second molecule
+/// @return a negative number, zero or a positive number as the first
+///         molecule sorts before, with or after the second
+
+static int compareMolecules(Molecule* a, Molecule* b) {
+    if (a->getFixed() != b->getFixed()) return a->getFixed() ? 1 : -1;
+
+    const Composition& first = a->getComposition();
+    const Composition& second = b->getComposition();
+    for (int j = 0; j < first.getSize() && j < second.getSize(); j++) {
+        if (first.getElement(j) != second.getElement(j)) return first.getElement(j) - second.getElement(j);
+        if (first.getCount(j) != second.getCount(j)) return first.getCount(j) < second.getCount(j) ? -1 : 1;
+    }
+    return first.getSize() - second.getSize();
+}
+
+/// Compares two sorted sides of an equation molecule by molecule.
+///
+/// @param a the molecules of the first side
+/// @param aCount the number of molecules on the first side
+/// @param b the molecules of the second side
+/// @param bCount the number of molecules on the second side
+/// @return a negative number, zero or a positive number as the first
+///         side sorts before, with or after the second
+
+static int compareSides(Molecule** a, int aCount, Molecule** b, int bCount) {
+    for (int i = 0; i < aCount && i < bCount; i++) {
+        int order = compareMolecules(a[i], b[i]);
+        if (order) return order;
+    }
+    return aCount - bCount;
+}
+
+/// Puts the equation in canonical form.
+
+void Equation::canonicalize() {
+    int total = reactantCount + productCount;
+    Molecule** sequence = arena.allocate<Molecule*>(total);
+    for (int i = 0; i < reactantCount; i++) {
+        sequence[i] = &reactants[i];
+    }
     for (int i = 0; i < productCount; i++) {
-        Molecule molecule = products[i];
-        if (molecule.getFixed()) {
-            for (int j = 0; j < atomCount; j++) {
-                char* atom = atoms[j];
-                Fraction f = matrix.getValue(j, col);
-                matrix.setValue(atom, col, -1 * molecule.getCountOfAtom(atom) + f.getNum());
-            }
+        sequence[reactantCount + i] = &products[i];
+    }
+
+    auto before = [](Molecule* a, Molecule* b) { return compareMolecules(a, b) < 0; };
+    std::stable_sort(sequence, sequence + reactantCount, before);
+    std::stable_sort(sequence + reactantCount, sequence + total, before);
+
+    int firstCount = reactantCount;
+    if (compareSides(sequence + reactantCount, productCount, sequence, reactantCount) < 0) {
+        std::rotate(sequence, sequence + reactantCount, sequence + total);
+        firstCount = productCount;
+    }
+
+    int* callerColumns = arena.allocate<int>(total);
+    int col = 0;
+    for (int i = 0; i < reactantCount; i++) {
+        callerColumns[i] = reactants[i].getFixed() ? -1 : col++;
+    }
+    for (int i = 0; i < productCount; i++) {
+        callerColumns[reactantCount + i] = products[i].getFixed() ? -1 : col++;
+    }
+
+    int header[2] = { firstCount, total - firstCount };
+    key.assign((const char*) header, sizeof(header));
+    columns = arena.allocate<int>(col > 0 ? col : 1);
+    col = 0;
+
+    for (int i = 0; i < total; i++) {
+        Molecule* molecule = sequence[i];
+        const Composition& composition = molecule->getComposition();
+        int index = molecule >= reactants && molecule < reactants + reactantCount
+                ? (int) (molecule - reactants) : reactantCount + (int) (molecule - products);
+        if (callerColumns[index] != -1) columns[callerColumns[index]] = col++;
+
+        key += (char) molecule->getFixed();
+        key += (char) composition.getSize();
+        for (int j = 0; j < composition.getSize(); j++) {
+            int count = composition.getCount(j);
+            key += (char) composition.getElement(j);
+            key.append((const char*) &count, sizeof(count));
         }
     }
-}
 
-/// Fills a column of a matrix with the coefficients corresponding
-/// to the number of a certain atom in that molecule.
+    hash = hashBytes(key.data(), key.size());
+    order.assign((const char*) columns, col * sizeof(int));
+}
 
-void Equation::fillMatrix(Matrix matrix, bool isReactant) {
-    int mult = isReactant ? 1 : -1;
-    int index = isReactant ? 0 : freeReactantCount;
-    int moleculeCount = isReactant ? reactantCount : productCount;
-    Molecule* molecules = isReactant ? reactants : products;
-    
-    for (int i = 0; i < moleculeCount; i++) {
-        Molecule molecule = molecules[i];
-        if (!molecule.getFixed()) {
-            for (int j = 0; j < atomCount; j++) {
-                char* atom = atoms[j];
-                matrix.setValue(atom, index, mult * molecule.getCountOfAtom(atom));
-            }
-            index++;
+/// Copies a solution between the order the molecules were given in
+/// and the canonical order.
+
+Solution Equation::reorder(Solution& solution, bool canonical) {
+    int size = freeReactantCount + freeProductCount;
+    Solution reordered(size, &arena);
+    reordered.setStatus(solution.getStatus());
+    reordered.setUnique(solution.getUnique());
+    for (int i = 0; i < size; i++) {
+        if (canonical) {
+            reordered.setValue(solution.getValue(i), columns[i]);
+        } else {
+            reordered.setValue(solution.getValue(columns[i]), i);
         }
     }
+    return reordered;
 }
 
-/// Generates a matrix from the chemical equation.
+/// Balances the equation by building its matrix, reducing it
+/// with the chosen engine and solving it.
 
-Matrix Equation::createMatrixFromEquation() {
-    Matrix matrix(atoms, atomCount, freeReactantCount + freeProductCount + 1);
-    fillMatrix(matrix, true);
-    fillMatrix(matrix, false);
-    fillLastColumn(matrix);
-    return matrix;
+Solution Equation::balance(Engine engine, ResultCache* cache) {
+    if (!valid) {
+        Solution solution(0, &arena);
+        solution.setStatus(INVALID);
+        return solution;
+    }
+    if (!cache) return solve(engine);
+
+    int size = freeReactantCount + freeProductCount;
+    canonicalize();
+    Solution canonical(size, &arena);
+    if (cache->find(key, order, canonical)) return reorder(canonical, false);
+
+    Solution solution = solve(engine);
+    canonical = reorder(solution, true);
+    cache->insert(key, order, canonical, size);
+    return solution;
+}
+
+/// Returns the structural hash of the equation.
+
+Hash128 Equation::getHash() {
+    return hash;
+}
+
+/// Counts a solution found by elimination and the size of its largest
+/// coefficient. Does nothing unless stats are compiled in.
+///
+/// @param solution the solution
+/// @param size the number of coefficients in the solution
+/// @return the solution
+
+static inline Solution recordSolution(Solution solution, [[maybe_unused]] int size) {
+#ifdef BALANCER_STATS
+    STATS_FLUSH();
+    if (solution.getStatus() != SOLVED) return solution;
+    STATS_COUNT(COUNT_SOLVED, 1);
+    int bits = 0;
+    for (int i = 0; i < size; i++) {
+        Rational value = solution.getValue(i);
+        bits = std::max(bits, std::max(value.getNum().bitLength(), value.getDen().bitLength()));
+    }
+    STATS_RAISE(MAX_COEFFICIENT_BITS, bits);
+#endif
+    return solution;
+}
+
+/// Builds the matrix of the equation, reduces it with the chosen
+/// engine and solves it.
+
+Solution Equation::solve(Engine engine) {
+    int columns = freeReactantCount + freeProductCount + 1;
+    STATS_COUNT(COUNT_MATRICES, 1);
+    STATS_COUNT(COUNT_MATRIX_ROWS, atomCount);
+    STATS_COUNT(COUNT_MATRIX_COLUMNS, columns);
+    STATS_RAISE(MAX_MATRIX_ROWS, atomCount);
+    STATS_RAISE(MAX_MATRIX_COLUMNS, columns);
+
+    if (engine == SPARSE) {
+        STATS_START(start);
+        SparseMatrix<Rational> matrix = createSparseMatrixFromEquation();
+        STATS_STAGE(STAGE_MATRIX, start);
+
+        STATS_START(built);
+        matrix.reduce();
+        STATS_STAGE(STAGE_REDUCE, built);
+
+        STATS_START(reduced);
+        Solution solution = matrix.solve();
+        STATS_STAGE(STAGE_SOLVE, reduced);
+        return recordSolution(solution, columns - 1);
+    }
+
+    STATS_START(start);
+    Matrix<Rational> matrix = createMatrixFromEquation();
+    STATS_STAGE(STAGE_MATRIX, start);
+
+    STATS_START(built);
+    matrix.reduce(engine);
+    STATS_STAGE(STAGE_REDUCE, built);
+
+    STATS_START(reduced);
+    Solution solution = matrix.solve();
+    STATS_STAGE(STAGE_SOLVE, reduced);
+    return recordSolution(solution, columns - 1);
 }
 
 /// Updates the list of atoms to inclue all atoms from a group
@@ -89,199 +269,238 @@ void Equation::generateAtoms(bool isReactant) {
     }
 
     for (int i = 0; i < moleculeCount; i++) {
-        Molecule molecule = molecules[i];
-        int moleculeAtomCount = molecule.getSize();
-        char** moleculeAtoms = molecule.getAtoms();
+        Molecule& molecule = molecules[i];
+        const Composition& composition = molecule.getComposition();
 
-        for (int j = 0; j < moleculeAtomCount; j++) {
-            bool duplicate = false;
+        if (!molecule.getValid()) valid = false;
 
-            for (int k = 0; k < atomCount; k++) {
-                if (!strcmp(atoms[k], moleculeAtoms[j])) {
-                    duplicate = true;
-                }
-            }
+        for (int j = 0; j < composition.getSize(); j++) {
+            int element = composition.getElement(j);
+            if (atomRows[element] != -1) continue;
 
-            if (!duplicate) {
-                if (atomCount == atomCapacity) {
-                    atomCapacity += CAPACITY;
-                    atoms = (char**) realloc(atoms, atomCapacity * sizeof(char*));
-                }
-                atoms[atomCount] = (char*) malloc(ATOM_SIZE * sizeof(char));
-                strcpy(atoms[atomCount++], moleculeAtoms[j]);
+            if (atomCount == atomCapacity) {
+                atomCapacity += CAPACITY;
+                atoms = (int*) realloc(atoms, atomCapacity * sizeof(int));
             }
+            atomRows[element] = atomCount;
+            atoms[atomCount++] = element;
         }
     }
 }
 
-/// Returns a list of all atoms in the equation.
+/// Returns the number of reactants in the equation.
 
-char** Equation::getAtoms() {
-    return atoms;
+int Equation::getReactantCount() {
+    return reactantCount;
 }
 
-/// Adds a molecule to the list of reactants or products.
+/// Returns the number of products in the equation.
+
+int Equation::getProductCount() {
+    return productCount;
+}
 
-void Equation::addMolecule(char* string, int start, int index, bool isReactant) {
-    char* moleculeStr = (char*) malloc((index - start + 1) * sizeof(char));
+/// Returns a molecule of the equation.
 
-    for (int i = 0; i < index - 1; i++) {
-        moleculeStr[i - start] = string[i]; 
-    }
+Molecule& Equation::getMolecule(int index) {
+    return index < reactantCount ? reactants[index] : products[index - reactantCount];
+}
+
+/// Returns the element IDs of all atoms in the equation.
+
+int* Equation::getAtoms() {
+    return atoms;
+}
 
+/// Adds a molecule to the list of reactants or products.
+
+void Equation::addMolecule(std::string_view formula, bool isReactant) {
     int* moleculeCount = &reactantCount;
     int* freeMoleculeCount = &freeReactantCount;
     int* moleculeCapacity = &reactantCapacity;
-    Molecule* molecules = reactants;
+    Molecule** molecules = &reactants;
     if (!isReactant) {
         moleculeCount = &productCount;
         freeMoleculeCount = &freeProductCount;
         moleculeCapacity = &productCapacity;
-        molecules = products;
+        molecules = &products;
     }
 
     if (*moleculeCount == *moleculeCapacity) {
         *moleculeCapacity += CAPACITY;
-        molecules = (Molecule*) realloc(molecules, *moleculeCapacity * sizeof(Molecule));
+        *molecules = (Molecule*) realloc(*molecules, *moleculeCapacity * sizeof(Molecule));
     }
 
-    Molecule molecule(moleculeStr);
-        
+    Molecule molecule(formula, formulas);
+
     if (!molecule.getFixed()) (*freeMoleculeCount)++;
-    molecules[(*moleculeCount)++] = molecule;
+    (*molecules)[(*moleculeCount)++] = molecule;
 }
 
 /// Parses a string that represents the molecules that
-/// make up the equation.
+/// make up the equation. A '-' sends the next molecule to the
+/// other side of the equation.
 
-void Equation::parse(char* string) {
-    int start = 0;
-    int index = 0;
+void Equation::parse(std::string_view string) {
+    size_t start = 0;
+    bool right = false;
     bool flip = false;
-    char next;
-
-    while (next = *(string + index++)) {
-        if (next == '+' || next == '=') {
-            if (!flip) {
-                addMolecule(string, start, index, true);
-            } else {
-                addMolecule(string, start, index, false);
-                flip = false;
-            }
-            start = index;
-            if (next == '=') break;
-        } else if (next == '-') {
-            if (!flip) {
-                addMolecule(string, start, index, true);
-                flip = true;
-            } else {
-                addMolecule(string, start, index, false);
-            }
-            start = index;
+
+    for (size_t index = 0; index < string.size(); index++) {
+        char next = string[index];
+        if (next == '+' || next == '-' || (next == '=' && !right)) {
+            addMolecule(string.substr(start, index - start), right == flip);
+            start = index + 1;
+            flip = next == '-';
+            if (next == '=') right = true;
         }
     }
 
-    while (next = *(string + index++)) {
-        if (next == '+') {
-            if (!flip) {
-                addMolecule(string, start, index, false);
-            } else {
-                addMolecule(string, start, index, true);
-                flip = false;
-            }
-            start = index;
-        } else if (next == '-') {
-            if (!flip) {
-                addMolecule(string, start, index, false);
-                flip = true;
-            } else {
-                addMolecule(string, start, index, true);
-            }
-            start = index;
+    addMolecule(string.substr(start), flip);
+}
+
+/// Empties the equation, keeping its arrays for the next one.
+
+void Equation::clear() {
+    columns = NULL;
+    hash.low = 0;
+    hash.high = 0;
+    for (int i = 0; i < reactantCount; i++) {
+        reactants[i].release();
+    }
+    for (int i = 0; i < productCount; i++) {
+        products[i].release();
+    }
+    for (int i = 0; i < atomCount; i++) {
+        atomRows[atoms[i]] = -1;
+    }
+
+    reactantCount = 0;
+    productCount = 0;
+    freeReactantCount = 0;
+    freeProductCount = 0;
+    atomCount = 0;
+    valid = true;
+}
+
+/// Replaces the equation with one parsed from a string.
+
+void Equation::assign(std::string_view string) {
+    STATS_SAMPLE();
+    STATS_START(start);
+    clear();
+    arena.reset();
+    parse(string);
+    STATS_STAGE(STAGE_PARSE, start);
+
+    STATS_START(parsed);
+    generateAtoms(true);
+    generateAtoms(false);
+    STATS_STAGE(STAGE_ATOMS, parsed);
+    STATS_COUNT(COUNT_EQUATIONS, 1);
+}
+
+/// Appends a molecule to an output string, after its coefficient if it
+/// is free.
+
+void appendTerm(std::string& output, Molecule molecule, Solution solution, int* index) {
+    if (!molecule.getFixed()) {
+        Rational value = solution.getValue((*index)++);
+        output += '_';
+        value.getNum().toString(output);
+        if (!value.getDen().isOne()) {
+            output += '/';
+            value.getDen().toString(output);
         }
     }
+    output += molecule.getFormula();
+}
 
-    if (!flip) {
-        addMolecule(string, start, index, false);
-    } else {
-        addMolecule(string, start, index, true);
+/// Appends the statement of why an equation was not solved to an output
+/// string.
+
+void appendStatus(Status status, std::string& output) {
+    if (status == UNSOLVED) {
+        output += "The equation has no solution\n";
+    } else if (status == BALANCED) {
+        output += "The equation is already balanced\n";
+    } else if (status == UNBALANCED) {
+        output += "The equation is unbalanced\n";
+    } else if (status == OVERFLOWED) {
+        output += "The coefficients are too large to compute\n";
+    } else if (status == INVALID) {
+        output += "The equation contains an unknown element\n";
     }
 }
 
-/// Prints the solution to the equation, or states otherwise
+/// Formats the solution to the equation, or states otherwise
 /// if no solution exists, the equation is balanced, or
 /// the equation is unbalanced.
 
-void Equation::printSolution(Solution solution) {
+void Equation::formatSolution(Solution solution, std::string& output) {
     if (solution.getStatus() == SOLVED) {
         int index = 0;
         
         for (int i = 0; i < reactantCount; i++) {
-            Molecule reactant = reactants[i];
-            if (reactant.getFixed()) {
-                reactant.printMolecule();
-            } else {
-                printf("_");
-                int num = solution.getValue(index).getNum();
-                int den = solution.getValue(index++).getDen();
-                if (num % den) {
-                    printf("%d/%d", num, den);
-                } else {
-                    printf("%d", num / den);
-                }
-                reactant.printMolecule();
-            }
-            if (i < reactantCount - 1) printf(" + ");
+            appendTerm(output, reactants[i], solution, &index);
+            if (i < reactantCount - 1) output += " + ";
         }
         
-        printf(" = ");
+        output += " = ";
 
         for (int i = 0; i < productCount; i++) {
-            Molecule product = products[i];
-            if (product.getFixed()) {
-                product.printMolecule();
-            } else {
-                printf("_");
-                int num = solution.getValue(index).getNum();
-                int den = solution.getValue(index++).getDen();
-                if (num % den) {
-                    printf("%d/%d", num, den);
-                } else {
-                    printf("%d", num / den);
-                }
-                product.printMolecule();
-            }
-            if (i < productCount - 1) printf(" + ");
+            appendTerm(output, products[i], solution, &index);
+            if (i < productCount - 1) output += " + ";
         }
-    } else if (solution.getStatus() == UNSOLVED) {
-        printf("The equation has no solution\n");
-    } else if (solution.getStatus() == BALANCED) {
-        printf("The equation is already balanced\n");
-    } else if (solution.getStatus() == UNBALANCED) {
-        printf("The equation is unbalanced\n");
+        output += "\n";
+    } else {
+        appendStatus(solution.getStatus(), output);
     }
 }
 
-/// Constructor for the Equation class.
+/// Prints the solution to the equation, or states otherwise
+/// if no solution exists, the equation is balanced, or
+/// the equation is unbalanced.
+
+void Equation::printSolution(Solution solution) {
+    std::string output;
+    formatSolution(solution, output);
+    fputs(output.c_str(), stdout);
+}
 
-Equation::Equation(char* string) {
+/// Constructor for an empty Equation.
+
+Equation::Equation(FormulaCache* formulas) {
+    this->formulas = formulas;
     reactantCapacity = CAPACITY;
     productCapacity = CAPACITY;
     atomCapacity = CAPACITY;
     reactantCount = 0;
     productCount = 0;
-    freeReactantCount = 0;
-    freeProductCount = 0;
     atomCount = 0;
+    for (int i = 0; i <= ELEMENT_COUNT; i++) {
+        atomRows[i] = -1;
+    }
 
     reactants = (Molecule*) malloc(reactantCapacity * sizeof(Molecule));
     products = (Molecule*) malloc(productCapacity * sizeof(Molecule));
-    atoms = (char**) malloc(atomCapacity * sizeof(char*));
+    atoms = (int*) malloc(atomCapacity * sizeof(int));
+    clear();
+}
 
-    parse(string);
-    generateAtoms(true);
-    generateAtoms(false);
+/// Constructor for the Equation class.
+
+Equation::Equation(std::string_view string) : Equation() {
+    assign(string);
+}
+
+/// Destructor for the Equation class.
 
+Equation::~Equation() {
+    clear();
+    free(reactants);
+    free(products);
+    free(atoms);
 }
 
 #endif
@@ -6,23 +6,34 @@
 
 #include <stdlib.h>
 
+#include <string>
+#include <string_view>
+
 #ifndef _EQUATION_H_
 #define _EQUATION_H_
 
 #define CAPACITY 5
-#define ATOM_SIZE 3
 
+#include "element.hpp"
 #include "molecule.hpp"
 #include "matrix.hpp"
+#include "sparse.hpp"
+#include "arena.hpp"
+#include "cache.hpp"
+#include "hash.hpp"
+#include "stats.hpp"
 
 /// The Equation class represents a chemical equation
-/// with a list of reactants and a list of products.
+/// with a list of reactants and a list of products. Everything built
+/// while balancing it comes from its arena, which is reset when the
+/// next equation is assigned.
 
 class Equation {
     private:
         Molecule* reactants;
         Molecule* products;
-        char** atoms;
+        int* atoms;
+        int atomRows[ELEMENT_COUNT + 1];
         int reactantCount;
         int productCount;
         int freeReactantCount;
@@ -31,22 +42,35 @@ class Equation {
         int reactantCapacity;
         int productCapacity;
         int atomCapacity;
+        bool valid;
+        Arena arena;
+        std::string key;
+        std::string order;
+        Hash128 hash;
+        int* columns;
+        FormulaCache* formulas;
+
+        friend class StageTimer;
+        friend class Factorization;
+        friend class Network;
 
         /// Parses a string that represents the molecules that
         /// make up the equation.
         ///
         /// @param string the string to parse
 
-        void parse(char* string);
+        void parse(std::string_view string);
+
+        /// Empties the equation, keeping its arrays for the next one.
+
+        void clear();
 
         /// Adds a molecule to the list of reactants or products.
         ///
-        /// @param string the string representation of the equation
-        /// @param start the starting index of the molecule
-        /// @param index the ending index of the molecule
+        /// @param formula the string representation of the molecule
         /// @param isReactant whether the molecule is a reactant or products
 
-        void addMolecule(char* string, int start, int index, bool isReactant);
+        void addMolecule(std::string_view formula, bool isReactant);
         
         /// Updates the list of atoms to include all atoms from a group
         /// of molecules.
@@ -55,39 +79,145 @@ class Equation {
 
         void generateAtoms(bool isReactant);
 
-        /// Fills a column of a matrix with the coefficients corresponding
-        /// to the number of a certain atom in that molecule.
+        /// Puts the equation in canonical form. The molecules on each side
+        /// are sorted by whether they are fixed and by their compositions,
+        /// and the sides are swapped if the products sort first. The
+        /// column of each free molecule in the canonical matrix is kept so
+        /// coefficients can be mapped back. The canonical molecules, which
+        /// determine the matrix, are written into the key and hashed, and
+        /// the columns are written into the order.
+
+        void canonicalize();
+
+        /// Copies a solution between the order the molecules were given in
+        /// and the canonical order.
         ///
-        /// @param matrix the matrix to fill
-        /// @param isReactant whether a reactant or product column is being filled
+        /// @param solution the solution to copy
+        /// @param canonical whether to copy into the canonical order rather
+        ///                  than out of it
+        /// @return the reordered solution
 
-        void fillMatrix(Matrix matrix, bool isReactant);
+        Solution reorder(Solution& solution, bool canonical);
 
-        /// Fills the last column of a matrix with the fixed number of a certain
-        /// atom in the entire equation.
+        /// Builds the matrix of the equation, reduces it with the chosen
+        /// engine and solves it.
         ///
+        /// @param engine the elimination to reduce the matrix with
+        /// @return the solution to the equation
+
+        Solution solve(Engine engine);
+
+        /// Fills a matrix with the number of each atom in each molecule,
+        /// one column per free molecule, and the last column with the
+        /// number of each atom fixed by the other molecules. Every count
+        /// is scattered straight to its row by element ID.
+        ///
+        /// @tparam M the type of the matrix
         /// @param matrix the matrix to fill
 
-        void fillLastColumn(Matrix matrix);
+        template <typename M>
+        void fillMatrix(M& matrix);
 
     public:
+        /// Constructor for an empty Equation.
+        ///
+        /// @param formulas the cache of parsed formulas to share, or NULL
+
+        Equation(FormulaCache* formulas = NULL);
+
         /// Constructor for the Equation class.
         ///
         /// @param string the string to create the equation from
 
-        Equation(char* string);
+        Equation(std::string_view string);
+
+        /// Destructor for the Equation class.
+
+        ~Equation();
+
+        Equation(const Equation& copy) = delete;
+        Equation& operator=(const Equation& copy) = delete;
+
+        /// Replaces the equation with one parsed from a string. The
+        /// arrays of the previous equation are reused, so parsing an
+        /// equation no larger than an earlier one allocates nothing. The
+        /// molecules keep views of the string, which must outlive them.
+        /// Matrices and solutions of the previous equation are freed.
+        ///
+        /// @param string the string to create the equation from
+
+        void assign(std::string_view string);
         
-        /// Returns a list of all atoms in the equation.
+        /// Returns the structural hash of the equation, which is the same
+        /// for every equation with the same canonical matrix. Only set
+        /// once the equation has been balanced with a cache.
+        ///
+        /// @return the 128-bit hash
+
+        Hash128 getHash();
+
+        /// Returns the number of reactants in the equation.
+        ///
+        /// @return the number of reactants
+
+        int getReactantCount();
+
+        /// Returns the number of products in the equation.
+        ///
+        /// @return the number of products
+
+        int getProductCount();
+
+        /// Returns a molecule of the equation. The reactants come first,
+        /// then the products, each in the order they were given in.
+        ///
+        /// @param index the index of the molecule
+        /// @return the molecule
+
+        Molecule& getMolecule(int index);
+
+        /// Returns the element IDs of all atoms in the equation.
         ///
         /// @return list of atoms
 
-        char** getAtoms();
+        int* getAtoms();
 
-        /// Generates a matrix from the chemical equation.
+        /// Generates a matrix from the chemical equation in the arena.
         ///
         /// @return augmented matrix representing the equation
 
-        Matrix createMatrixFromEquation();
+        Matrix<Rational> createMatrixFromEquation();
+
+        /// Generates a sparse matrix from the chemical equation in the
+        /// arena, adding only the atoms each molecule contains.
+        ///
+        /// @return augmented sparse matrix representing the equation
+
+        SparseMatrix<Rational> createSparseMatrixFromEquation();
+
+        /// Balances the equation by building its matrix, reducing it
+        /// with the chosen engine and solving it. With a cache, solutions
+        /// are kept under the canonical form of the equation, so a unique
+        /// solution serves every equation that differs only in the order
+        /// of its molecules or sides, and an equation the cache already
+        /// holds never builds its matrix.
+        ///
+        /// @param engine the elimination to reduce the matrix with
+        /// @param cache the cache of earlier solutions, or NULL
+        /// @return the solution to the equation, valid until the next
+        ///         equation is assigned
+
+        Solution balance(Engine engine, ResultCache* cache = NULL);
+
+        /// Appends the solution to the equation to a string, or states
+        /// otherwise if no solution exists, the equation is balanced, or
+        /// the equation is unbalanced. Does not touch stdio, so it may be
+        /// called from any thread.
+        ///
+        /// @param solution the solution to format
+        /// @param output the string to append to
+
+        void formatSolution(Solution solution, std::string& output);
 
         /// Prints the solution to the equation, or states otherwise
         /// if no solution exists, the equation is balanced, or
@@ -96,4 +226,23 @@ class Equation {
         void printSolution(Solution solution);
 };
 
+/// Appends a molecule to an output string, after its coefficient if it
+/// is free, as the balancer prints it.
+///
+/// @param output the string to append to
+/// @param molecule the molecule to append
+/// @param solution the solution holding the coefficients
+/// @param index the index of the next free coefficient, which is
+///              advanced past the molecule's
+
+void appendTerm(std::string& output, Molecule molecule, Solution solution, int* index);
+
+/// Appends the statement of why an equation was not solved to an output
+/// string, as the balancer prints it. Appends nothing for SOLVED.
+///
+/// @param status the status of the solution
+/// @param output the string to append to
+
+void appendStatus(Status status, std::string& output);
+
 #endif
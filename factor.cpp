@@ -0,0 +1,326 @@
+///
+/// file: factor.cpp
+/// Implementation for the Factorization class
+///
+/// @author Dominick Banasik
+
+#include <stdlib.h>
+#include <limits.h>
+
+#include <algorithm>
+#include <numeric>
+
+#include "factor.hpp"
+
+#ifndef _FACTOR_IMPL_
+#define _FACTOR_IMPL_
+
+/// The View class shows the rref of the free molecules with the reduced
+/// right-hand side of one scenario to solveReduced as the rref of the
+/// scenario's matrix. If the right-hand side is not zero in some zero row
+/// of the rref, the scenario has no solution, and that column of its rref
+/// is zero but for a pivot in the first zero row.
+
+class Factorization::View {
+    private:
+        Factorization& factorization;
+        const Rational* sides;
+        int pivot;
+        Rational zero;
+        Rational one;
+
+    public:
+        /// Constructor for the View class.
+        ///
+        /// @param factorization the factorization
+        /// @param sides the reduced right-hand side
+
+        View(Factorization& factorization, const Rational* sides) : factorization(factorization), sides(sides),
+                zero(0), one(1) {
+            pivot = -1;
+            for (int i = factorization.rank; i < factorization.rows; i++) {
+                if (!sides[i].equals(0)) {
+                    pivot = factorization.rank;
+                    break;
+                }
+            }
+        }
+
+        /// Returns the arena the solution is allocated from.
+        ///
+        /// @return the arena
+
+        Arena* getArena() const {
+            return &factorization.scratch;
+        }
+
+        /// Returns the number of rows.
+        ///
+        /// @return the number of rows
+
+        int getRows() const {
+            return factorization.rows;
+        }
+
+        /// Returns the number of columns.
+        ///
+        /// @return the number of columns
+
+        int getCols() const {
+            return factorization.free + 1;
+        }
+
+        /// Returns the value of a cell.
+        ///
+        /// @param row the row of the cell
+        /// @param col the column of the cell
+        /// @return the value
+
+        const Rational& getValue(int row, int col) {
+            if (col < factorization.free) return factorization.cells[row * factorization.free + col];
+            if (pivot != -1) return row == pivot ? one : zero;
+            return sides[row];
+        }
+
+        /// Returns the column of the first cell of a row that is not zero.
+        ///
+        /// @param row the row
+        /// @return the column, or the number of columns if the row is zero
+
+        int getLead(int row) {
+            if (row < factorization.rank) return factorization.leads[row];
+            return row == pivot ? factorization.free : factorization.free + 1;
+        }
+
+        /// Checks whether any cell overflowed.
+        ///
+        /// @return whether any cell overflowed
+
+        bool getOverflow() {
+            for (int i = 0; i < factorization.rows * factorization.free; i++) {
+                if (factorization.cells[i].getOverflow()) return true;
+            }
+            for (int i = 0; i < factorization.rows; i++) {
+                if (sides[i].getOverflow()) return true;
+            }
+            return false;
+        }
+};
+
+/// Constructor for the Factorization class.
+
+Factorization::Factorization(Equation& equation, Engine engine) {
+    int total = equation.reactantCount + equation.productCount;
+    valid = equation.valid;
+    rows = equation.atomCount;
+    free = equation.freeReactantCount + equation.freeProductCount;
+    fixedCount = total - free;
+    rank = 0;
+    determined = false;
+    largestNumerator = 0;
+    leads = arena.allocate<int>(rows + 1);
+    cells = arena.create<Rational>(rows * free + 1);
+    reduced = arena.create<Rational>(rows * fixedCount + 1);
+    numerators = arena.allocate<long long>(rows * fixedCount + 1);
+    denominators = arena.allocate<long long>(rows + 1);
+    if (!valid) return;
+
+    // Reducing [A | I] leaves [R | T], whatever the engine.
+    Arena build;
+    Matrix<Rational> matrix(equation.atoms, rows, free + rows, &build);
+    int col = 0;
+    for (int i = 0; i < total; i++) {
+        Molecule& molecule = equation.getMolecule(i);
+        if (molecule.getFixed()) continue;
+        const Composition& composition = molecule.getComposition();
+        int mult = i < equation.reactantCount ? 1 : -1;
+        for (int j = 0; j < composition.getSize(); j++) {
+            matrix.addValue(equation.atomRows[composition.getElement(j)], col, mult * composition.getCount(j));
+        }
+        col++;
+    }
+    for (int i = 0; i < rows; i++) {
+        matrix.addValue(i, free + i, 1);
+    }
+    matrix.reduce(engine);
+
+    bool overflow = false;
+    for (int i = 0; i < rows; i++) {
+        leads[i] = matrix.getLead(i);
+        if (leads[i] < free) rank++;
+        for (int j = 0; j < free; j++) {
+            cells[i * free + j] = matrix.getValue(i, j);
+            overflow = overflow || cells[i * free + j].getOverflow();
+        }
+    }
+    determined = free > 0 && rank == free && !overflow;
+
+    // Each fixed molecule's column is reduced for a coefficient of 1, so
+    // its coefficient in a scenario simply scales it.
+    int fixed = 0;
+    for (int i = 0; i < total; i++) {
+        Molecule& molecule = equation.getMolecule(i);
+        if (!molecule.getFixed()) continue;
+        Molecule unit(molecule.getBareFormula(), equation.formulas);
+        const Composition& composition = unit.getComposition();
+        int mult = i < equation.reactantCount ? 1 : -1;
+        for (int j = 0; j < composition.getSize(); j++) {
+            int atom = equation.atomRows[composition.getElement(j)];
+            Rational count(mult * composition.getCount(j));
+            for (int r = 0; r < rows; r++) {
+                Rational f(matrix.getValue(r, free + atom));
+                if (f.equals(0)) continue;
+                f.multiply(count);
+                reduced[r * fixedCount + fixed].add(f);
+            }
+        }
+        unit.release();
+        fixed++;
+    }
+
+    // Scenarios are reduced in integers when every row of TF has a common
+    // denominator and numerators that fit a long long.
+    for (int r = 0; r < rows && largestNumerator != -1; r++) {
+        Rational* row = reduced + r * fixedCount;
+        long long denominator = 1;
+        for (int k = 0; k < fixedCount; k++) {
+            if (row[k].getOverflow() || !row[k].getNum().isSmall() || !row[k].getDen().isSmall()) {
+                largestNumerator = -1;
+                break;
+            }
+            long long den = row[k].getDen().toLong();
+            if (__builtin_mul_overflow(denominator / std::gcd(denominator, den), den, &denominator)) {
+                largestNumerator = -1;
+                break;
+            }
+        }
+        for (int k = 0; k < fixedCount && largestNumerator != -1; k++) {
+            long long* numerator = numerators + r * fixedCount + k;
+            if (__builtin_mul_overflow(row[k].getNum().toLong(), denominator / row[k].getDen().toLong(), numerator)
+                    || *numerator == LLONG_MIN) {
+                largestNumerator = -1;
+                break;
+            }
+            largestNumerator = std::max(largestNumerator, llabs(*numerator));
+        }
+        denominators[r] = denominator;
+    }
+}
+
+/// Returns the number of fixed molecules.
+
+int Factorization::getFixedCount() {
+    return fixedCount;
+}
+
+/// Returns the rank of the matrix of the free molecules.
+
+int Factorization::getRank() {
+    return rank;
+}
+
+/// Makes the reduced right-hand sides of a block of scenarios.
+///
+/// In integers, each row of TF is multiplied by the coefficients of every
+/// scenario in the block at once, with the coefficients of each fixed
+/// molecule laid out side by side, so the innermost loop runs across the
+/// scenarios and compiles to vector multiplies and adds.
+
+Rational* Factorization::reduceBlock(const long long* coefficients, int count) {
+    Rational* sides = scratch.create<Rational>(rows * count + 1);
+    long long largest = 0;
+    for (int i = 0; i < count * fixedCount; i++) {
+        largest = std::max(largest, coefficients[i] == LLONG_MIN ? LLONG_MAX : llabs(coefficients[i]));
+    }
+
+    long long bound;
+    if (largestNumerator != -1 && !__builtin_mul_overflow(largestNumerator, largest, &bound)
+            && !__builtin_mul_overflow(bound, (long long) fixedCount, &bound)) {
+        long long* columns = scratch.allocate<long long>(fixedCount * count + 1);
+        long long* sums = scratch.allocate<long long>(count);
+        for (int s = 0; s < count; s++) {
+            for (int k = 0; k < fixedCount; k++) {
+                columns[k * count + s] = coefficients[s * fixedCount + k];
+            }
+        }
+
+        for (int r = 0; r < rows; r++) {
+            const long long* row = numerators + r * fixedCount;
+            for (int s = 0; s < count; s++) {
+                sums[s] = 0;
+            }
+            for (int k = 0; k < fixedCount; k++) {
+                if (row[k] == 0) continue;
+                long long numerator = row[k];
+                const long long* column = columns + k * count;
+                for (int s = 0; s < count; s++) {
+                    sums[s] += numerator * column[s];
+                }
+            }
+            for (int s = 0; s < count; s++) {
+                if (sums[s] != 0) sides[s * rows + r] = Rational(sums[s], denominators[r]);
+            }
+        }
+        return sides;
+    }
+
+    for (int s = 0; s < count; s++) {
+        for (int r = 0; r < rows; r++) {
+            for (int k = 0; k < fixedCount; k++) {
+                const Rational& cell = reduced[r * fixedCount + k];
+                if (cell.equals(0) || coefficients[s * fixedCount + k] == 0) continue;
+                Rational f(cell);
+                f.multiply(Rational(coefficients[s * fixedCount + k]));
+                sides[s * rows + r].add(f);
+            }
+        }
+    }
+    return sides;
+}
+
+/// Solves one scenario from its reduced right-hand side.
+///
+/// When the free molecules are independent, R is the identity above its
+/// zero rows, and solveReduced would set each coefficient to the negated
+/// right-hand side of its row. That is done directly whenever the
+/// scenario has a solution and no coefficient is negative, since
+/// solveReduced treats a negative coefficient as one it has yet to
+/// choose.
+
+Solution Factorization::solveSide(const Rational* sides) {
+    if (!valid) {
+        Solution solution(0, &scratch);
+        solution.setStatus(INVALID);
+        return solution;
+    }
+
+    bool direct = determined;
+    for (int i = 0; i < rows && direct; i++) {
+        direct = i < free ? sides[i].getNum().sign() <= 0 : sides[i].equals(0);
+    }
+    if (!direct) {
+        View view(*this, sides);
+        return solveReduced(view);
+    }
+
+    Solution solution(free, &scratch);
+    bool overflow = false;
+    for (int i = 0; i < free; i++) {
+        Rational value(sides[i]);
+        value.multiply(-1);
+        overflow = overflow || value.getOverflow();
+        solution.setValue(value, i);
+    }
+    solution.setStatus(overflow ? OVERFLOWED : SOLVED);
+    solution.setUnique(false);
+    return solution;
+}
+
+/// Balances the equation for one scenario.
+
+Solution Factorization::solve(const long long* coefficients) {
+    scratch.reset();
+    return solveSide(reduceBlock(coefficients, 1));
+}
+
+#endif
@@ -0,0 +1,136 @@
+///
+/// file: factor.hpp
+/// Header file for the Factorization class
+///
+/// @author Dominick Banasik
+
+#ifndef _FACTOR_H_
+#define _FACTOR_H_
+
+#include "rational.hpp"
+#include "solution.hpp"
+#include "matrix.hpp"
+#include "arena.hpp"
+#include "equation.hpp"
+
+/// The number of scenarios whose right-hand sides are made together.
+
+#define SCENARIO_BLOCK 64
+
+/// The Factorization class balances one equation for many choices of the
+/// coefficients of its fixed molecules, such as what each reactant would
+/// need if a product were fixed at 1, 2 or 3 mol. Only the right-hand
+/// side of the matrix changes between such scenarios, so the matrix of
+/// the free molecules is reduced once, side by side with the identity,
+/// which yields its rref R and the transform T with R = TA. The fixed
+/// molecules' columns F are reduced once as well, to TF. A scenario with
+/// coefficients c then has TFc as its reduced right-hand side, and is
+/// solved from R without reducing anything.
+///
+/// A block of scenarios multiplies TF by all of their coefficients at
+/// once, in 64-bit integers over a common denominator per row when they
+/// cannot overflow, and in rationals when they might. When the free
+/// molecules are independent, so the fixed ones determine them, that
+/// product already is the back-substitution, and each scenario's solution
+/// is read straight from it. Every scenario gets exactly what
+/// Equation::balance gives for the equation with those coefficients
+/// written in.
+
+class Factorization {
+    private:
+        class View;
+
+        Arena arena;
+        Arena scratch;
+        bool valid;
+        bool determined;
+        int rows;
+        int free;
+        int fixedCount;
+        int rank;
+        int* leads;
+        Rational* cells;
+        Rational* reduced;
+        long long* numerators;
+        long long* denominators;
+        long long largestNumerator;
+
+        /// Makes the reduced right-hand sides of a block of scenarios.
+        ///
+        /// @param coefficients the coefficients of the fixed molecules,
+        ///                     scenario by scenario
+        /// @param count the number of scenarios, at most SCENARIO_BLOCK
+        /// @return the right-hand sides, scenario by scenario, valid
+        ///         until the scratch arena is reset
+
+        Rational* reduceBlock(const long long* coefficients, int count);
+
+        /// Solves one scenario from its reduced right-hand side.
+        ///
+        /// @param sides the reduced right-hand side
+        /// @return the solution, valid until the scratch arena is reset
+
+        Solution solveSide(const Rational* sides);
+
+    public:
+        /// Constructor for the Factorization class. Reduces the matrix of
+        /// the free molecules of an equation, which need not outlive it.
+        ///
+        /// @param equation the equation
+        /// @param engine the elimination to reduce the matrix with
+
+        Factorization(Equation& equation, Engine engine = FRACTION_FREE);
+
+        Factorization(const Factorization& copy) = delete;
+        Factorization& operator=(const Factorization& copy) = delete;
+
+        /// Returns the number of fixed molecules, which is the number of
+        /// coefficients each scenario gives.
+        ///
+        /// @return the number of fixed molecules
+
+        int getFixedCount();
+
+        /// Returns the rank of the matrix of the free molecules.
+        ///
+        /// @return the rank
+
+        int getRank();
+
+        /// Balances the equation for one scenario.
+        ///
+        /// @param coefficients the coefficient of each fixed molecule, in
+        ///                     the order the molecules were given in
+        /// @return the solution, valid until the next scenario is solved
+
+        Solution solve(const long long* coefficients);
+
+        /// Balances the equation for each of a number of scenarios, a
+        /// block at a time.
+        ///
+        /// @tparam Body the type of the function to call
+        /// @param coefficients the coefficients of the fixed molecules,
+        ///                     scenario by scenario
+        /// @param count the number of scenarios
+        /// @param body the function to call with the index and solution of
+        ///             each scenario, which is valid until it returns
+
+        template <typename Body>
+        void solveAll(const long long* coefficients, int count, Body body);
+};
+
+/// Balances the equation for each of a number of scenarios.
+
+template <typename Body>
+void Factorization::solveAll(const long long* coefficients, int count, Body body) {
+    for (int start = 0; start < count; start += SCENARIO_BLOCK) {
+        int block = count - start < SCENARIO_BLOCK ? count - start : SCENARIO_BLOCK;
+        scratch.reset();
+        Rational* sides = reduceBlock(coefficients + (long) start * fixedCount, block);
+        for (int i = 0; i < block; i++) {
+            body(start + i, solveSide(sides + (long) i * rows));
+        }
+    }
+}
+
+#endif
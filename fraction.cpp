@@ -1,144 +1,246 @@
 ///
 /// file: fraction.cpp
-/// Implementation for the Fraction class
+/// Implementation for the Fraction class. The arithmetic is constexpr,
+/// so this file is included by fraction.hpp.
 ///
 /// @author Dominick Banasik
 
-#include <stdio.h>
-
 #include "fraction.hpp"
+#include "stats.hpp"
 
 #ifndef _FRACTION_IMPL_
 #define _FRACTION_IMPL_
 
-/// Computes the great common divisor of two numbers.
+/// Computes the greatest common divisor of two numbers with the binary
+/// algorithm, which takes time logarithmic in the numbers.
 ///
 /// @param m the first number
 /// @param n the second number
 /// @return the greatest common divisor
 
-int gcd(int m, int n) {
-    int i = 1;
-    int g = 1;
-    
-    while (i <= m && i <= n) {
-        if (m % i == 0 && n % i == 0) g = i;
-        i++;
+constexpr unsigned long long gcd(unsigned long long m, unsigned long long n) {
+    if (m == 0) return n;
+    if (n == 0) return m;
+
+    int shift = __builtin_ctzll(m | n);
+    m >>= __builtin_ctzll(m);
+
+    while (n) {
+        n >>= __builtin_ctzll(n);
+        if (m > n) {
+            unsigned long long tmp = m;
+            m = n;
+            n = tmp;
+        }
+        n -= m;
     }
 
-    return g;
+    return m << shift;
 }
 
-/// Computes the least common multiple of two numbers.
+/// Returns the absolute value of a number as an unsigned number, which
+/// cannot overflow.
 ///
-/// @param m the first number
-/// @param n the second number
-/// @return the least common multiple
+/// @param n the number
+/// @return the absolute value
 
-int lcm(int m, int n) {
-    int l = m > n ? m : n;
-    while (true) {
-        if (l % m == 0 && l % n == 0) {
-            return l;
-        }
-        l++;
-    }
+constexpr unsigned long long magnitude(long long n) {
+    return n < 0 ? 0ULL - (unsigned long long) n : (unsigned long long) n;
 }
 
-/// Returns the numerator of the fraction.
+/// Returns the numerator of the fraction in lowest terms.
 
-int Fraction::getNum() {
+constexpr long long Fraction::getNum() {
+    simplify();
     return numerator;
 }
 
-/// Returns the denominator of the fraction.
+/// Returns the denominator of the fraction in lowest terms.
 
-int Fraction::getDen() {
+constexpr long long Fraction::getDen() {
+    simplify();
     return denominator;
 }
 
-/// Simplifies the fraction.
+/// Checks whether an operation on the fraction overflowed.
 
-void Fraction::simplify() {
+constexpr bool Fraction::getOverflow() const {
+    return overflow;
+}
+
+/// Stores the result of a checked operation.
+
+constexpr void Fraction::check(bool failed) {
+    if (failed) overflow = true;
+}
+
+/// Brings the fraction to lowest terms.
+
+constexpr void Fraction::simplify() {
+    if (lowest) return;
+    lowest = true;
+    if (denominator == 1) return;
     if (numerator == 0) {
         denominator = 1;
         return;
     }
-    
-    int num = numerator > 0 ? numerator : -1 * numerator;
-    int den = denominator > 0 ? denominator : -1 * denominator;
 
-    int g = gcd(num, den);
+    STATS_NORMALIZED();
+    long long g = (long long) gcd(magnitude(numerator), (unsigned long long) denominator);
     if (g > 1) {
         numerator /= g;
         denominator /= g;
     }
+}
 
-    if (denominator < 0) {
-        numerator *= -1;
-        denominator *= -1;
+/// Multiplies the fraction by another. The products are kept unreduced
+/// unless one of them overflows, in which case both fractions are reduced
+/// and common factors cancelled before trying again.
+
+constexpr void Fraction::multiply(Fraction other) {
+    overflow |= other.overflow;
+
+    long long num = 0;
+    long long den = 0;
+    if (!__builtin_mul_overflow(numerator, other.numerator, &num)
+            && !__builtin_mul_overflow(denominator, other.denominator, &den)) {
+        numerator = num;
+        denominator = den;
+        lowest = den == 1;
+        return;
     }
+    multiplyReduced(other);
 }
 
-/// Multiplies the fraction by another.
+/// Multiplies the fraction by another in lowest terms.
 
-void Fraction::multiply(Fraction other) {
-    numerator = numerator * other.numerator;
-    denominator = denominator * other.denominator;
+constexpr void Fraction::multiplyReduced(Fraction other) {
     simplify();
+    other.simplify();
+
+    STATS_NORMALIZED();
+    long long g1 = (long long) gcd(magnitude(numerator), (unsigned long long) other.denominator);
+    long long g2 = (long long) gcd(magnitude(other.numerator), (unsigned long long) denominator);
+
+    check(__builtin_mul_overflow(numerator / g1, other.numerator / g2, &numerator));
+    check(__builtin_mul_overflow(denominator / g2, other.denominator / g1, &denominator));
 }
 
 /// Multiplies the fraction by a scalar.
 
-void Fraction::multiply(int scalar) {
-    numerator = numerator * scalar;
-    simplify();
+constexpr void Fraction::multiply(long long scalar) {
+    multiply(Fraction(scalar));
 }
 
-/// Adds another fraction.
+/// Adds another fraction. The denominators are cross multiplied without
+/// reducing unless a product overflows, in which case both fractions are
+/// reduced and added in lowest terms instead.
 
-void Fraction::add(Fraction other) {
-    int den1 = denominator > 0 ? denominator : -1 * denominator;
-    int den2 = other.denominator > 0 ? other.denominator : -1 * other.denominator;
-    int lcd = lcm(den1, den2);
-    
-    numerator = numerator * (lcd / denominator) + other.numerator * (lcd / other.denominator);
-    denominator = lcd;
+constexpr void Fraction::add(Fraction other) {
+    overflow |= other.overflow;
+
+    long long num = 0;
+    if (denominator == other.denominator) {
+        if (!__builtin_add_overflow(numerator, other.numerator, &num)) {
+            numerator = num;
+            lowest = denominator == 1;
+            return;
+        }
+        addReduced(other);
+        return;
+    }
+
+    long long left = 0;
+    long long right = 0;
+    long long den = 0;
+    if (!__builtin_mul_overflow(numerator, other.denominator, &left)
+            && !__builtin_mul_overflow(other.numerator, denominator, &right)
+            && !__builtin_add_overflow(left, right, &num)
+            && !__builtin_mul_overflow(denominator, other.denominator, &den)) {
+        numerator = num;
+        denominator = den;
+        lowest = den == 1;
+        return;
+    }
+    addReduced(other);
+}
+
+/// Adds another fraction in lowest terms. Rather than searching for the
+/// least common denominator, the denominators are cross multiplied after
+/// removing their common factor, which keeps the result in lowest terms.
+
+constexpr void Fraction::addReduced(Fraction other) {
     simplify();
+    other.simplify();
+
+    if (denominator == other.denominator) {
+        check(__builtin_add_overflow(numerator, other.numerator, &numerator));
+        lowest = false;
+        simplify();
+        return;
+    }
+
+    STATS_NORMALIZED();
+    long long g = (long long) gcd((unsigned long long) denominator, (unsigned long long) other.denominator);
+    long long left = 0;
+    long long right = 0;
+    check(__builtin_mul_overflow(numerator, other.denominator / g, &left));
+    check(__builtin_mul_overflow(other.numerator, denominator / g, &right));
+    check(__builtin_add_overflow(left, right, &numerator));
+
+    if (numerator == 0) {
+        denominator = 1;
+        return;
+    }
+    long long g2 = g == 1 ? 1 : (long long) gcd(magnitude(numerator), (unsigned long long) g);
+    numerator /= g2;
+    check(__builtin_mul_overflow(denominator / g, other.denominator / g2, &denominator));
 }
 
 /// Checks whether the fraction equals a decimal value.
 
-bool Fraction::equals(double d) {
+constexpr bool Fraction::equals(double d) {
+    if (d == 0) return numerator == 0;
+    simplify();
     return d == (double) numerator / (double) denominator;
 }
 
-/// Returns the reciprocal of the fraction.
+/// Returns a fraction that is already in lowest terms.
 
-Fraction Fraction::getReciprocal() {
-    return Fraction(denominator, numerator);
+constexpr Fraction Fraction::reduced(long long num, long long den) {
+    Fraction fraction(num);
+    fraction.denominator = den;
+    return fraction;
 }
 
-/// Copy constructor for the Fraction class.
+/// Returns the reciprocal of the fraction.
 
-Fraction::Fraction(const Fraction &copy) {
-    numerator = copy.numerator;
-    denominator = copy.denominator;
+constexpr Fraction Fraction::getReciprocal() const {
+    Fraction reciprocal(denominator, numerator);
+    reciprocal.overflow |= overflow;
+    return reciprocal;
 }
 
 /// Constructor for the Fraction class.
 
-Fraction::Fraction(int val) {
-    numerator = val;
-    denominator = 1;
+constexpr Fraction::Fraction(long long val)
+    : numerator(val), denominator(1), overflow(false), lowest(true) {
 }
 
-/// Constructor for the Fraction class.
+/// Constructor for the Fraction class. Only the sign is fixed here; the
+/// fraction is reduced when it is read.
 
-Fraction::Fraction(int num, int den) {
-    numerator = num;
-    denominator = den;
-    simplify();
+constexpr Fraction::Fraction(long long num, long long den)
+    : numerator(num), denominator(den), overflow(false), lowest(false) {
+    if (denominator == 0) {
+        overflow = true;
+        denominator = 1;
+        return;
+    }
+    if (denominator < 0) {
+        check(__builtin_sub_overflow(0, numerator, &numerator));
+        check(__builtin_sub_overflow(0, denominator, &denominator));
+    }
 }
 
 #endif
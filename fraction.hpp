@@ -7,77 +7,127 @@
 #ifndef _FRACTION_H_
 #define _FRACTION_H_
 
+/// The Fraction class represents a rational number as a pair of 64-bit
+/// integers with a positive denominator. Normalization is lazy: results
+/// are left unreduced and only brought to lowest terms when they are read,
+/// or when an operation would overflow without reducing first. Every
+/// operation checks for overflow; once a result no longer fits even in
+/// lowest terms, the fraction is marked as overflowed and its value is
+/// meaningless.
+
 class Fraction {
     private:
-        int numerator;
-        int denominator;
-         
-         /// Simplifies the fraction.
+        long long numerator;
+        long long denominator;
+        bool overflow;
+        bool lowest;
+
+        /// Brings the fraction to lowest terms.
+
+        constexpr void simplify();
+
+        /// Adds another fraction in lowest terms, cancelling the common
+        /// factor of the denominators so the products stay small.
+        ///
+        /// @param other the fraction to add
+
+        constexpr void addReduced(Fraction other);
+
+        /// Multiplies the fraction by another in lowest terms, cancelling
+        /// common factors across the two first.
+        ///
+        /// @param other the fraction to multiply by
+
+        constexpr void multiplyReduced(Fraction other);
+
+        /// Stores the result of a checked operation, marking the fraction
+        /// as overflowed if the operation did not fit.
+        ///
+        /// @param failed whether the operation overflowed
+
+        constexpr void check(bool failed);
 
-        void simplify();
-    
     public:
         /// Constructor for the Fraction class.
         ///
         /// @param num numerator of the fraction
         /// @param den denominator of the fraction
 
-        Fraction(int num, int den);
-        
+        constexpr Fraction(long long num, long long den);
+
         /// Constructor for the Fraction class.
         ///
         /// @param val value of the fraction
 
-        Fraction(int val);
+        constexpr Fraction(long long val);
 
         /// Copy constructor for the Fraction class.
         ///
         /// @param copy the fraction to copy
 
-        Fraction(const Fraction &copy);
-        
+        constexpr Fraction(const Fraction &copy) = default;
+
+        /// Returns a fraction from a numerator and a positive denominator
+        /// that are already in lowest terms, skipping simplification.
+        ///
+        /// @param num numerator of the fraction
+        /// @param den denominator of the fraction
+        /// @return the fraction
+
+        static constexpr Fraction reduced(long long num, long long den);
+
         /// Returns the reciprocal of the fraction.
         ///
         /// @return the reciprocal
 
-        Fraction getReciprocal();
+        constexpr Fraction getReciprocal() const;
 
-        /// Returns the numerator of the fraction.
+        /// Returns the numerator of the fraction in lowest terms, which
+        /// reduces the fraction first.
         ///
         /// @return the numerator
 
-        int getNum();
+        constexpr long long getNum();
 
-        /// Returns the denominator of the fraction.
+        /// Returns the denominator of the fraction in lowest terms, which
+        /// reduces the fraction first.
         ///
         /// @return the denominator
 
-        int getDen();
+        constexpr long long getDen();
+
+        /// Checks whether an operation on the fraction overflowed.
+        ///
+        /// @return whether or not the value is still exact
+
+        constexpr bool getOverflow() const;
 
         /// Multiplies the fraction by another.
         ///
         /// @param other the fraction to multiply by
 
-        void multiply(Fraction other);
-        
+        constexpr void multiply(Fraction other);
+
         /// Multiplies the fraction by a scalar.
         ///
         /// @param scalar the scalar to multiply by
 
-        void multiply(int scalar);
+        constexpr void multiply(long long scalar);
 
         /// Adds another fraction.
         ///
         /// @param other the fraction to add
 
-        void add(Fraction other);
-       
+        constexpr void add(Fraction other);
+
         /// Checks whether the fraction equals a decimal value.
         ///
         /// @param d the value to compare to
         /// @return whether or not the fraction is equal
 
-        bool equals(double d);
+        constexpr bool equals(double d);
 };
 
+#include "fraction.cpp"
+
 #endif
@@ -0,0 +1,109 @@
+///
+/// file: hash.cpp
+/// Implementation for 128-bit hashing
+///
+/// @author Dominick Banasik
+
+#include <string.h>
+
+#include "hash.hpp"
+
+#ifndef _HASH_IMPL_
+#define _HASH_IMPL_
+
+/// Rotates a word left.
+///
+/// @param x the word
+/// @param r the number of bits to rotate by
+/// @return the rotated word
+
+static inline unsigned long long rotate(unsigned long long x, int r) {
+    return (x << r) | (x >> (64 - r));
+}
+
+/// Mixes the bits of a word so every input bit affects every output bit.
+///
+/// @param k the word
+/// @return the mixed word
+
+static inline unsigned long long finalize(unsigned long long k) {
+    k ^= k >> 33;
+    k *= 0xff51afd7ed558ccdULL;
+    k ^= k >> 33;
+    k *= 0xc4ceb9fe1a85ec53ULL;
+    k ^= k >> 33;
+    return k;
+}
+
+/// Hashes a block of bytes with MurmurHash3 (x64, 128-bit).
+
+Hash128 hashBytes(const void* data, size_t length, unsigned long long seed) {
+    const unsigned long long c1 = 0x87c37b91114253d5ULL;
+    const unsigned long long c2 = 0x4cf5ad432745937fULL;
+    const unsigned char* bytes = (const unsigned char*) data;
+    size_t blocks = length / 16;
+    unsigned long long h1 = seed;
+    unsigned long long h2 = seed;
+
+    for (size_t i = 0; i < blocks; i++) {
+        unsigned long long k1;
+        unsigned long long k2;
+        memcpy(&k1, bytes + i * 16, 8);
+        memcpy(&k2, bytes + i * 16 + 8, 8);
+
+        k1 *= c1;
+        k1 = rotate(k1, 31);
+        k1 *= c2;
+        h1 ^= k1;
+        h1 = rotate(h1, 27);
+        h1 += h2;
+        h1 = h1 * 5 + 0x52dce729;
+
+        k2 *= c2;
+        k2 = rotate(k2, 33);
+        k2 *= c1;
+        h2 ^= k2;
+        h2 = rotate(h2, 31);
+        h2 += h1;
+        h2 = h2 * 5 + 0x38495ab5;
+    }
+
+    const unsigned char* tail = bytes + blocks * 16;
+    size_t rest = length & 15;
+    unsigned long long k1 = 0;
+    unsigned long long k2 = 0;
+    for (size_t i = rest; i > 8; i--) {
+        k2 ^= (unsigned long long) tail[i - 1] << ((i - 9) * 8);
+    }
+    for (size_t i = rest < 8 ? rest : 8; i > 0; i--) {
+        k1 ^= (unsigned long long) tail[i - 1] << ((i - 1) * 8);
+    }
+    if (rest > 8) {
+        k2 *= c2;
+        k2 = rotate(k2, 33);
+        k2 *= c1;
+        h2 ^= k2;
+    }
+    if (rest > 0) {
+        k1 *= c1;
+        k1 = rotate(k1, 31);
+        k1 *= c2;
+        h1 ^= k1;
+    }
+
+    h1 ^= length;
+    h2 ^= length;
+    h1 += h2;
+    h2 += h1;
+    h1 = finalize(h1);
+    h2 = finalize(h2);
+    h1 += h2;
+    h2 += h1;
+
+    Hash128 hash;
+    hash.low = h1;
+    hash.high = h2;
+    return hash;
+}
+
+#endif
@@ -0,0 +1,30 @@
+///
+/// file: hash.hpp
+/// Header file for 128-bit hashing
+///
+/// @author Dominick Banasik
+
+#ifndef _HASH_H_
+#define _HASH_H_
+
+#include <stddef.h>
+
+/// The Hash128 struct holds a 128-bit hash as two 64-bit halves.
+
+struct Hash128 {
+    unsigned long long low;
+    unsigned long long high;
+};
+
+/// Hashes a block of bytes with MurmurHash3 (x64, 128-bit). The hash is
+/// the same on every run and every little-endian machine, so it can name
+/// an equation across processes.
+///
+/// @param data the bytes to hash
+/// @param length the number of bytes
+/// @param seed the seed of the hash
+/// @return the hash
+
+Hash128 hashBytes(const void* data, size_t length, unsigned long long seed = 0);
+
+#endif
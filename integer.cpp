@@ -0,0 +1,495 @@
+///
+/// file: integer.cpp
+/// Implementation for the Integer class
+///
+/// @author Dominick Banasik
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "integer.hpp"
+#include "fraction.hpp"
+
+#ifndef _INTEGER_IMPL_
+#define _INTEGER_IMPL_
+
+#define LIMB_BITS 32
+#define DECIMAL_CHUNK 1000000000U
+
+/// Compares two magnitudes.
+///
+/// @param a the limbs of the first magnitude
+/// @param an the number of limbs in a
+/// @param b the limbs of the second magnitude
+/// @param bn the number of limbs in b
+/// @return a negative number, zero or a positive number
+
+static int compareMagnitude(const unsigned int* a, int an, const unsigned int* b, int bn) {
+    if (an != bn) return an < bn ? -1 : 1;
+    for (int i = an - 1; i >= 0; i--) {
+        if (a[i] != b[i]) return a[i] < b[i] ? -1 : 1;
+    }
+    return 0;
+}
+
+/// Adds two magnitudes.
+///
+/// @param a the limbs of the first magnitude
+/// @param an the number of limbs in a
+/// @param b the limbs of the second magnitude
+/// @param bn the number of limbs in b
+/// @param out where to store the sum, with room for max(an, bn) + 1 limbs
+/// @return the number of limbs in the sum
+
+static int addMagnitude(const unsigned int* a, int an, const unsigned int* b, int bn, unsigned int* out) {
+    if (an < bn) {
+        const unsigned int* tmp = a;
+        a = b;
+        b = tmp;
+        int tmpCount = an;
+        an = bn;
+        bn = tmpCount;
+    }
+
+    unsigned long long carry = 0;
+    for (int i = 0; i < an; i++) {
+        carry += (unsigned long long) a[i] + (i < bn ? b[i] : 0);
+        out[i] = (unsigned int) carry;
+        carry >>= LIMB_BITS;
+    }
+    out[an] = (unsigned int) carry;
+    return an + 1;
+}
+
+/// Subtracts a magnitude from a larger or equal one.
+///
+/// @param a the limbs of the larger magnitude
+/// @param an the number of limbs in a
+/// @param b the limbs of the smaller magnitude
+/// @param bn the number of limbs in b
+/// @param out where to store the difference, with room for an limbs
+/// @return the number of limbs in the difference
+
+static int subtractMagnitude(const unsigned int* a, int an, const unsigned int* b, int bn, unsigned int* out) {
+    long long borrow = 0;
+    for (int i = 0; i < an; i++) {
+        long long difference = (long long) a[i] - (i < bn ? b[i] : 0) - borrow;
+        borrow = difference < 0;
+        out[i] = (unsigned int) (difference + (borrow << LIMB_BITS));
+    }
+    return an;
+}
+
+/// Multiplies two magnitudes.
+///
+/// @param a the limbs of the first magnitude
+/// @param an the number of limbs in a
+/// @param b the limbs of the second magnitude
+/// @param bn the number of limbs in b
+/// @param out where to store the product, with room for an + bn limbs
+/// @return the number of limbs in the product
+
+static int multiplyMagnitude(const unsigned int* a, int an, const unsigned int* b, int bn, unsigned int* out) {
+    memset(out, 0, (an + bn) * sizeof(unsigned int));
+    for (int i = 0; i < an; i++) {
+        unsigned long long carry = 0;
+        for (int j = 0; j < bn; j++) {
+            carry += (unsigned long long) a[i] * b[j] + out[i + j];
+            out[i + j] = (unsigned int) carry;
+            carry >>= LIMB_BITS;
+        }
+        out[i + bn] = (unsigned int) carry;
+    }
+    return an + bn;
+}
+
+/// Divides one magnitude by another with Knuth's algorithm D.
+///
+/// @param u the limbs of the dividend
+/// @param un the number of limbs in u, at least vn
+/// @param v the limbs of the divisor, with a non-zero top limb
+/// @param vn the number of limbs in v
+/// @param q where to store the quotient, with room for un - vn + 1 limbs
+/// @param r where to store the remainder, with room for vn limbs
+
+static void divideMagnitude(const unsigned int* u, int un, const unsigned int* v, int vn,
+        unsigned int* q, unsigned int* r) {
+    const unsigned long long base = 1ULL << LIMB_BITS;
+
+    if (vn == 1) {
+        unsigned long long remainder = 0;
+        for (int i = un - 1; i >= 0; i--) {
+            unsigned long long current = (remainder << LIMB_BITS) | u[i];
+            q[i] = (unsigned int) (current / v[0]);
+            remainder = current % v[0];
+        }
+        r[0] = (unsigned int) remainder;
+        return;
+    }
+
+    int shift = __builtin_clz(v[vn - 1]);
+    unsigned int* vs = (unsigned int*) malloc(vn * sizeof(unsigned int));
+    unsigned int* us = (unsigned int*) malloc((un + 1) * sizeof(unsigned int));
+
+    for (int i = vn - 1; i > 0; i--) {
+        vs[i] = (v[i] << shift) | (unsigned int) ((unsigned long long) v[i - 1] >> (LIMB_BITS - shift));
+    }
+    vs[0] = v[0] << shift;
+    us[un] = (unsigned int) ((unsigned long long) u[un - 1] >> (LIMB_BITS - shift));
+    for (int i = un - 1; i > 0; i--) {
+        us[i] = (u[i] << shift) | (unsigned int) ((unsigned long long) u[i - 1] >> (LIMB_BITS - shift));
+    }
+    us[0] = u[0] << shift;
+
+    for (int j = un - vn; j >= 0; j--) {
+        unsigned long long numerator = ((unsigned long long) us[j + vn] << LIMB_BITS) | us[j + vn - 1];
+        unsigned long long qhat = numerator / vs[vn - 1];
+        unsigned long long rhat = numerator % vs[vn - 1];
+
+        while (qhat >= base || qhat * vs[vn - 2] > ((rhat << LIMB_BITS) | us[j + vn - 2])) {
+            qhat--;
+            rhat += vs[vn - 1];
+            if (rhat >= base) break;
+        }
+
+        long long borrow = 0;
+        long long t;
+        for (int i = 0; i < vn; i++) {
+            unsigned long long product = qhat * vs[i];
+            t = (long long) us[i + j] - borrow - (long long) (product & 0xFFFFFFFFULL);
+            us[i + j] = (unsigned int) t;
+            borrow = (long long) (product >> LIMB_BITS) - (t >> LIMB_BITS);
+        }
+        t = (long long) us[j + vn] - borrow;
+        us[j + vn] = (unsigned int) t;
+
+        q[j] = (unsigned int) qhat;
+        if (t < 0) {
+            q[j]--;
+            unsigned long long carry = 0;
+            for (int i = 0; i < vn; i++) {
+                carry += (unsigned long long) us[i + j] + vs[i];
+                us[i + j] = (unsigned int) carry;
+                carry >>= LIMB_BITS;
+            }
+            us[j + vn] += (unsigned int) carry;
+        }
+    }
+
+    for (int i = 0; i < vn - 1; i++) {
+        r[i] = (us[i] >> shift) | (unsigned int) ((unsigned long long) us[i + 1] << (LIMB_BITS - shift));
+    }
+    r[vn - 1] = us[vn - 1] >> shift;
+
+    free(vs);
+    free(us);
+}
+
+/// Frees the limbs of the integer, if it has any.
+
+void Integer::release() {
+    free(limbs);
+    limbs = NULL;
+    size = 0;
+    capacity = 0;
+}
+
+/// Returns the magnitude of the integer as an array of limbs.
+
+const unsigned int* Integer::getMagnitude(unsigned int* scratch, int* count) const {
+    if (limbs) {
+        *count = size < 0 ? -size : size;
+        return limbs;
+    }
+
+    unsigned long long value = magnitude(small);
+    scratch[0] = (unsigned int) value;
+    scratch[1] = (unsigned int) (value >> LIMB_BITS);
+    *count = scratch[1] ? 2 : (scratch[0] ? 1 : 0);
+    return scratch;
+}
+
+/// Takes ownership of an array of limbs as the new value.
+
+void Integer::adopt(unsigned int* digits, int count, int allocated, bool negative) {
+    while (count > 0 && digits[count - 1] == 0) count--;
+
+    if (count <= 2) {
+        unsigned long long value = 0;
+        if (count > 0) value = digits[0];
+        if (count > 1) value |= (unsigned long long) digits[1] << LIMB_BITS;
+
+        if (value <= 9223372036854775807ULL || (negative && value == 9223372036854775808ULL)) {
+            free(digits);
+            if (limbs) release();
+            small = negative ? (long long) (0ULL - value) : (long long) value;
+            return;
+        }
+    }
+
+    if (limbs) release();
+    limbs = digits;
+    size = negative ? -count : count;
+    capacity = allocated;
+    small = 0;
+}
+
+/// Adds or subtracts another integer.
+
+void Integer::addSlow(const Integer& other, bool subtract) {
+    unsigned int scratchA[2];
+    unsigned int scratchB[2];
+    int an;
+    int bn;
+    const unsigned int* a = getMagnitude(scratchA, &an);
+    const unsigned int* b = other.getMagnitude(scratchB, &bn);
+    bool negativeA = sign() < 0;
+    bool negativeB = (other.sign() < 0) != subtract;
+
+    int allocated = (an > bn ? an : bn) + 1;
+    unsigned int* out = (unsigned int*) malloc(allocated * sizeof(unsigned int));
+    int count;
+    bool negative;
+
+    if (negativeA == negativeB) {
+        count = addMagnitude(a, an, b, bn, out);
+        negative = negativeA;
+    } else if (compareMagnitude(a, an, b, bn) >= 0) {
+        count = subtractMagnitude(a, an, b, bn, out);
+        negative = negativeA;
+    } else {
+        count = subtractMagnitude(b, bn, a, an, out);
+        negative = negativeB;
+    }
+
+    adopt(out, count, allocated, negative);
+}
+
+/// Multiplies by another integer.
+
+void Integer::multiplySlow(const Integer& other) {
+    unsigned int scratchA[2];
+    unsigned int scratchB[2];
+    int an;
+    int bn;
+    const unsigned int* a = getMagnitude(scratchA, &an);
+    const unsigned int* b = other.getMagnitude(scratchB, &bn);
+    bool negative = (sign() < 0) != (other.sign() < 0);
+
+    if (an == 0 || bn == 0) {
+        *this = 0;
+        return;
+    }
+
+    unsigned int* out = (unsigned int*) malloc((an + bn) * sizeof(unsigned int));
+    int count = multiplyMagnitude(a, an, b, bn, out);
+    adopt(out, count, an + bn, negative);
+}
+
+/// Divides by another integer, rounding toward zero.
+
+void Integer::divideSlow(const Integer& divisor, Integer* remainder) {
+    unsigned int scratchA[2];
+    unsigned int scratchB[2];
+    int an;
+    int bn;
+    const unsigned int* a = getMagnitude(scratchA, &an);
+    const unsigned int* b = divisor.getMagnitude(scratchB, &bn);
+    bool negativeA = sign() < 0;
+    bool negativeQ = negativeA != (divisor.sign() < 0);
+
+    if (compareMagnitude(a, an, b, bn) < 0) {
+        if (remainder) *remainder = *this;
+        *this = 0;
+        return;
+    }
+
+    unsigned int* q = (unsigned int*) malloc((an - bn + 1) * sizeof(unsigned int));
+    unsigned int* r = (unsigned int*) malloc(bn * sizeof(unsigned int));
+    divideMagnitude(a, an, b, bn, q, r);
+
+    if (remainder) {
+        remainder->adopt(r, bn, bn, negativeA);
+    } else {
+        free(r);
+    }
+    adopt(q, an - bn + 1, an - bn + 1, negativeQ);
+}
+
+/// Compares the integer to another.
+
+int Integer::compare(const Integer& other) const {
+    if (!limbs && !other.limbs) return (small > other.small) - (small < other.small);
+
+    int signA = sign();
+    int signB = other.sign();
+    if (signA != signB) return signA < signB ? -1 : 1;
+
+    unsigned int scratchA[2];
+    unsigned int scratchB[2];
+    int an;
+    int bn;
+    const unsigned int* a = getMagnitude(scratchA, &an);
+    const unsigned int* b = other.getMagnitude(scratchB, &bn);
+    int result = compareMagnitude(a, an, b, bn);
+    return signA < 0 ? -result : result;
+}
+
+/// Returns the number of bits in the magnitude of the integer.
+
+int Integer::bitLength() const {
+    if (!limbs) {
+        unsigned long long value = magnitude(small);
+        return value ? 64 - __builtin_clzll(value) : 0;
+    }
+
+    int count = size < 0 ? -size : size;
+    return LIMB_BITS * count - __builtin_clz(limbs[count - 1]);
+}
+
+/// Returns the least non-negative residue of the integer modulo a word.
+
+unsigned int Integer::modulo(unsigned int modulus) const {
+    unsigned int scratch[2];
+    int count;
+    const unsigned int* digits = getMagnitude(scratch, &count);
+
+    unsigned long long residue = 0;
+    for (int i = count - 1; i >= 0; i--) {
+        residue = ((residue << LIMB_BITS) | digits[i]) % modulus;
+    }
+    if (sign() < 0 && residue != 0) residue = modulus - residue;
+    return (unsigned int) residue;
+}
+
+/// Negates the integer.
+
+void Integer::negate() {
+    if (!limbs && small != (-9223372036854775807LL - 1)) {
+        small = -small;
+        return;
+    }
+
+    unsigned int scratch[2];
+    int count;
+    const unsigned int* digits = getMagnitude(scratch, &count);
+    unsigned int* copy = (unsigned int*) malloc(count * sizeof(unsigned int));
+    memcpy(copy, digits, count * sizeof(unsigned int));
+    adopt(copy, count, count, sign() > 0);
+}
+
+/// Returns the value of the integer as a double.
+
+double Integer::toDouble() const {
+    if (!limbs) return (double) small;
+
+    int count = size < 0 ? -size : size;
+    double value = 0;
+    for (int i = count - 1; i >= 0; i--) {
+        value = ldexp(value, LIMB_BITS) + limbs[i];
+    }
+    return size < 0 ? -value : value;
+}
+
+/// Appends the decimal representation of the integer to a string.
+
+void Integer::toString(std::string& output) const {
+    char buffer[24];
+
+    if (!limbs) {
+        snprintf(buffer, sizeof(buffer), "%lld", small);
+        output += buffer;
+        return;
+    }
+
+    int count = size < 0 ? -size : size;
+    unsigned int* digits = (unsigned int*) malloc(count * sizeof(unsigned int));
+    unsigned int* chunks = (unsigned int*) malloc((count * 2 + 1) * sizeof(unsigned int));
+    int chunkCount = 0;
+    memcpy(digits, limbs, count * sizeof(unsigned int));
+
+    do {
+        unsigned long long remainder = 0;
+        for (int i = count - 1; i >= 0; i--) {
+            unsigned long long current = (remainder << LIMB_BITS) | digits[i];
+            digits[i] = (unsigned int) (current / DECIMAL_CHUNK);
+            remainder = current % DECIMAL_CHUNK;
+        }
+        chunks[chunkCount++] = (unsigned int) remainder;
+        while (count > 0 && digits[count - 1] == 0) count--;
+    } while (count > 0);
+
+    if (size < 0) output += '-';
+    snprintf(buffer, sizeof(buffer), "%u", chunks[chunkCount - 1]);
+    output += buffer;
+    for (int i = chunkCount - 2; i >= 0; i--) {
+        snprintf(buffer, sizeof(buffer), "%09u", chunks[i]);
+        output += buffer;
+    }
+
+    free(digits);
+    free(chunks);
+}
+
+/// Computes the greatest common divisor of two integers.
+
+Integer Integer::gcd(const Integer& m, const Integer& n) {
+    Integer a(m);
+    Integer b(n);
+    if (a.sign() < 0) a.negate();
+    if (b.sign() < 0) b.negate();
+
+    while (!b.isZero()) {
+        if (a.isSmall() && b.isSmall()) {
+            return Integer((long long) ::gcd((unsigned long long) a.small, (unsigned long long) b.small));
+        }
+        Integer remainder;
+        a.divide(b, &remainder);
+        a = static_cast<Integer&&>(b);
+        b = static_cast<Integer&&>(remainder);
+    }
+
+    return a;
+}
+
+/// Assignment operator for the Integer class.
+
+Integer& Integer::operator=(const Integer& copy) {
+    if (this == &copy) return *this;
+
+    if (!copy.limbs) {
+        if (limbs) release();
+        small = copy.small;
+        return *this;
+    }
+
+    int count = copy.size < 0 ? -copy.size : copy.size;
+    if (capacity < count) {
+        free(limbs);
+        limbs = (unsigned int*) malloc(count * sizeof(unsigned int));
+        capacity = count;
+    }
+    memcpy(limbs, copy.limbs, count * sizeof(unsigned int));
+    size = copy.size;
+    small = 0;
+    return *this;
+}
+
+/// Move assignment operator for the Integer class.
+
+Integer& Integer::operator=(Integer&& other) {
+    if (this == &other) return *this;
+
+    if (limbs) release();
+    small = other.small;
+    limbs = other.limbs;
+    size = other.size;
+    capacity = other.capacity;
+    other.limbs = NULL;
+    other.small = 0;
+    return *this;
+}
+
+#endif
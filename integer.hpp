@@ -0,0 +1,322 @@
+///
+/// file: integer.hpp
+/// Header file for the Integer class
+///
+/// @author Dominick Banasik
+
+#ifndef _INTEGER_H_
+#define _INTEGER_H_
+
+#include <string>
+
+/// The Integer class represents an integer of any size. While the value
+/// fits in a machine word it is stored inline and arithmetic on it is a
+/// single checked instruction; a result that overflows is promoted to a
+/// heap array of 32-bit limbs, and demoted again once it fits.
+
+class Integer {
+    private:
+        long long small;
+        unsigned int* limbs;
+        int size;
+        int capacity;
+
+        /// Adds or subtracts another integer when either value is stored
+        /// in limbs or the machine word result overflowed.
+        ///
+        /// @param other the integer to add or subtract
+        /// @param subtract whether to subtract rather than add
+
+        void addSlow(const Integer& other, bool subtract);
+
+        /// Multiplies by another integer when either value is stored in
+        /// limbs or the machine word result overflowed.
+        ///
+        /// @param other the integer to multiply by
+
+        void multiplySlow(const Integer& other);
+
+        /// Divides by another integer when either value is stored in limbs.
+        ///
+        /// @param divisor the integer to divide by
+        /// @param remainder where to store the remainder, or NULL
+
+        void divideSlow(const Integer& divisor, Integer* remainder);
+
+        /// Returns the magnitude of the integer as an array of limbs, least
+        /// significant first.
+        ///
+        /// @param scratch two limbs to hold the magnitude of a small value
+        /// @param count where to store the number of limbs
+        /// @return the limbs of the magnitude
+
+        const unsigned int* getMagnitude(unsigned int* scratch, int* count) const;
+
+        /// Takes ownership of an array of limbs as the new value, storing it
+        /// inline instead if it fits in a machine word.
+        ///
+        /// @param digits the limbs of the magnitude, least significant first
+        /// @param count the number of limbs
+        /// @param allocated the number of limbs allocated for digits
+        /// @param negative whether the value is negative
+
+        void adopt(unsigned int* digits, int count, int allocated, bool negative);
+
+        /// Frees the limbs of the integer, if it has any.
+
+        void release();
+
+    public:
+        /// Constructor for the Integer class.
+        ///
+        /// @param value the value of the integer
+
+        Integer(long long value = 0);
+
+        /// Copy constructor for the Integer class.
+        ///
+        /// @param copy the integer to copy
+
+        Integer(const Integer& copy);
+
+        /// Move constructor for the Integer class.
+        ///
+        /// @param other the integer to take the value of
+
+        Integer(Integer&& other);
+
+        /// Destructor for the Integer class.
+
+        ~Integer();
+
+        /// Assignment operator for the Integer class.
+        ///
+        /// @param copy the integer to copy
+        /// @return this integer
+
+        Integer& operator=(const Integer& copy);
+
+        /// Move assignment operator for the Integer class.
+        ///
+        /// @param other the integer to take the value of
+        /// @return this integer
+
+        Integer& operator=(Integer&& other);
+
+        /// Assigns a machine word value to the integer.
+        ///
+        /// @param value the value to assign
+        /// @return this integer
+
+        Integer& operator=(long long value);
+
+        /// Checks whether the value is stored inline in a machine word.
+        ///
+        /// @return whether or not the integer is small
+
+        bool isSmall() const;
+
+        /// Returns the value of a small integer.
+        ///
+        /// @return the value as a machine word
+
+        long long toLong() const;
+
+        /// Returns the sign of the integer.
+        ///
+        /// @return -1, 0 or 1
+
+        int sign() const;
+
+        /// Checks whether the integer is zero.
+        ///
+        /// @return whether or not the integer is zero
+
+        bool isZero() const;
+
+        /// Checks whether the integer is one.
+        ///
+        /// @return whether or not the integer is one
+
+        bool isOne() const;
+
+        /// Compares the integer to another.
+        ///
+        /// @param other the integer to compare to
+        /// @return a negative number, zero or a positive number
+
+        int compare(const Integer& other) const;
+
+        /// Returns the number of bits in the magnitude of the integer.
+        ///
+        /// @return the bit length
+
+        int bitLength() const;
+
+        /// Returns the least non-negative residue of the integer modulo a
+        /// machine word.
+        ///
+        /// @param modulus the non-zero modulus
+        /// @return the residue
+
+        unsigned int modulo(unsigned int modulus) const;
+
+        /// Negates the integer.
+
+        void negate();
+
+        /// Adds another integer.
+        ///
+        /// @param other the integer to add
+
+        void add(const Integer& other);
+
+        /// Subtracts another integer.
+        ///
+        /// @param other the integer to subtract
+
+        void subtract(const Integer& other);
+
+        /// Multiplies by another integer.
+        ///
+        /// @param other the integer to multiply by
+
+        void multiply(const Integer& other);
+
+        /// Divides by another integer, rounding toward zero.
+        ///
+        /// @param divisor the non-zero integer to divide by
+        /// @param remainder where to store the remainder, or NULL
+
+        void divide(const Integer& divisor, Integer* remainder = NULL);
+
+        /// Returns the value of the integer as a double.
+        ///
+        /// @return the nearest double
+
+        double toDouble() const;
+
+        /// Appends the decimal representation of the integer to a string.
+        ///
+        /// @param output the string to append to
+
+        void toString(std::string& output) const;
+
+        /// Computes the greatest common divisor of two integers.
+        ///
+        /// @param m the first integer
+        /// @param n the second integer
+        /// @return the non-negative greatest common divisor
+
+        static Integer gcd(const Integer& m, const Integer& n);
+};
+
+/// Checks whether the value is stored inline in a machine word.
+
+inline bool Integer::isSmall() const {
+    return limbs == NULL;
+}
+
+/// Returns the value of a small integer.
+
+inline long long Integer::toLong() const {
+    return small;
+}
+
+/// Checks whether the integer is zero.
+
+inline bool Integer::isZero() const {
+    return limbs == NULL && small == 0;
+}
+
+/// Checks whether the integer is one.
+
+inline bool Integer::isOne() const {
+    return limbs == NULL && small == 1;
+}
+
+/// Returns the sign of the integer.
+
+inline int Integer::sign() const {
+    if (limbs) return size < 0 ? -1 : 1;
+    return (small > 0) - (small < 0);
+}
+
+/// Adds another integer.
+
+inline void Integer::add(const Integer& other) {
+    long long result;
+    if (!limbs && !other.limbs && !__builtin_add_overflow(small, other.small, &result)) {
+        small = result;
+        return;
+    }
+    addSlow(other, false);
+}
+
+/// Subtracts another integer.
+
+inline void Integer::subtract(const Integer& other) {
+    long long result;
+    if (!limbs && !other.limbs && !__builtin_sub_overflow(small, other.small, &result)) {
+        small = result;
+        return;
+    }
+    addSlow(other, true);
+}
+
+/// Multiplies by another integer.
+
+inline void Integer::multiply(const Integer& other) {
+    long long result;
+    if (!limbs && !other.limbs && !__builtin_mul_overflow(small, other.small, &result)) {
+        small = result;
+        return;
+    }
+    multiplySlow(other);
+}
+
+/// Divides by another integer, rounding toward zero.
+
+inline void Integer::divide(const Integer& divisor, Integer* remainder) {
+    if (!limbs && !divisor.limbs && !(small == (-9223372036854775807LL - 1) && divisor.small == -1)) {
+        if (remainder) *remainder = small % divisor.small;
+        small /= divisor.small;
+        return;
+    }
+    divideSlow(divisor, remainder);
+}
+
+/// Constructor for the Integer class.
+
+inline Integer::Integer(long long value) : small(value), limbs(NULL), size(0), capacity(0) {
+}
+
+/// Copy constructor for the Integer class.
+
+inline Integer::Integer(const Integer& copy) : small(copy.small), limbs(NULL), size(0), capacity(0) {
+    if (copy.limbs) *this = copy;
+}
+
+/// Move constructor for the Integer class.
+
+inline Integer::Integer(Integer&& other)
+    : small(other.small), limbs(other.limbs), size(other.size), capacity(other.capacity) {
+    other.limbs = NULL;
+    other.small = 0;
+}
+
+/// Destructor for the Integer class.
+
+inline Integer::~Integer() {
+    if (limbs) release();
+}
+
+/// Assigns a machine word value to the integer.
+
+inline Integer& Integer::operator=(long long value) {
+    if (limbs) release();
+    small = value;
+    return *this;
+}
+
+#endif
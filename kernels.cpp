@@ -0,0 +1,434 @@
+///
+/// file: kernels.cpp
+/// Implementation for the Kernels class
+///
+/// @author Dominick Banasik
+
+#include <stddef.h>
+#include <string.h>
+
+#include "kernels.hpp"
+
+#ifdef KERNELS_X86
+#include <immintrin.h>
+#endif
+
+#ifndef _KERNELS_IMPL_
+#define _KERNELS_IMPL_
+
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#define TARGET_AVX512 __attribute__((target("avx512f")))
+
+/// Splits a divisor into the shift and odd inverse that divide by it
+/// exactly: when divisor divides x, x / divisor is (x >> shift) * inverse
+/// modulo 2^32. Vector units have no integer division, but an exact one
+/// is a shift and a multiplication.
+///
+/// @param divisor the divisor, not zero
+/// @param shift where to store the number of trailing zero bits
+/// @param inverse where to store the signed inverse of the odd part
+
+static inline void exactDivisor(int divisor, int& shift, unsigned int& inverse) {
+    unsigned int magnitude = divisor < 0 ? 0U - (unsigned int) divisor : (unsigned int) divisor;
+    shift = __builtin_ctz(magnitude);
+    unsigned int odd = magnitude >> shift;
+
+    // Each Newton step doubles the bits of the inverse that are right,
+    // starting from the three that odd * odd = 1 modulo 8 gives.
+    unsigned int result = odd;
+    for (int i = 0; i < 4; i++) {
+        result *= 2 - odd * result;
+    }
+    inverse = divisor < 0 ? 0U - result : result;
+}
+
+/// Adds a multiple of one row to another modulo a prime, one entry at a
+/// time.
+
+static void addScaledModScalar(unsigned int* row, const unsigned int* source, int count, unsigned int factor,
+        unsigned int prime) {
+    unsigned long long quotient = shoup(factor, prime);
+    for (int j = 0; j < count; j++) {
+        unsigned int value = row[j] + multiplyMod(source[j], factor, quotient, prime);
+        row[j] = value >= prime ? value - prime : value;
+    }
+}
+
+/// Multiplies a row by a factor modulo a prime, one entry at a time.
+
+static void scaleModScalar(unsigned int* row, int count, unsigned int factor, unsigned int prime) {
+    unsigned long long quotient = shoup(factor, prime);
+    for (int j = 0; j < count; j++) {
+        row[j] = multiplyMod(row[j], factor, quotient, prime);
+    }
+}
+
+/// Counts the non-zero entries of a row one at a time.
+
+static int countNonzeroScalar(const unsigned int* row, int count) {
+    int nonzero = 0;
+    for (int j = 0; j < count; j++) {
+        nonzero += row[j] != 0;
+    }
+    return nonzero;
+}
+
+/// Applies one Bareiss step to a row one cell at a time.
+
+static void bareissIntScalar(int* row, const int* pivotRow, int count, int pivot, int factor, int prev) {
+    for (int j = 0; j < count; j++) {
+        row[j] = (int) (((long long) pivot * row[j] - (long long) factor * pivotRow[j]) / prev);
+    }
+}
+
+/// Applies one Bareiss step to a row of 16-bit cells one cell at a time.
+
+static void bareissShortScalar(short* row, const short* pivotRow, int count, short pivot, short factor,
+        short prev) {
+    for (int j = 0; j < count; j++) {
+        row[j] = (short) (((int) pivot * row[j] - (int) factor * pivotRow[j]) / prev);
+    }
+}
+
+/// Finds the bytes of a block that equal a byte eight at a time, in
+/// 64-bit words. A byte of a word xor the byte is zero exactly where they
+/// are equal, and adding 0x7F to its low seven bits carries into its high
+/// bit unless it is zero. The high bits left clear are gathered into the
+/// low byte by one multiplication.
+
+static unsigned long long matchBytesScalar(const char* text, char byte) {
+    const unsigned long long low = 0x7F7F7F7F7F7F7F7FULL;
+    unsigned long long pattern = 0x0101010101010101ULL * (unsigned char) byte;
+    unsigned long long mask = 0;
+    for (int j = 0; j < MATCH_BLOCK; j += 8) {
+        unsigned long long word;
+        memcpy(&word, text + j, 8);
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+        word = __builtin_bswap64(word);
+#endif
+        word ^= pattern;
+        unsigned long long zero = ~(((word & low) + low) | word | low);
+        mask |= ((zero >> 7) * 0x0102040810204080ULL >> 56) << j;
+    }
+    return mask;
+}
+
+static const KernelTable SCALAR_KERNELS = {
+    addScaledModScalar, scaleModScalar, countNonzeroScalar, bareissIntScalar, bareissShortScalar,
+    matchBytesScalar
+};
+
+#ifdef KERNELS_X86
+
+/// Multiplies eight entries by a fixed factor modulo a prime with Shoup's
+/// method. The high half of value * quotient comes from two widening
+/// multiplications, one for the even lanes and one for the odd; the rest
+/// only needs the low 32 bits, since the result is below 2 * prime.
+
+TARGET_AVX2 static inline __m256i multiplyModAvx2(__m256i value, __m256i factor, __m256i quotient,
+        __m256i prime) {
+    __m256i even = _mm256_srli_epi64(_mm256_mul_epu32(value, quotient), 32);
+    __m256i odd = _mm256_mul_epu32(_mm256_srli_epi64(value, 32), quotient);
+    __m256i estimate = _mm256_blend_epi32(even, odd, 0xAA);
+    __m256i result = _mm256_sub_epi32(_mm256_mullo_epi32(value, factor), _mm256_mullo_epi32(estimate, prime));
+    return _mm256_min_epu32(result, _mm256_sub_epi32(result, prime));
+}
+
+/// Adds a multiple of one row to another modulo a prime, eight entries at
+/// a time.
+
+TARGET_AVX2 static void addScaledModAvx2(unsigned int* row, const unsigned int* source, int count,
+        unsigned int factor, unsigned int prime) {
+    __m256i f = _mm256_set1_epi32((int) factor);
+    __m256i q = _mm256_set1_epi32((int) shoup(factor, prime));
+    __m256i p = _mm256_set1_epi32((int) prime);
+    int j = 0;
+    for (; j + 8 <= count; j += 8) {
+        __m256i value = _mm256_loadu_si256((const __m256i*) &source[j]);
+        __m256i sum = _mm256_add_epi32(_mm256_loadu_si256((const __m256i*) &row[j]),
+                multiplyModAvx2(value, f, q, p));
+        _mm256_storeu_si256((__m256i*) &row[j], _mm256_min_epu32(sum, _mm256_sub_epi32(sum, p)));
+    }
+    addScaledModScalar(row + j, source + j, count - j, factor, prime);
+}
+
+/// Multiplies a row by a factor modulo a prime, eight entries at a time.
+
+TARGET_AVX2 static void scaleModAvx2(unsigned int* row, int count, unsigned int factor, unsigned int prime) {
+    __m256i f = _mm256_set1_epi32((int) factor);
+    __m256i q = _mm256_set1_epi32((int) shoup(factor, prime));
+    __m256i p = _mm256_set1_epi32((int) prime);
+    int j = 0;
+    for (; j + 8 <= count; j += 8) {
+        __m256i value = _mm256_loadu_si256((const __m256i*) &row[j]);
+        _mm256_storeu_si256((__m256i*) &row[j], multiplyModAvx2(value, f, q, p));
+    }
+    scaleModScalar(row + j, count - j, factor, prime);
+}
+
+/// Counts the non-zero entries of a row eight at a time.
+
+TARGET_AVX2 static int countNonzeroAvx2(const unsigned int* row, int count) {
+    __m256i zero = _mm256_setzero_si256();
+    int zeros = 0;
+    int j = 0;
+    for (; j + 8 <= count; j += 8) {
+        __m256i value = _mm256_loadu_si256((const __m256i*) &row[j]);
+        zeros += __builtin_popcount(_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(value, zero))));
+    }
+    return j - zeros + countNonzeroScalar(row + j, count - j);
+}
+
+/// Applies one Bareiss step to a row eight cells at a time. The products
+/// are formed in 64 bits, even and odd lanes apart, and divided exactly
+/// by a shift and a multiplication by the inverse of the odd part.
+
+TARGET_AVX2 static void bareissIntAvx2(int* row, const int* pivotRow, int count, int pivot, int factor,
+        int prev) {
+    int shift;
+    unsigned int inverse;
+    exactDivisor(prev, shift, inverse);
+
+    __m256i p = _mm256_set1_epi32(pivot);
+    __m256i f = _mm256_set1_epi32(factor);
+    __m256i inv = _mm256_set1_epi32((int) inverse);
+    __m128i s = _mm_cvtsi32_si128(shift);
+    int j = 0;
+    for (; j + 8 <= count; j += 8) {
+        __m256i cell = _mm256_loadu_si256((const __m256i*) &row[j]);
+        __m256i other = _mm256_loadu_si256((const __m256i*) &pivotRow[j]);
+        __m256i even = _mm256_sub_epi64(_mm256_mul_epi32(cell, p), _mm256_mul_epi32(other, f));
+        __m256i odd = _mm256_sub_epi64(_mm256_mul_epi32(_mm256_srli_epi64(cell, 32), p),
+                _mm256_mul_epi32(_mm256_srli_epi64(other, 32), f));
+        even = _mm256_srl_epi64(even, s);
+        odd = _mm256_slli_epi64(_mm256_srl_epi64(odd, s), 32);
+        __m256i value = _mm256_mullo_epi32(_mm256_blend_epi32(even, odd, 0xAA), inv);
+        _mm256_storeu_si256((__m256i*) &row[j], value);
+    }
+    bareissIntScalar(row + j, pivotRow + j, count - j, pivot, factor, prev);
+}
+
+/// Applies one Bareiss step to a row of 16-bit cells eight cells at a
+/// time. Products of 16-bit cells fit in 32 bits, so no widening is
+/// needed past that.
+
+TARGET_AVX2 static void bareissShortAvx2(short* row, const short* pivotRow, int count, short pivot, short factor,
+        short prev) {
+    int shift;
+    unsigned int inverse;
+    exactDivisor(prev, shift, inverse);
+
+    __m256i p = _mm256_set1_epi32(pivot);
+    __m256i f = _mm256_set1_epi32(factor);
+    __m256i inv = _mm256_set1_epi32((int) inverse);
+    __m128i s = _mm_cvtsi32_si128(shift);
+    int j = 0;
+    for (; j + 8 <= count; j += 8) {
+        __m256i cell = _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i*) &row[j]));
+        __m256i other = _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i*) &pivotRow[j]));
+        __m256i value = _mm256_sub_epi32(_mm256_mullo_epi32(cell, p), _mm256_mullo_epi32(other, f));
+        value = _mm256_mullo_epi32(_mm256_sra_epi32(value, s), inv);
+        __m128i packed = _mm_packs_epi32(_mm256_castsi256_si128(value), _mm256_extracti128_si256(value, 1));
+        _mm_storeu_si128((__m128i*) &row[j], packed);
+    }
+    bareissShortScalar(row + j, pivotRow + j, count - j, pivot, factor, prev);
+}
+
+/// Finds the bytes of a block that equal a byte thirty-two at a time.
+
+TARGET_AVX2 static unsigned long long matchBytesAvx2(const char* text, char byte) {
+    __m256i b = _mm256_set1_epi8(byte);
+    unsigned int low = _mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*) text), b));
+    unsigned int high = _mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*) (text + 32)),
+            b));
+    return (unsigned long long) high << 32 | low;
+}
+
+static const KernelTable AVX2_KERNELS = {
+    addScaledModAvx2, scaleModAvx2, countNonzeroAvx2, bareissIntAvx2, bareissShortAvx2, matchBytesAvx2
+};
+
+// GCC 12's AVX-512 intrinsics seed their results from a self-initialized
+// register, which -Wmaybe-uninitialized mistakes for a real read.
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+
+/// Returns the mask of the lanes that hold entries when a number of
+/// entries remain.
+///
+/// @param remaining the number of entries left
+/// @return the mask of the first min(remaining, 16) lanes
+
+static inline __mmask16 laneMask(int remaining) {
+    return remaining >= 16 ? 0xFFFF : (__mmask16) ((1U << remaining) - 1);
+}
+
+/// Multiplies sixteen entries by a fixed factor modulo a prime with
+/// Shoup's method.
+
+TARGET_AVX512 static inline __m512i multiplyModAvx512(__m512i value, __m512i factor, __m512i quotient,
+        __m512i prime) {
+    __m512i even = _mm512_srli_epi64(_mm512_mul_epu32(value, quotient), 32);
+    __m512i odd = _mm512_mul_epu32(_mm512_srli_epi64(value, 32), quotient);
+    __m512i estimate = _mm512_mask_blend_epi32(0xAAAA, even, odd);
+    __m512i result = _mm512_sub_epi32(_mm512_mullo_epi32(value, factor), _mm512_mullo_epi32(estimate, prime));
+    return _mm512_min_epu32(result, _mm512_sub_epi32(result, prime));
+}
+
+/// Adds a multiple of one row to another modulo a prime, sixteen entries
+/// at a time. The last few entries are masked rather than left to scalar
+/// code, since the rows of an elimination shrink as it goes.
+
+TARGET_AVX512 static void addScaledModAvx512(unsigned int* row, const unsigned int* source, int count,
+        unsigned int factor, unsigned int prime) {
+    __m512i f = _mm512_set1_epi32((int) factor);
+    __m512i q = _mm512_set1_epi32((int) shoup(factor, prime));
+    __m512i p = _mm512_set1_epi32((int) prime);
+    for (int j = 0; j < count; j += 16) {
+        __mmask16 mask = laneMask(count - j);
+        __m512i value = _mm512_maskz_loadu_epi32(mask, &source[j]);
+        __m512i sum = _mm512_add_epi32(_mm512_maskz_loadu_epi32(mask, &row[j]), multiplyModAvx512(value, f, q, p));
+        _mm512_mask_storeu_epi32(&row[j], mask, _mm512_min_epu32(sum, _mm512_sub_epi32(sum, p)));
+    }
+}
+
+/// Multiplies a row by a factor modulo a prime, sixteen entries at a
+/// time.
+
+TARGET_AVX512 static void scaleModAvx512(unsigned int* row, int count, unsigned int factor, unsigned int prime) {
+    __m512i f = _mm512_set1_epi32((int) factor);
+    __m512i q = _mm512_set1_epi32((int) shoup(factor, prime));
+    __m512i p = _mm512_set1_epi32((int) prime);
+    for (int j = 0; j < count; j += 16) {
+        __mmask16 mask = laneMask(count - j);
+        __m512i value = _mm512_maskz_loadu_epi32(mask, &row[j]);
+        _mm512_mask_storeu_epi32(&row[j], mask, multiplyModAvx512(value, f, q, p));
+    }
+}
+
+/// Counts the non-zero entries of a row sixteen at a time.
+
+TARGET_AVX512 static int countNonzeroAvx512(const unsigned int* row, int count) {
+    int nonzero = 0;
+    for (int j = 0; j < count; j += 16) {
+        __mmask16 mask = laneMask(count - j);
+        __m512i value = _mm512_maskz_loadu_epi32(mask, &row[j]);
+        nonzero += __builtin_popcount(_mm512_test_epi32_mask(value, value));
+    }
+    return nonzero;
+}
+
+/// Applies one Bareiss step to a row sixteen cells at a time.
+
+TARGET_AVX512 static void bareissIntAvx512(int* row, const int* pivotRow, int count, int pivot, int factor,
+        int prev) {
+    int shift;
+    unsigned int inverse;
+    exactDivisor(prev, shift, inverse);
+
+    __m512i p = _mm512_set1_epi32(pivot);
+    __m512i f = _mm512_set1_epi32(factor);
+    __m512i inv = _mm512_set1_epi32((int) inverse);
+    __m128i s = _mm_cvtsi32_si128(shift);
+    int j = 0;
+    for (; j + 16 <= count; j += 16) {
+        __m512i cell = _mm512_loadu_si512(&row[j]);
+        __m512i other = _mm512_loadu_si512(&pivotRow[j]);
+        __m512i even = _mm512_sub_epi64(_mm512_mul_epi32(cell, p), _mm512_mul_epi32(other, f));
+        __m512i odd = _mm512_sub_epi64(_mm512_mul_epi32(_mm512_srli_epi64(cell, 32), p),
+                _mm512_mul_epi32(_mm512_srli_epi64(other, 32), f));
+        even = _mm512_srl_epi64(even, s);
+        odd = _mm512_slli_epi64(_mm512_srl_epi64(odd, s), 32);
+        __m512i value = _mm512_mullo_epi32(_mm512_mask_blend_epi32(0xAAAA, even, odd), inv);
+        _mm512_storeu_si512(&row[j], value);
+    }
+    bareissIntScalar(row + j, pivotRow + j, count - j, pivot, factor, prev);
+}
+
+/// Applies one Bareiss step to a row of 16-bit cells sixteen cells at a
+/// time.
+
+TARGET_AVX512 static void bareissShortAvx512(short* row, const short* pivotRow, int count, short pivot,
+        short factor, short prev) {
+    int shift;
+    unsigned int inverse;
+    exactDivisor(prev, shift, inverse);
+
+    __m512i p = _mm512_set1_epi32(pivot);
+    __m512i f = _mm512_set1_epi32(factor);
+    __m512i inv = _mm512_set1_epi32((int) inverse);
+    __m128i s = _mm_cvtsi32_si128(shift);
+    int j = 0;
+    for (; j + 16 <= count; j += 16) {
+        __m512i cell = _mm512_cvtepi16_epi32(_mm256_loadu_si256((const __m256i*) &row[j]));
+        __m512i other = _mm512_cvtepi16_epi32(_mm256_loadu_si256((const __m256i*) &pivotRow[j]));
+        __m512i value = _mm512_sub_epi32(_mm512_mullo_epi32(cell, p), _mm512_mullo_epi32(other, f));
+        value = _mm512_mullo_epi32(_mm512_sra_epi32(value, s), inv);
+        _mm256_storeu_si256((__m256i*) &row[j], _mm512_cvtepi32_epi16(value));
+    }
+    bareissShortScalar(row + j, pivotRow + j, count - j, pivot, factor, prev);
+}
+
+#pragma GCC diagnostic pop
+
+// Comparing bytes takes AVX-512BW, which not every AVX-512 CPU has, and
+// two AVX2 compares already cover a block.
+static const KernelTable AVX512_KERNELS = {
+    addScaledModAvx512, scaleModAvx512, countNonzeroAvx512, bareissIntAvx512, bareissShortAvx512,
+    matchBytesAvx2
+};
+
+#endif
+
+std::atomic<const KernelTable*> Kernels::active(NULL);
+
+/// Returns the kernels of a level.
+
+const KernelTable* Kernels::tableOf(KernelLevel level) {
+#ifdef KERNELS_X86
+    if (level == KERNEL_AVX512) return &AVX512_KERNELS;
+    if (level == KERNEL_AVX2) return &AVX2_KERNELS;
+#endif
+    return &SCALAR_KERNELS;
+}
+
+/// Returns the fastest level the CPU supports.
+
+KernelLevel Kernels::getSupported() {
+#ifdef KERNELS_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) return KERNEL_AVX512;
+    if (__builtin_cpu_supports("avx2")) return KERNEL_AVX2;
+#endif
+    return KERNEL_SCALAR;
+}
+
+/// Returns the level in use.
+
+KernelLevel Kernels::getLevel() {
+#ifdef KERNELS_X86
+    const KernelTable* table = current();
+    if (table == &AVX512_KERNELS) return KERNEL_AVX512;
+    if (table == &AVX2_KERNELS) return KERNEL_AVX2;
+#endif
+    return KERNEL_SCALAR;
+}
+
+/// Chooses the level to use.
+
+KernelLevel Kernels::setLevel(KernelLevel level) {
+    KernelLevel supported = getSupported();
+    if (level > supported) level = supported;
+    active.store(tableOf(level), std::memory_order_relaxed);
+    return level;
+}
+
+/// Returns the name of a level.
+
+const char* Kernels::getName(KernelLevel level) {
+    if (level == KERNEL_AVX512) return "avx512";
+    if (level == KERNEL_AVX2) return "avx2";
+    return "scalar";
+}
+
+#endif
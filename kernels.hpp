@@ -0,0 +1,237 @@
+///
+/// file: kernels.hpp
+/// Header file for the Kernels class, the row operations the integer and
+/// modular eliminations spend their time in and the byte search that
+/// splits input into lines
+///
+/// @author Dominick Banasik
+
+#ifndef _KERNELS_H_
+#define _KERNELS_H_
+
+#include <atomic>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define KERNELS_X86
+#endif
+
+/// The shortest row worth handing to a kernel. Shorter rows, which are
+/// most rows of real equations, are cheaper to update inline.
+
+#define KERNEL_MIN_LENGTH 16
+
+/// The number of bytes matchBytes compares at once.
+
+#define MATCH_BLOCK 64
+
+/// The KernelLevel enum names the instruction sets the kernels are built
+/// for, from the slowest to the fastest.
+
+enum KernelLevel {
+    KERNEL_SCALAR,
+    KERNEL_AVX2,
+    KERNEL_AVX512
+};
+
+/// The KernelTable struct holds one implementation of every kernel.
+
+struct KernelTable {
+    void (*addScaledMod)(unsigned int* row, const unsigned int* source, int count, unsigned int factor,
+            unsigned int prime);
+    void (*scaleMod)(unsigned int* row, int count, unsigned int factor, unsigned int prime);
+    int (*countNonzero)(const unsigned int* row, int count);
+    void (*bareissInt)(int* row, const int* pivotRow, int count, int pivot, int factor, int prev);
+    void (*bareissShort)(short* row, const short* pivotRow, int count, short pivot, short factor, short prev);
+    unsigned long long (*matchBytes)(const char* text, char byte);
+};
+
+/// The Kernels class updates whole rows at a time with AVX-512, AVX2 or
+/// plain scalar code, whichever is the fastest the CPU supports. The
+/// choice is made once, the first time a kernel runs, with
+/// __builtin_cpu_supports, so one binary runs everywhere. Every level
+/// gives exactly the same results.
+
+class Kernels {
+    private:
+        static std::atomic<const KernelTable*> active;
+
+        /// Returns the kernels of a level.
+        ///
+        /// @param level the level
+        /// @return the table of its kernels
+
+        static const KernelTable* tableOf(KernelLevel level);
+
+        /// Returns the kernels in use, choosing them on first use.
+        ///
+        /// @return the table of kernels
+
+        static const KernelTable* current();
+
+    public:
+        /// Returns the fastest level the CPU supports.
+        ///
+        /// @return the level
+
+        static KernelLevel getSupported();
+
+        /// Returns the level in use.
+        ///
+        /// @return the level
+
+        static KernelLevel getLevel();
+
+        /// Chooses the level to use, for comparing them. A level the CPU
+        /// does not support is lowered to the fastest one it does.
+        ///
+        /// @param level the level to use
+        /// @return the level now in use
+
+        static KernelLevel setLevel(KernelLevel level);
+
+        /// Returns the name of a level.
+        ///
+        /// @param level the level
+        /// @return its name
+
+        static const char* getName(KernelLevel level);
+
+        /// Adds a multiple of one row to another modulo a prime below
+        /// 2^31, the AXPY step of modular elimination.
+        ///
+        /// @param row the row to add to, each entry less than the prime
+        /// @param source the row to multiply and add, each entry less than
+        ///               the prime
+        /// @param count the number of entries
+        /// @param factor the multiple, less than the prime
+        /// @param prime the prime
+
+        static void addScaledMod(unsigned int* row, const unsigned int* source, int count, unsigned int factor,
+                unsigned int prime);
+
+        /// Multiplies a row by a factor modulo a prime below 2^31.
+        ///
+        /// @param row the row, each entry less than the prime
+        /// @param count the number of entries
+        /// @param factor the factor, less than the prime
+        /// @param prime the prime
+
+        static void scaleMod(unsigned int* row, int count, unsigned int factor, unsigned int prime);
+
+        /// Counts the entries of a row that are not zero.
+        ///
+        /// @param row the row
+        /// @param count the number of entries
+        /// @return the number of non-zero entries
+
+        static int countNonzero(const unsigned int* row, int count);
+
+        /// Applies one Bareiss step to a row, setting each cell to
+        /// (pivot * cell - factor * pivotCell) / prev. The division must
+        /// be exact and every result must fit the cell type, as they do in
+        /// fraction-free elimination within the Hadamard bound.
+        ///
+        /// @param row the row to update
+        /// @param pivotRow the pivot row
+        /// @param count the number of cells
+        /// @param pivot the current pivot
+        /// @param factor the cell of the row in the pivot column
+        /// @param prev the previous pivot, not zero
+
+        static void bareissRow(int* row, const int* pivotRow, int count, int pivot, int factor, int prev);
+
+        /// Applies one Bareiss step to a row of 16-bit cells.
+        ///
+        /// @param row the row to update
+        /// @param pivotRow the pivot row
+        /// @param count the number of cells
+        /// @param pivot the current pivot
+        /// @param factor the cell of the row in the pivot column
+        /// @param prev the previous pivot, not zero
+
+        static void bareissRow(short* row, const short* pivotRow, int count, short pivot, short factor,
+                short prev);
+
+        /// Finds the bytes of a block of text that equal a byte, such as
+        /// the ends of its lines.
+        ///
+        /// @param text the block, MATCH_BLOCK bytes long
+        /// @param byte the byte to find
+        /// @return a mask with bit j set if byte j of the block matches
+
+        static unsigned long long matchBytes(const char* text, char byte);
+};
+
+/// Precomputes the quotient Shoup's multiplication needs to multiply
+/// by a fixed factor modulo a prime.
+///
+/// @param factor the factor, less than the prime
+/// @param prime the prime
+/// @return floor(factor * 2^32 / prime)
+
+inline unsigned long long shoup(unsigned int factor, unsigned int prime) {
+    return ((unsigned long long) factor << 32) / prime;
+}
+
+/// Multiplies by a fixed factor modulo a prime below 2^31 without a
+/// division.
+///
+/// @param value the number to multiply, less than the prime
+/// @param factor the factor, less than the prime
+/// @param quotient the precomputed shoup(factor, prime)
+/// @param prime the prime
+/// @return value * factor modulo the prime
+
+inline unsigned int multiplyMod(unsigned int value, unsigned int factor, unsigned long long quotient,
+        unsigned int prime) {
+    unsigned long long estimate = ((unsigned long long) value * quotient) >> 32;
+    unsigned long long result = (unsigned long long) value * factor - estimate * prime;
+    return (unsigned int) (result >= prime ? result - prime : result);
+}
+
+/// Returns the kernels in use, choosing them on first use.
+
+inline const KernelTable* Kernels::current() {
+    const KernelTable* table = active.load(std::memory_order_relaxed);
+    return table ? table : tableOf(setLevel(getSupported()));
+}
+
+/// Adds a multiple of one row to another modulo a prime.
+
+inline void Kernels::addScaledMod(unsigned int* row, const unsigned int* source, int count, unsigned int factor,
+        unsigned int prime) {
+    current()->addScaledMod(row, source, count, factor, prime);
+}
+
+/// Multiplies a row by a factor modulo a prime below 2^31.
+
+inline void Kernels::scaleMod(unsigned int* row, int count, unsigned int factor, unsigned int prime) {
+    current()->scaleMod(row, count, factor, prime);
+}
+
+/// Counts the entries of a row that are not zero.
+
+inline int Kernels::countNonzero(const unsigned int* row, int count) {
+    return current()->countNonzero(row, count);
+}
+
+/// Applies one Bareiss step to a row.
+
+inline void Kernels::bareissRow(int* row, const int* pivotRow, int count, int pivot, int factor, int prev) {
+    current()->bareissInt(row, pivotRow, count, pivot, factor, prev);
+}
+
+/// Applies one Bareiss step to a row of 16-bit cells.
+
+inline void Kernels::bareissRow(short* row, const short* pivotRow, int count, short pivot, short factor,
+        short prev) {
+    current()->bareissShort(row, pivotRow, count, pivot, factor, prev);
+}
+
+/// Finds the bytes of a block of text that equal a byte.
+
+inline unsigned long long Kernels::matchBytes(const char* text, char byte) {
+    return current()->matchBytes(text, byte);
+}
+
+#endif
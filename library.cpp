@@ -0,0 +1,224 @@
+///
+/// file: library.cpp
+/// Implementation for the ResultBuffer class and the library interface
+/// to the equation balancer
+///
+/// @author Dominick Banasik
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <new>
+
+#include "library.hpp"
+#include "balancer.h"
+
+#ifndef _LIBRARY_IMPL_
+#define _LIBRARY_IMPL_
+
+static_assert(BALANCER_BALANCED == BALANCED && BALANCER_UNBALANCED == UNBALANCED
+        && BALANCER_SOLVED == SOLVED && BALANCER_UNSOLVED == UNSOLVED
+        && BALANCER_OVERFLOWED == OVERFLOWED && BALANCER_INVALID == INVALID,
+        "the C statuses must match the Status enum");
+static_assert(BALANCER_STATS_JSON == STATS_JSON && BALANCER_STATS_PROMETHEUS == STATS_PROMETHEUS,
+        "the C stats formats must match the StatsFormat enum");
+
+/// The balancer_result struct wraps a ResultBuffer for C callers.
+
+struct balancer_result {
+    ResultBuffer buffer;
+};
+
+/// Makes room for the coefficients of a number of molecules.
+
+bool ResultBuffer::reserve(int size) {
+    if (size <= capacity) return true;
+    int grown = capacity;
+    while (grown < size) grown *= 2;
+
+    long long* moved = (long long*) realloc(numerators, grown * sizeof(long long));
+    if (!moved) return false;
+    numerators = moved;
+    moved = (long long*) realloc(denominators, grown * sizeof(long long));
+    if (!moved) return false;
+    denominators = moved;
+    capacity = grown;
+    return true;
+}
+
+/// Balances an equation into the buffer.
+
+Status ResultBuffer::assign(std::string_view string, Engine engine, ResultCache* cache) {
+    input.assign(string.data(), string.size());
+    equation.assign(input);
+    Solution solution = equation.balance(engine, cache);
+
+    status = solution.getStatus();
+    count = equation.getReactantCount() + equation.getProductCount();
+    text.clear();
+    equation.formatSolution(solution, text);
+    if (status != SOLVED) return status;
+
+    if (!reserve(count)) {
+        status = INVALID;
+        count = 0;
+        throw std::bad_alloc();
+    }
+    int index = 0;
+    for (int i = 0; i < count; i++) {
+        Molecule& molecule = equation.getMolecule(i);
+        if (molecule.getFixed()) {
+            numerators[i] = molecule.getCoefficient();
+            denominators[i] = 1;
+            continue;
+        }
+
+        Rational value = solution.getValue(index++);
+        if (!value.getNum().isSmall() || !value.getDen().isSmall()) {
+            status = OVERFLOWED;
+            return status;
+        }
+        numerators[i] = value.getNum().toLong();
+        denominators[i] = value.getDen().toLong();
+    }
+    return status;
+}
+
+/// Returns the status of the solution.
+
+Status ResultBuffer::getStatus() {
+    return status;
+}
+
+/// Returns the number of molecules in the equation.
+
+int ResultBuffer::getCount() {
+    return count;
+}
+
+/// Returns the number of reactants in the equation.
+
+int ResultBuffer::getReactantCount() {
+    return equation.getReactantCount();
+}
+
+/// Returns the numerator of the coefficient of a molecule.
+
+long long ResultBuffer::getNumerator(int index) {
+    return numerators[index];
+}
+
+/// Returns the denominator of the coefficient of a molecule.
+
+long long ResultBuffer::getDenominator(int index) {
+    return denominators[index];
+}
+
+/// Returns the formula of a molecule as it was given.
+
+std::string_view ResultBuffer::getFormula(int index) {
+    return equation.getMolecule(index).getFormula();
+}
+
+/// Returns the balanced equation in the form the balancer prints it.
+
+const std::string& ResultBuffer::getText() {
+    return text;
+}
+
+/// Constructor for the ResultBuffer class.
+
+ResultBuffer::ResultBuffer(FormulaCache* formulas) : equation(formulas) {
+    status = INVALID;
+    count = 0;
+    capacity = CAPACITY;
+    numerators = (long long*) malloc(capacity * sizeof(long long));
+    denominators = (long long*) malloc(capacity * sizeof(long long));
+    if (!numerators || !denominators) {
+        free(numerators);
+        free(denominators);
+        throw std::bad_alloc();
+    }
+}
+
+/// Destructor for the ResultBuffer class.
+
+ResultBuffer::~ResultBuffer() {
+    free(numerators);
+    free(denominators);
+}
+
+/// Balances an equation without touching stdio.
+
+Status balance(std::string_view string, ResultBuffer& result, Engine engine, ResultCache* cache) {
+    return result.assign(string, engine, cache);
+}
+
+/// Creates an empty result.
+
+extern "C" balancer_result* balancer_result_create(void) {
+    try {
+        return new (std::nothrow) balancer_result;
+    } catch (const std::bad_alloc&) {
+        return NULL;
+    }
+}
+
+/// Frees a result.
+
+extern "C" void balancer_result_free(balancer_result* result) {
+    delete result;
+}
+
+/// Balances an equation into a result.
+
+extern "C" int balancer_balance(balancer_result* result, const char* equation, size_t length) {
+    try {
+        return balance(std::string_view(equation, length), result->buffer);
+    } catch (const std::bad_alloc&) {
+        return -1;
+    }
+}
+
+/// Returns the number of molecules in the equation.
+
+extern "C" int balancer_result_count(balancer_result* result) {
+    return result->buffer.getCount();
+}
+
+/// Returns the number of reactants in the equation.
+
+extern "C" int balancer_result_reactants(balancer_result* result) {
+    return result->buffer.getReactantCount();
+}
+
+/// Returns the coefficient of a molecule as a fraction.
+
+extern "C" int balancer_result_coefficient(balancer_result* result, int index, long long* numerator,
+        long long* denominator) {
+    if (result->buffer.getStatus() != SOLVED || index < 0 || index >= result->buffer.getCount()) return -1;
+    *numerator = result->buffer.getNumerator(index);
+    if (denominator) *denominator = result->buffer.getDenominator(index);
+    return 0;
+}
+
+/// Returns the formatted result.
+
+extern "C" const char* balancer_result_text(balancer_result* result) {
+    return result->buffer.getText().c_str();
+}
+
+/// Writes the stats of every thread that has balanced.
+
+extern "C" size_t balancer_stats(int format, char* buffer, size_t size) {
+    std::string output;
+    Stats::exportAs((StatsFormat) format, output);
+    if (buffer && size > 0) {
+        size_t length = output.size() < size - 1 ? output.size() : size - 1;
+        memcpy(buffer, output.data(), length);
+        buffer[length] = 0;
+    }
+    return output.size();
+}
+
+#endif
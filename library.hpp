@@ -0,0 +1,150 @@
+///
+/// file: library.hpp
+/// Header file for the ResultBuffer class and the library interface to
+/// the equation balancer. Nothing in the library prints, so it may be
+/// embedded in any program and called from any number of threads, each
+/// with its own ResultBuffer. Build it without balancer.cpp, for example:
+///
+///     g++ -std=c++17 -O2 -fPIC -c library.cpp arena.cpp cache.cpp composition.cpp element.cpp
+///         equation.cpp factor.cpp fraction.cpp hash.cpp integer.cpp kernels.cpp live.cpp matrix.cpp
+///         modular.cpp molecule.cpp network.cpp rational.cpp solution.cpp sparse.cpp stats.cpp team.cpp
+///     ar rcs libbalancer.a *.o
+///     g++ -shared -o libbalancer.so *.o
+///
+/// Tools that edit an equation one molecule at a time use the
+/// LiveEquation class, and tools that balance one equation for many
+/// choices of its fixed coefficients use the Factorization class. Whole
+/// reaction networks are read into the Network class. C programs include
+/// balancer.h instead.
+///
+/// @author Dominick Banasik
+
+#ifndef _LIBRARY_H_
+#define _LIBRARY_H_
+
+#include <string>
+#include <string_view>
+
+#include "matrix.hpp"
+#include "solution.hpp"
+#include "equation.hpp"
+#include "live.hpp"
+#include "factor.hpp"
+#include "network.hpp"
+#include "cache.hpp"
+
+/// The ResultBuffer class holds the result of balancing one equation: its
+/// status, the coefficient of every molecule and the formatted equation.
+/// The memory used to balance is kept between calls, so a buffer reused
+/// for equations no larger than an earlier one allocates nothing.
+
+class ResultBuffer {
+    private:
+        std::string input;
+        Equation equation;
+        Status status;
+        long long* numerators;
+        long long* denominators;
+        int count;
+        int capacity;
+        std::string text;
+
+        /// Makes room for the coefficients of a number of molecules. The
+        /// coefficients already held are kept if there is no room.
+        ///
+        /// @param size the number of molecules
+        /// @return whether there was memory for them
+
+        bool reserve(int size);
+
+    public:
+        /// Constructor for the ResultBuffer class. Throws std::bad_alloc if
+        /// out of memory.
+        ///
+        /// @param formulas the cache of parsed formulas to share, or NULL
+
+        ResultBuffer(FormulaCache* formulas = NULL);
+
+        /// Destructor for the ResultBuffer class.
+
+        ~ResultBuffer();
+
+        ResultBuffer(const ResultBuffer& copy) = delete;
+        ResultBuffer& operator=(const ResultBuffer& copy) = delete;
+
+        /// Balances an equation into the buffer, replacing what it held.
+        /// The string is copied, so it need not outlive the call. Throws
+        /// std::bad_alloc if out of memory, leaving the buffer empty.
+        ///
+        /// @param string the equation to balance
+        /// @param engine the elimination to reduce the matrix with
+        /// @param cache the cache of earlier solutions, or NULL
+        /// @return the status of the solution
+
+        Status assign(std::string_view string, Engine engine = SPARSE, ResultCache* cache = NULL);
+
+        /// Returns the status of the solution. A coefficient too large
+        /// for 64 bits makes the status OVERFLOWED, though the text still
+        /// holds the exact solution.
+        ///
+        /// @return the status
+
+        Status getStatus();
+
+        /// Returns the number of molecules in the equation.
+        ///
+        /// @return the number of molecules
+
+        int getCount();
+
+        /// Returns the number of reactants in the equation. The reactants
+        /// come before the products.
+        ///
+        /// @return the number of reactants
+
+        int getReactantCount();
+
+        /// Returns the numerator of the coefficient of a molecule. Only
+        /// meaningful when the status is SOLVED.
+        ///
+        /// @param index the index of the molecule
+        /// @return the numerator of its coefficient
+
+        long long getNumerator(int index);
+
+        /// Returns the denominator of the coefficient of a molecule, which
+        /// is 1 unless fixed coefficients force a fraction.
+        ///
+        /// @param index the index of the molecule
+        /// @return the denominator of its coefficient
+
+        long long getDenominator(int index);
+
+        /// Returns the formula of a molecule as it was given, including
+        /// any fixed coefficient.
+        ///
+        /// @param index the index of the molecule
+        /// @return the formula of the molecule
+
+        std::string_view getFormula(int index);
+
+        /// Returns the balanced equation, or the statement of why it could
+        /// not be balanced, in the form the balancer prints it.
+        ///
+        /// @return the formatted result, ending in a newline
+
+        const std::string& getText();
+};
+
+/// Balances an equation without touching stdio. Safe to call from many
+/// threads at once as long as each uses its own buffer.
+///
+/// @param string the equation to balance
+/// @param result the buffer to hold the result
+/// @param engine the elimination to reduce the matrix with
+/// @param cache the cache of earlier solutions, or NULL
+/// @return the status of the solution
+
+Status balance(std::string_view string, ResultBuffer& result, Engine engine = SPARSE, ResultCache* cache = NULL);
+
+#endif
@@ -0,0 +1,534 @@
+///
+/// file: live.cpp
+/// Implementation for the LiveEquation class
+///
+/// @author Dominick Banasik
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+
+#include "live.hpp"
+#include "equation.hpp"
+#include "matrix.hpp"
+
+#ifndef _LIVE_IMPL_
+#define _LIVE_IMPL_
+
+/// The View class shows the rref of a live equation to solveReduced as a
+/// matrix, with its rows in the order of the columns they lead in and its
+/// zero rows last.
+
+class LiveEquation::View {
+    private:
+        LiveEquation& equation;
+        int* order;
+
+    public:
+        /// Constructor for the View class.
+        ///
+        /// @param equation the equation to show
+
+        View(LiveEquation& equation) : equation(equation) {
+            int* leads = equation.leads;
+            order = equation.arena.allocate<int>(equation.rows > 0 ? equation.rows : 1);
+            for (int i = 0; i < equation.rows; i++) {
+                order[i] = i;
+            }
+            std::sort(order, order + equation.rows, [leads](int a, int b) {
+                return (unsigned int) leads[a] < (unsigned int) leads[b];
+            });
+        }
+
+        /// Returns the arena the solution is allocated from.
+        ///
+        /// @return the arena
+
+        Arena* getArena() const {
+            return &equation.arena;
+        }
+
+        /// Returns the number of rows.
+        ///
+        /// @return the number of rows
+
+        int getRows() const {
+            return equation.rows;
+        }
+
+        /// Returns the number of columns.
+        ///
+        /// @return the number of columns
+
+        int getCols() const {
+            return equation.cols;
+        }
+
+        /// Returns the value of a cell.
+        ///
+        /// @param row the row of the cell
+        /// @param col the column of the cell
+        /// @return the value
+
+        const Rational& getValue(int row, int col) {
+            return equation.cells[col][order[row]];
+        }
+
+        /// Returns the column of the first cell of a row that is not zero.
+        ///
+        /// @param row the row
+        /// @return the column, or the number of columns if the row is zero
+
+        int getLead(int row) {
+            int lead = equation.leads[order[row]];
+            return lead == -1 ? equation.cols : lead;
+        }
+
+        /// Checks whether any cell overflowed.
+        ///
+        /// @return whether any cell overflowed
+
+        bool getOverflow() {
+            for (int j = 0; j < equation.cols; j++) {
+                for (int i = 0; i < equation.rows; i++) {
+                    if (equation.cells[j][i].getOverflow()) return true;
+                }
+            }
+            return false;
+        }
+};
+
+/// Moves an array of values to a larger one.
+///
+/// @param values the array, which is freed
+/// @param count the number of values in use
+/// @param capacity the size of the new array
+/// @return the new array
+
+static Rational* grow(Rational* values, int count, int capacity) {
+    Rational* grown = new Rational[capacity];
+    for (int i = 0; i < count; i++) {
+        grown[i] = values[i];
+    }
+    delete[] values;
+    return grown;
+}
+
+/// Makes room for a number of rows in every column of the rref and every
+/// row of the transform.
+
+void LiveEquation::reserveRows(int count) {
+    if (count <= rowCapacity) return;
+    while (rowCapacity < count) {
+        rowCapacity += CAPACITY;
+    }
+
+    for (int j = 0; j < cols; j++) {
+        cells[j] = grow(cells[j], rows, rowCapacity);
+    }
+    for (int i = 0; i < rows; i++) {
+        transform[i] = grow(transform[i], rows, rowCapacity);
+    }
+    transform = (Rational**) realloc(transform, rowCapacity * sizeof(Rational*));
+    atoms = (int*) realloc(atoms, rowCapacity * sizeof(int));
+    totals = (long long*) realloc(totals, rowCapacity * sizeof(long long));
+    leads = (int*) realloc(leads, rowCapacity * sizeof(int));
+}
+
+/// Adds a row for an element.
+
+void LiveEquation::addAtom(int element) {
+    reserveRows(rows + 1);
+    atomRows[element] = rows;
+    atoms[rows] = element;
+    totals[rows] = 0;
+    leads[rows] = -1;
+    transform[rows] = new Rational[rowCapacity];
+    transform[rows][rows] = Rational(1);
+    rows++;
+}
+
+/// Returns the column of the rref that holds a free molecule.
+
+int LiveEquation::columnOf(int index) {
+    int col = 0;
+    for (int i = 0; i < index; i++) {
+        if (!molecules[i].getFixed()) col++;
+    }
+    return col;
+}
+
+/// Adds a multiple of a column of the transform to a reduced column.
+
+void LiveEquation::addReduced(Rational* column, int atom, long long count) {
+    Rational multiple(count);
+    for (int i = 0; i < rows; i++) {
+        if (transform[i][atom].equals(0)) continue;
+        Rational f(transform[i][atom]);
+        f.multiply(multiple);
+        column[i].add(f);
+    }
+}
+
+/// Makes a column of the rref from atoms.
+
+Rational* LiveEquation::reduceColumn(const Composition& composition, int multiplier) {
+    Rational* column = new Rational[rowCapacity];
+    for (int j = 0; j < composition.getSize(); j++) {
+        addReduced(column, atomRows[composition.getElement(j)], (long long) multiplier * composition.getCount(j));
+    }
+    return column;
+}
+
+/// Makes a row the pivot row of a column.
+
+void LiveEquation::pivot(int row, int col) {
+    Rational reciprocal = cells[col][row].getReciprocal();
+    Rational* pivotTransform = transform[row];
+    for (int j = 0; j < cols; j++) {
+        if (!cells[j][row].equals(0)) cells[j][row].multiply(reciprocal);
+    }
+    for (int j = 0; j < rows; j++) {
+        if (!pivotTransform[j].equals(0)) pivotTransform[j].multiply(reciprocal);
+    }
+
+    for (int i = 0; i < rows; i++) {
+        if (i == row || cells[col][i].equals(0)) continue;
+        Rational factor(cells[col][i]);
+        factor.multiply(-1);
+
+        for (int j = 0; j < cols; j++) {
+            if (cells[j][row].equals(0)) continue;
+            Rational f(cells[j][row]);
+            f.multiply(factor);
+            cells[j][i].add(f);
+        }
+        for (int j = 0; j < rows; j++) {
+            if (pivotTransform[j].equals(0)) continue;
+            Rational f(pivotTransform[j]);
+            f.multiply(factor);
+            transform[i][j].add(f);
+        }
+    }
+    leads[row] = col;
+}
+
+/// Inserts a reduced column into the rref.
+///
+/// Rows that lead before the column cannot take it without losing their
+/// own pivot. Of the others, the row that leads last is the only one whose
+/// subtraction from the rest leaves every cell before their leads zero,
+/// since its own cells all lie at or after its lead, and a zero row leads
+/// after every column. Its old pivot column is the only one that stops
+/// being a pivot column.
+
+void LiveEquation::insertColumn(int col, Rational* column) {
+    if (cols == colCapacity) {
+        colCapacity += CAPACITY;
+        cells = (Rational**) realloc(cells, colCapacity * sizeof(Rational*));
+    }
+    memmove(cells + col + 1, cells + col, (cols - col) * sizeof(Rational*));
+    cells[col] = column;
+    cols++;
+
+    int row = -1;
+    for (int i = 0; i < rows; i++) {
+        if (leads[i] >= col) leads[i]++;
+        if (column[i].equals(0) || (leads[i] != -1 && leads[i] < col)) continue;
+        if (row == -1 || (leads[row] != -1 && (leads[i] == -1 || leads[i] > leads[row]))) row = i;
+    }
+    if (row != -1) pivot(row, col);
+}
+
+/// Removes a column from the rref.
+
+void LiveEquation::removeColumn(int col) {
+    int row = -1;
+    for (int i = 0; i < rows; i++) {
+        if (leads[i] == col) {
+            row = i;
+            leads[i] = -1;
+        } else if (leads[i] > col) {
+            leads[i]--;
+        }
+    }
+
+    delete[] cells[col];
+    cols--;
+    memmove(cells + col, cells + col + 1, (cols - col) * sizeof(Rational*));
+    if (row == -1) return;
+
+    for (int j = col; j < cols; j++) {
+        if (!cells[j][row].equals(0)) {
+            pivot(row, j);
+            return;
+        }
+    }
+}
+
+/// Reduces the column of atoms fixed by molecules again.
+
+void LiveEquation::updateFixed() {
+    removeColumn(cols - 1);
+    Rational* column = new Rational[rowCapacity];
+    for (int atom = 0; atom < rows; atom++) {
+        if (totals[atom] != 0) addReduced(column, atom, totals[atom]);
+    }
+    insertColumn(cols, column);
+}
+
+/// Adds a molecule's atoms to the rref.
+
+void LiveEquation::attach(int index) {
+    Molecule& molecule = molecules[index];
+    const Composition& composition = molecule.getComposition();
+    int multiplier = index < reactantCount ? 1 : -1;
+
+    if (!molecule.getValid()) invalidCount++;
+    for (int j = 0; j < composition.getSize(); j++) {
+        if (atomRows[composition.getElement(j)] == -1) addAtom(composition.getElement(j));
+    }
+
+    if (!molecule.getFixed()) {
+        insertColumn(columnOf(index), reduceColumn(composition, multiplier));
+        return;
+    }
+    for (int j = 0; j < composition.getSize(); j++) {
+        totals[atomRows[composition.getElement(j)]] += (long long) multiplier * composition.getCount(j);
+    }
+    updateFixed();
+}
+
+/// Takes a molecule's atoms out of the rref.
+
+void LiveEquation::detach(int index) {
+    Molecule& molecule = molecules[index];
+    const Composition& composition = molecule.getComposition();
+    int multiplier = index < reactantCount ? 1 : -1;
+
+    if (!molecule.getValid()) invalidCount--;
+    if (!molecule.getFixed()) {
+        removeColumn(columnOf(index));
+        return;
+    }
+    for (int j = 0; j < composition.getSize(); j++) {
+        totals[atomRows[composition.getElement(j)]] -= (long long) multiplier * composition.getCount(j);
+    }
+    updateFixed();
+}
+
+/// Replaces the string of a molecule and parses it again.
+
+void LiveEquation::setText(int index, std::string_view formula) {
+    char* text = (char*) malloc(formula.size() + 1);
+    memcpy(text, formula.data(), formula.size());
+    text[formula.size()] = '\0';
+
+    if (texts[index]) {
+        molecules[index].release();
+        free(texts[index]);
+    }
+    texts[index] = text;
+    molecules[index] = Molecule(std::string_view(text, formula.size()), formulas);
+}
+
+/// Replaces the equation with one parsed from a string.
+
+void LiveEquation::assign(std::string_view string) {
+    clear();
+    Equation equation(formulas);
+    equation.assign(string);
+
+    int count = equation.getReactantCount() + equation.getProductCount();
+    for (int i = 0; i < count; i++) {
+        addMolecule(equation.getMolecule(i).getFormula(), i < equation.getReactantCount());
+    }
+}
+
+/// Adds a molecule after the others on its side.
+
+int LiveEquation::addMolecule(std::string_view formula, bool isReactant) {
+    if (moleculeCount == moleculeCapacity) {
+        moleculeCapacity += CAPACITY;
+        molecules = (Molecule*) realloc(molecules, moleculeCapacity * sizeof(Molecule));
+        texts = (char**) realloc(texts, moleculeCapacity * sizeof(char*));
+    }
+
+    int index = isReactant ? reactantCount : moleculeCount;
+    memmove(molecules + index + 1, molecules + index, (moleculeCount - index) * sizeof(Molecule));
+    memmove(texts + index + 1, texts + index, (moleculeCount - index) * sizeof(char*));
+    texts[index] = NULL;
+    moleculeCount++;
+    if (isReactant) reactantCount++;
+
+    setText(index, formula);
+    attach(index);
+    return index;
+}
+
+/// Removes a molecule.
+
+void LiveEquation::removeMolecule(int index) {
+    detach(index);
+    molecules[index].release();
+    free(texts[index]);
+
+    moleculeCount--;
+    if (index < reactantCount) reactantCount--;
+    memmove(molecules + index, molecules + index + 1, (moleculeCount - index) * sizeof(Molecule));
+    memmove(texts + index, texts + index + 1, (moleculeCount - index) * sizeof(char*));
+}
+
+/// Fixes the coefficient of a molecule.
+
+void LiveEquation::fixCoefficient(int index, int coefficient) {
+    Molecule& molecule = molecules[index];
+    if (molecule.getFixed() && molecule.getCoefficient() == coefficient) return;
+
+    std::string formula = std::to_string(coefficient);
+    formula += molecules[index].getBareFormula();
+    detach(index);
+    setText(index, formula);
+    attach(index);
+}
+
+/// Frees the coefficient of a molecule.
+
+void LiveEquation::freeCoefficient(int index) {
+    if (!molecules[index].getFixed()) return;
+
+    std::string formula = "_";
+    formula += molecules[index].getBareFormula();
+    detach(index);
+    setText(index, formula);
+    attach(index);
+}
+
+/// Returns the number of reactants in the equation.
+
+int LiveEquation::getReactantCount() {
+    return reactantCount;
+}
+
+/// Returns the number of products in the equation.
+
+int LiveEquation::getProductCount() {
+    return moleculeCount - reactantCount;
+}
+
+/// Returns a molecule of the equation.
+
+Molecule& LiveEquation::getMolecule(int index) {
+    return molecules[index];
+}
+
+/// Returns the rank of the matrix of the equation.
+
+int LiveEquation::getRank() {
+    int rank = 0;
+    for (int i = 0; i < rows; i++) {
+        if (leads[i] != -1) rank++;
+    }
+    return rank;
+}
+
+/// Balances the equation from its rref.
+
+Solution LiveEquation::balance() {
+    arena.reset();
+    if (invalidCount > 0) {
+        Solution solution(0, &arena);
+        solution.setStatus(INVALID);
+        return solution;
+    }
+
+    View view(*this);
+    return solveReduced(view);
+}
+
+/// Appends the solution to the equation to a string, or states
+/// otherwise.
+
+void LiveEquation::formatSolution(Solution solution, std::string& output) {
+    if (solution.getStatus() != SOLVED) {
+        appendStatus(solution.getStatus(), output);
+        return;
+    }
+
+    int index = 0;
+    for (int i = 0; i < moleculeCount; i++) {
+        if (i == reactantCount) {
+            output += " = ";
+        } else if (i > 0) {
+            output += " + ";
+        }
+        appendTerm(output, molecules[i], solution, &index);
+    }
+    if (reactantCount == moleculeCount) output += " = ";
+    output += "\n";
+}
+
+/// Empties the equation.
+
+void LiveEquation::clear() {
+    for (int i = 0; i < moleculeCount; i++) {
+        molecules[i].release();
+        free(texts[i]);
+    }
+    for (int j = 0; j < cols; j++) {
+        delete[] cells[j];
+    }
+    for (int i = 0; i < rows; i++) {
+        delete[] transform[i];
+        atomRows[atoms[i]] = -1;
+    }
+
+    reactantCount = 0;
+    moleculeCount = 0;
+    invalidCount = 0;
+    rows = 0;
+    cells[0] = new Rational[rowCapacity];
+    cols = 1;
+    arena.reset();
+}
+
+/// Constructor for an empty LiveEquation.
+
+LiveEquation::LiveEquation(FormulaCache* formulas) {
+    this->formulas = formulas;
+    moleculeCapacity = CAPACITY;
+    rowCapacity = CAPACITY;
+    colCapacity = CAPACITY;
+    moleculeCount = 0;
+    rows = 0;
+    cols = 0;
+    for (int i = 0; i <= ELEMENT_COUNT; i++) {
+        atomRows[i] = -1;
+    }
+
+    texts = (char**) malloc(moleculeCapacity * sizeof(char*));
+    molecules = (Molecule*) malloc(moleculeCapacity * sizeof(Molecule));
+    atoms = (int*) malloc(rowCapacity * sizeof(int));
+    totals = (long long*) malloc(rowCapacity * sizeof(long long));
+    leads = (int*) malloc(rowCapacity * sizeof(int));
+    transform = (Rational**) malloc(rowCapacity * sizeof(Rational*));
+    cells = (Rational**) malloc(colCapacity * sizeof(Rational*));
+    clear();
+}
+
+/// Destructor for the LiveEquation class.
+
+LiveEquation::~LiveEquation() {
+    clear();
+    delete[] cells[0];
+    free(cells);
+    free(transform);
+    free(leads);
+    free(totals);
+    free(atoms);
+    free(molecules);
+    free(texts);
+}
+
+#endif
@@ -0,0 +1,248 @@
+///
+/// file: live.hpp
+/// Header file for the LiveEquation class
+///
+/// @author Dominick Banasik
+
+#ifndef _LIVE_H_
+#define _LIVE_H_
+
+#include <string>
+#include <string_view>
+
+#include "element.hpp"
+#include "molecule.hpp"
+#include "rational.hpp"
+#include "solution.hpp"
+#include "arena.hpp"
+#include "cache.hpp"
+
+/// The LiveEquation class is a chemical equation that is edited one
+/// molecule at a time, as interactive tools do. Rather than the matrix of
+/// the equation it keeps the rref of that matrix and the transform that
+/// reduced it, so an edit updates the rref in place: a molecule's column
+/// is the transform times its atoms, and adding or removing a column
+/// moves at most one pivot. An edit costs time proportional to the size
+/// of the rref, where rebuilding it costs that times its rank.
+///
+/// The rref of a matrix does not depend on how it was reached, so
+/// balancing gives exactly what Equation::balance gives for the same
+/// molecules in the same order. Rows are kept for every element the
+/// equation has held since it was assigned; the rows of elements no
+/// molecule holds any more are zero and change nothing.
+
+class LiveEquation {
+    private:
+        class View;
+
+        char** texts;
+        Molecule* molecules;
+        int reactantCount;
+        int moleculeCount;
+        int moleculeCapacity;
+        int invalidCount;
+
+        int* atoms;
+        int atomRows[ELEMENT_COUNT + 1];
+        long long* totals;
+        int rows;
+        int rowCapacity;
+
+        Rational** cells;
+        Rational** transform;
+        int* leads;
+        int cols;
+        int colCapacity;
+
+        FormulaCache* formulas;
+        Arena arena;
+
+        /// Makes room for a number of rows in every column of the rref
+        /// and every row of the transform.
+        ///
+        /// @param count the number of rows
+
+        void reserveRows(int count);
+
+        /// Adds a row for an element, which is zero in the rref and picks
+        /// out the element in the transform.
+        ///
+        /// @param element the ID of the element
+
+        void addAtom(int element);
+
+        /// Returns the column of the rref that holds a free molecule.
+        ///
+        /// @param index the index of the molecule
+        /// @return its column
+
+        int columnOf(int index);
+
+        /// Adds a multiple of a column of the transform to a reduced
+        /// column, which reduces that many atoms of an element.
+        ///
+        /// @param column the reduced column
+        /// @param atom the row of the element
+        /// @param count the number of atoms
+
+        void addReduced(Rational* column, int atom, long long count);
+
+        /// Makes a column of the rref from atoms, by multiplying them by
+        /// the transform.
+        ///
+        /// @param composition the atoms of the column
+        /// @param multiplier the number to multiply every count by
+        /// @return the column, owned by the caller until it is inserted
+
+        Rational* reduceColumn(const Composition& composition, int multiplier);
+
+        /// Makes a row the pivot row of a column. The row is divided by
+        /// its cell in the column, and then subtracted from every other
+        /// row with a cell in the column, in the rref and the transform.
+        ///
+        /// @param row the row
+        /// @param col the column, whose cell in the row is not zero
+
+        void pivot(int row, int col);
+
+        /// Inserts a reduced column into the rref. If the column has a
+        /// cell in a row that leads after it, or in a zero row, the one
+        /// of those rows that leads last takes the column as its pivot,
+        /// which leaves every other pivot in place.
+        ///
+        /// @param col the index the column is inserted at
+        /// @param column the column, which the rref takes ownership of
+
+        void insertColumn(int col, Rational* column);
+
+        /// Removes a column from the rref. If it was a pivot column, its
+        /// row moves its pivot to its next cell that is not zero, which
+        /// is in a column no other row leads in, or becomes a zero row.
+        ///
+        /// @param col the index of the column
+
+        void removeColumn(int col);
+
+        /// Reduces the column of atoms fixed by molecules again, after the
+        /// totals changed.
+
+        void updateFixed();
+
+        /// Adds a molecule's atoms to the rref, as a column if it is free
+        /// or to the fixed column if it is not.
+        ///
+        /// @param index the index of the molecule
+
+        void attach(int index);
+
+        /// Takes a molecule's atoms out of the rref.
+        ///
+        /// @param index the index of the molecule
+
+        void detach(int index);
+
+        /// Replaces the string of a molecule and parses it again.
+        ///
+        /// @param index the index of the molecule
+        /// @param formula the new string
+
+        void setText(int index, std::string_view formula);
+
+        /// Empties the equation.
+
+        void clear();
+
+    public:
+        /// Constructor for an empty LiveEquation.
+        ///
+        /// @param formulas the cache of parsed formulas to share, or NULL
+
+        LiveEquation(FormulaCache* formulas = NULL);
+
+        /// Destructor for the LiveEquation class.
+
+        ~LiveEquation();
+
+        LiveEquation(const LiveEquation& copy) = delete;
+        LiveEquation& operator=(const LiveEquation& copy) = delete;
+
+        /// Replaces the equation with one parsed from a string, molecule
+        /// by molecule. The string is copied.
+        ///
+        /// @param string the string to create the equation from
+
+        void assign(std::string_view string);
+
+        /// Adds a molecule after the others on its side. The string is
+        /// copied, and parsed as it would be in an equation, so it is
+        /// free if it starts with '_' and fixed otherwise.
+        ///
+        /// @param formula the string of the molecule
+        /// @param isReactant whether the molecule is a reactant or product
+        /// @return the index of the molecule
+
+        int addMolecule(std::string_view formula, bool isReactant);
+
+        /// Removes a molecule. The molecules after it move down one.
+        ///
+        /// @param index the index of the molecule
+
+        void removeMolecule(int index);
+
+        /// Fixes the coefficient of a molecule.
+        ///
+        /// @param index the index of the molecule
+        /// @param coefficient the coefficient, greater than zero
+
+        void fixCoefficient(int index, int coefficient);
+
+        /// Frees the coefficient of a molecule, so balancing chooses it.
+        ///
+        /// @param index the index of the molecule
+
+        void freeCoefficient(int index);
+
+        /// Returns the number of reactants in the equation.
+        ///
+        /// @return the number of reactants
+
+        int getReactantCount();
+
+        /// Returns the number of products in the equation.
+        ///
+        /// @return the number of products
+
+        int getProductCount();
+
+        /// Returns a molecule of the equation. The reactants come first,
+        /// then the products, each in the order they were added in.
+        ///
+        /// @param index the index of the molecule
+        /// @return the molecule
+
+        Molecule& getMolecule(int index);
+
+        /// Returns the rank of the matrix of the equation, counting the
+        /// column of atoms fixed by molecules.
+        ///
+        /// @return the rank
+
+        int getRank();
+
+        /// Balances the equation from its rref.
+        ///
+        /// @return the solution to the equation, valid until the equation
+        ///         is balanced again or assigned
+
+        Solution balance();
+
+        /// Appends the solution to the equation to a string, or states
+        /// otherwise, as Equation::formatSolution does.
+        ///
+        /// @param solution the solution to format
+        /// @param output the string to append to
+
+        void formatSolution(Solution solution, std::string& output);
+};
+
+#endif
@@ -0,0 +1,260 @@
+///
+/// file: loadgen.cpp
+/// A load generator for the balancer's socket mode. Several connections
+/// each keep a number of equations in flight and time every one from
+/// send to answer. Build separately from the balancer, for example:
+///
+///     g++ -std=c++17 -O2 -pthread -o loadgen loadgen.cpp
+///
+/// @author Dominick Banasik
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include <algorithm>
+#include <string>
+#include <thread>
+#include <vector>
+
+#define MAX_DEPTH 1024
+#define READ_SIZE (1 << 16)
+
+/// The Options struct holds the settings chosen on the command line.
+
+struct Options {
+    long requests;
+    int connections;
+    int depth;
+    char* socket;
+    char* path;
+};
+
+/// The Client struct holds what one connection needs and what it measured.
+
+struct Client {
+    int id;
+    long requests;
+    std::vector<long long> latencies;
+    bool failed;
+};
+
+/// Prints a usage message.
+
+void usage() {
+    fprintf(stderr, "usage: ./loadgen [-n requests] [-c connections] [-d depth] socket file\n");
+}
+
+/// Returns the time on a monotonic clock.
+///
+/// @return the time in nanoseconds
+
+long long now() {
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return time.tv_sec * 1000000000LL + time.tv_nsec;
+}
+
+/// Processes all command line flags.
+///
+/// @param argc the number of command line arguments
+/// @param argv the array of command line arguments
+/// @param options the options to fill in
+
+void processFlags(int argc, char** argv, Options* options) {
+    int opt;
+
+    options->requests = 100000;
+    options->connections = 4;
+    options->depth = 16;
+
+    while ((opt = getopt(argc, argv, "n:c:d:")) != -1) {
+        switch (opt) {
+            case 'n':
+                options->requests = atol(optarg);
+                break;
+            case 'c':
+                options->connections = atoi(optarg);
+                break;
+            case 'd':
+                options->depth = atoi(optarg);
+                break;
+            default:
+                usage();
+                exit(1);
+        }
+    }
+
+    if (optind + 2 != argc || options->requests < 1 || options->connections < 1 || options->depth < 1
+            || options->depth > MAX_DEPTH) {
+        usage();
+        exit(1);
+    }
+    options->socket = argv[optind];
+    options->path = argv[optind + 1];
+}
+
+/// Reads the equations to send, skipping blank lines.
+///
+/// @param path the file to read
+/// @param equations where to store the equations, each ending in a newline
+/// @return whether or not the file could be read
+
+bool readEquations(const char* path, std::vector<std::string>& equations) {
+    FILE* input = fopen(path, "r");
+    if (!input) {
+        perror(path);
+        return false;
+    }
+
+    char* line = NULL;
+    size_t capacity = 0;
+    ssize_t length;
+    while ((length = getline(&line, &capacity, input)) != -1) {
+        while (length > 0 && (line[length - 1] == '\n' || line[length - 1] == '\r')) length--;
+        if (length == 0) continue;
+        equations.push_back(std::string(line, length) + '\n');
+    }
+    free(line);
+    fclose(input);
+    return !equations.empty();
+}
+
+/// Connects to the balancer's socket.
+///
+/// @param path the path of the socket
+/// @return the connected socket, or -1 on failure
+
+int connectTo(const char* path) {
+    struct sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strncpy(address.sun_path, path, sizeof(address.sun_path) - 1);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0 || connect(fd, (struct sockaddr*) &address, sizeof(address)) < 0) {
+        perror(path);
+        if (fd >= 0) close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/// Runs one connection, keeping up to depth equations in flight until it
+/// has sent its share, and records the latency of each.
+///
+/// @param client the connection's settings and results
+/// @param options the options chosen on the command line
+/// @param equations the equations to send, used in turn
+
+void run(Client* client, Options* options, std::vector<std::string>* equations) {
+    int fd = connectTo(options->socket);
+    if (fd < 0) {
+        client->failed = true;
+        return;
+    }
+
+    long long sent[MAX_DEPTH];
+    long next = client->id;
+    long sentCount = 0;
+    long answered = 0;
+    std::string output;
+    char buffer[READ_SIZE];
+    client->latencies.reserve(client->requests);
+
+    while (answered < client->requests) {
+        output.clear();
+        long long start = now();
+        while (sentCount < client->requests && sentCount - answered < options->depth) {
+            output += (*equations)[next++ % equations->size()];
+            sent[sentCount++ % MAX_DEPTH] = start;
+        }
+
+        size_t written = 0;
+        while (written < output.size()) {
+            ssize_t length = write(fd, output.data() + written, output.size() - written);
+            if (length <= 0) {
+                perror("write");
+                client->failed = true;
+                close(fd);
+                return;
+            }
+            written += length;
+        }
+
+        ssize_t length = read(fd, buffer, sizeof(buffer));
+        if (length <= 0) {
+            fprintf(stderr, "connection %d closed early\n", client->id);
+            client->failed = true;
+            close(fd);
+            return;
+        }
+        long long end = now();
+        for (ssize_t i = 0; i < length; i++) {
+            if (buffer[i] != '\n') continue;
+            client->latencies.push_back(end - sent[answered++ % MAX_DEPTH]);
+        }
+    }
+    close(fd);
+}
+
+/// Returns a percentile of sorted latencies.
+///
+/// @param latencies the latencies, in ascending order
+/// @param fraction the fraction of latencies at or below the percentile
+/// @return the percentile in microseconds
+
+double percentile(std::vector<long long>& latencies, double fraction) {
+    size_t index = (size_t) (fraction * (latencies.size() - 1));
+    return latencies[index] / 1000.0;
+}
+
+/// The main function...
+///
+/// @param argc the number of command line arguments
+/// @param argv the array of command line arguments
+/// @return EXIT_SUCCESS, or EXIT_FAILURE if a connection failed
+
+int main(int argc, char** argv) {
+    Options options;
+    processFlags(argc, argv, &options);
+
+    std::vector<std::string> equations;
+    if (!readEquations(options.path, equations)) return EXIT_FAILURE;
+
+    std::vector<Client> clients(options.connections);
+    for (int i = 0; i < options.connections; i++) {
+        clients[i].id = i;
+        clients[i].requests = options.requests / options.connections
+                + (i < options.requests % options.connections ? 1 : 0);
+        clients[i].failed = false;
+    }
+
+    long long start = now();
+    std::vector<std::thread> threads;
+    for (int i = 0; i < options.connections; i++) {
+        threads.push_back(std::thread(run, &clients[i], &options, &equations));
+    }
+    for (size_t i = 0; i < threads.size(); i++) {
+        threads[i].join();
+    }
+    double seconds = (now() - start) / 1e9;
+
+    std::vector<long long> latencies;
+    bool failed = false;
+    for (int i = 0; i < options.connections; i++) {
+        latencies.insert(latencies.end(), clients[i].latencies.begin(), clients[i].latencies.end());
+        failed = failed || clients[i].failed;
+    }
+    if (latencies.empty()) return EXIT_FAILURE;
+    std::sort(latencies.begin(), latencies.end());
+
+    printf("requests: %zu in %.3f s, %.0f requests/s\n", latencies.size(), seconds, latencies.size() / seconds);
+    printf("latency (us): p50 %.1f, p99 %.1f, p999 %.1f, max %.1f\n", percentile(latencies, 0.5),
+            percentile(latencies, 0.99), percentile(latencies, 0.999), latencies.back() / 1000.0);
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -7,57 +7,296 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <math.h>
+#include <limits.h>
+#include <new>
 
 #include "matrix.hpp"
+#include "kernels.hpp"
 
 #ifndef _MATRIX_IMPL_
 #define _MATRIX_IMPL_
 
-/// Swaps two rows in the matrix.
+/// The size in bytes of a cache line, which rows are aligned to.
 
-void Matrix::swapRows(int row1, int row2) {
-    if (row1 == row2) return;
+#define CACHE_LINE 64
 
-    char* tmp = atoms[row1];
-    atoms[row1] = atoms[row2];
-    atoms[row2] = tmp;
-    for (int i = 0; i < cols; i++) {
-        Fraction tmpFrac1(matrix[row1][i]);
-        Fraction tmpFrac2(matrix[row2][i]);
-        matrix[row1][i] = tmpFrac2;
-        matrix[row2][i] = tmpFrac1;
+/// Returns the number of cells a row of a given length is padded to so
+/// that every row starts on a cache line.
+///
+/// @tparam S the cell type
+/// @param length the number of cells in the row
+/// @return the padded length of the row
+
+template <typename S>
+inline int paddedLength(int length) {
+    int unit = CACHE_LINE;
+    for (int b = sizeof(S); b % 2 == 0 && unit > 1; b /= 2) unit /= 2;
+    return (length + unit - 1) / unit * unit;
+}
+
+/// Allocates a cache-aligned buffer of zeroed cells.
+///
+/// @tparam S the cell type
+/// @param count the number of cells
+/// @param arena the arena to allocate from, or NULL for the heap
+/// @return the buffer
+
+template <typename S>
+inline S* allocateCells(int count, Arena* arena) {
+    size_t bytes = ((size_t) count * sizeof(S) + CACHE_LINE - 1) / CACHE_LINE * CACHE_LINE;
+    if (bytes == 0) bytes = CACHE_LINE;
+    S* cells = (S*) (arena ? arena->allocate(bytes, CACHE_LINE) : aligned_alloc(CACHE_LINE, bytes));
+    for (int i = 0; i < count; i++) {
+        new (&cells[i]) S();
+    }
+    return cells;
+}
+
+/// Destroys and frees a buffer made by allocateCells. A buffer in an
+/// arena is only destroyed, and its memory is taken back on reset.
+///
+/// @tparam S the cell type
+/// @param cells the buffer
+/// @param count the number of cells
+/// @param arena the arena the buffer came from, or NULL for the heap
+
+template <typename S>
+inline void freeCells(S* cells, int count, Arena* arena) {
+    for (int i = 0; i < count; i++) {
+        cells[i].~S();
+    }
+    if (!arena) free(cells);
+}
+
+/// Loads an integer into a fraction-free cell.
+///
+/// @param cell the cell to set
+/// @param value the value to set it to
+
+template <typename S>
+inline void loadCell(S& cell, const Integer& value) {
+    cell = (S) value.toLong();
+}
+
+template <>
+inline void loadCell<Integer>(Integer& cell, const Integer& value) {
+    cell = value;
+}
+
+/// Checks whether a fraction-free cell is zero.
+///
+/// @param cell the cell to check
+/// @return whether or not the cell is zero
+
+template <typename S>
+inline bool cellIsZero(const S& cell) {
+    return cell == 0;
+}
+
+template <>
+inline bool cellIsZero<Integer>(const Integer& cell) {
+    return cell.isZero();
+}
+
+/// Returns a measure of the size of a fraction-free cell, used to pick
+/// the smallest pivot.
+///
+/// @param cell the cell to measure
+/// @return the size of the cell
+
+template <typename S>
+inline long long cellSize(const S& cell) {
+    return cell < 0 ? -(long long) cell : cell;
+}
+
+template <>
+inline long long cellSize<Integer>(const Integer& cell) {
+    return cell.bitLength();
+}
+
+/// Checks whether two fraction-free cells are equal.
+///
+/// @param a the first cell
+/// @param b the second cell
+/// @return whether or not they are equal
+
+template <typename S>
+inline bool cellEquals(const S& a, const S& b) {
+    return a == b;
+}
+
+template <>
+inline bool cellEquals<Integer>(const Integer& a, const Integer& b) {
+    return a.compare(b) == 0;
+}
+
+/// Converts a fraction-free cell to an Integer.
+///
+/// @param cell the cell to convert
+/// @return the value of the cell
+
+template <typename S>
+inline Integer toInteger(const S& cell) {
+    return Integer((long long) cell);
+}
+
+template <>
+inline Integer toInteger<Integer>(const Integer& cell) {
+    return cell;
+}
+
+/// Applies one Bareiss update to a cell, setting it to
+/// (pivot * cell - factor * pivotCell) / prev.
+///
+/// @tparam W a type wide enough to hold the product of two cells
+/// @param cell the cell to update
+/// @param pivot the current pivot
+/// @param factor the cell of this row in the pivot column
+/// @param pivotCell the cell of the pivot row in this column
+/// @param prev the previous pivot
+/// @param product scratch space for the product of two cells, which only
+///                the Integer update needs
+
+template <typename S, typename W>
+inline void bareissUpdate(S& cell, const S& pivot, const S& factor, const S& pivotCell, const S& prev,
+        S& /*product*/) {
+    if (cell == 0 && pivotCell == 0) return;
+    cell = (S) (((W) pivot * cell - (W) factor * pivotCell) / prev);
+}
+
+template <>
+inline void bareissUpdate<long long, __int128>(long long& cell, const long long& pivot, const long long& factor,
+        const long long& pivotCell, const long long& prev, long long& /*product*/) {
+    if (cell == 0 && pivotCell == 0) return;
+    __int128 value = (__int128) pivot * cell - (__int128) factor * pivotCell;
+    if (value == (long long) value) {
+        cell = (long long) value / prev;
+    } else {
+        cell = (long long) (value / prev);
+    }
+}
+
+template <>
+inline void bareissUpdate<Integer, Integer>(Integer& cell, const Integer& pivot, const Integer& factor,
+        const Integer& pivotCell, const Integer& prev, Integer& product) {
+    if (cell.isZero() && pivotCell.isZero()) return;
+    if (pivot.isSmall() && factor.isSmall() && prev.isSmall() && cell.isSmall() && pivotCell.isSmall()) {
+        __int128 value = (__int128) pivot.toLong() * cell.toLong()
+            - (__int128) factor.toLong() * pivotCell.toLong();
+        value /= prev.toLong();
+        if (value == (long long) value) {
+            cell = (long long) value;
+            return;
+        }
+    }
+    if (!pivot.isOne()) cell.multiply(pivot);
+    if (!factor.isZero() && !pivotCell.isZero()) {
+        product = factor;
+        product.multiply(pivotCell);
+        cell.subtract(product);
+    }
+    if (!prev.isOne()) cell.divide(prev);
+}
+
+/// Applies one Bareiss update to every cell of a row from a given column
+/// on.
+///
+/// @tparam W a type wide enough to hold the product of two cells
+/// @param row the row to update
+/// @param pivotRow the pivot row
+/// @param count the number of cells to update
+/// @param pivot the current pivot
+/// @param factor the cell of this row in the pivot column
+/// @param prev the previous pivot
+/// @param product scratch space for the product of two cells
+
+template <typename S, typename W>
+inline void bareissRow(S* row, const S* pivotRow, int count, const S& pivot, const S& factor, const S& prev,
+        S& product) {
+    for (int j = 0; j < count; j++) {
+        bareissUpdate<S, W>(row[j], pivot, factor, pivotRow[j], prev, product);
     }
 }
 
+template <>
+inline void bareissRow<short, int>(short* row, const short* pivotRow, int count, const short& pivot,
+        const short& factor, const short& prev, short& product) {
+    if (count >= KERNEL_MIN_LENGTH) {
+        Kernels::bareissRow(row, pivotRow, count, pivot, factor, prev);
+        return;
+    }
+    for (int j = 0; j < count; j++) {
+        bareissUpdate<short, int>(row[j], pivot, factor, pivotRow[j], prev, product);
+    }
+}
+
+template <>
+inline void bareissRow<int, long long>(int* row, const int* pivotRow, int count, const int& pivot,
+        const int& factor, const int& prev, int& product) {
+    if (count >= KERNEL_MIN_LENGTH) {
+        Kernels::bareissRow(row, pivotRow, count, pivot, factor, prev);
+        return;
+    }
+    for (int j = 0; j < count; j++) {
+        bareissUpdate<int, long long>(row[j], pivot, factor, pivotRow[j], prev, product);
+    }
+}
+
+/// Returns the position of a cell in the buffer.
+
+template <typename T, Layout L>
+inline int Matrix<T, L>::index(int row, int col) const {
+    if (L == ROW_MAJOR) return order[row] * stride + col;
+    return col * stride + order[row];
+}
+
+/// Swaps two rows in the matrix.
+
+template <typename T, Layout L>
+void Matrix<T, L>::swapRows(int row1, int row2) {
+    int tmp = order[row1];
+    order[row1] = order[row2];
+    order[row2] = tmp;
+}
+
 /// Multiplies a row by a scalar.
 
-void Matrix::multiplyRow(int row, Fraction scalar) {
-    for (int i = 0; i < cols; i++) {
-        matrix[row][i].multiply(scalar);
+template <typename T, Layout L>
+void Matrix<T, L>::multiplyRow(int row, const T& scalar) {
+    int step = L == ROW_MAJOR ? 1 : stride;
+    T* cell = &at(row, 0);
+    for (int i = 0; i < cols; i++, cell += step) {
+        cell->multiply(scalar);
     }
 }
 
 /// Adds a multiple of one row to another.
 
-void Matrix::addRow(int row1, int row2, Fraction scalar) {
-    for (int i = 0; i < cols; i++) {
-        Fraction f(matrix[row2][i]);
+template <typename T, Layout L>
+void Matrix<T, L>::addRow(int row1, int row2, const T& scalar) {
+    int step = L == ROW_MAJOR ? 1 : stride;
+    T* dst = &at(row1, 0);
+    T* src = &at(row2, 0);
+    for (int i = 0; i < cols; i++, dst += step, src += step) {
+        T f(*src);
         f.multiply(scalar);
-        matrix[row1][i].add(f);
+        dst->add(f);
     }
 }
 
 /// Row reduces the matrix to rref.
 
-void Matrix::reduce() {
+template <typename T, Layout L>
+void Matrix<T, L>::reduce() {
     int pivots = 0;
     for (int i = 0; i < cols; i++) {
         for (int j = pivots; j < rows; j++) {
-            if (!matrix[j][i].equals(0)) {
+            if (!at(j, i).equals(0)) {
                 swapRows(pivots, j);
-                Fraction f1 = matrix[pivots][i];
+                T f1 = at(pivots, i);
                 for (int k = pivots + 1; k < rows; k++) {
-                    Fraction f2(matrix[k][i]);
+                    T f2(at(k, i));
                     f2.multiply(-1);
                     f2.multiply(f1.getReciprocal());
                     addRow(k, pivots, f2);
@@ -70,11 +309,11 @@ void Matrix::reduce() {
 
     for (int i = rows - 1; i >= 0; i--) {
         for (int j = 0; j < cols; j++) {
-            if (!matrix[i][j].equals(0)) {
-                Fraction f1 = matrix[i][j];
+            if (!at(i, j).equals(0)) {
+                T f1 = at(i, j);
                 multiplyRow(i, f1.getReciprocal());
                 for (int k = i - 1; k >= 0; k--) {
-                    Fraction f2(matrix[k][j]);
+                    T f2(at(k, j));
                     f2.multiply(-1);
                     addRow(k, i, f2);
                 }
@@ -84,15 +323,292 @@ void Matrix::reduce() {
     }
 }
 
+/// Eliminates a fraction-free working copy of the matrix from a given
+/// column on.
+///
+/// This is the Gauss-Jordan form of Bareiss' algorithm: every row, above
+/// and below the pivot, is updated as (pivot * cell - factor * pivotCell)
+/// / previousPivot, which is always an exact division. At the end every
+/// pivot equals the last pivot, so dividing by it gives the rref.
+///
+/// When the largest magnitude of each row is tracked, a step is only taken
+/// once those magnitudes show none of its results can outgrow a long long.
+
+template <typename T, Layout L>
+template <typename S, typename W>
+int Matrix<T, L>::eliminate(S* work, int width, int* perm, S& prev, int& pivots, int col,
+        unsigned long long* peaks) {
+    S product(0);
+
+    for (int c = col; c < cols && pivots < rows; c++) {
+        int best = -1;
+        long long bestSize = 0;
+        for (int i = pivots; i < rows; i++) {
+            S& cell = work[perm[i] * width + c];
+            if (cellIsZero<S>(cell)) continue;
+            long long size = cellSize<S>(cell);
+            if (best == -1 || size < bestSize) {
+                best = i;
+                bestSize = size;
+            }
+        }
+        if (best == -1) continue;
+
+        int tmp = perm[best];
+        perm[best] = perm[pivots];
+        perm[pivots] = tmp;
+
+        S* pivotRow = &work[perm[pivots] * width];
+        S pivot(pivotRow[c]);
+        bool unchanged = cellEquals<S>(pivot, prev);
+
+        if (peaks != NULL) {
+            unsigned __int128 limit = (unsigned __int128) LLONG_MAX * cellSize<S>(prev);
+            for (int i = 0; i < rows; i++) {
+                if (i == pivots) continue;
+                unsigned __int128 peak = (unsigned __int128) cellSize<S>(pivot) * peaks[perm[i]]
+                    + (unsigned __int128) cellSize<S>(work[perm[i] * width + c]) * peaks[perm[pivots]];
+                if (peak > limit) return c;
+            }
+        }
+
+        for (int i = 0; i < rows; i++) {
+            if (i == pivots) continue;
+            S* row = &work[perm[i] * width];
+            S factor(row[c]);
+            if (cellIsZero<S>(factor) && unchanged) continue;
+
+            int from = i < pivots ? 0 : c;
+            if (peaks == NULL) {
+                bareissRow<S, W>(&row[from], &pivotRow[from], cols - from, pivot, factor, prev, product);
+                continue;
+            }
+
+            unsigned long long peak = 0;
+            for (int j = from; j < cols; j++) {
+                bareissUpdate<S, W>(row[j], pivot, factor, pivotRow[j], prev, product);
+                if ((unsigned long long) cellSize<S>(row[j]) > peak) peak = cellSize<S>(row[j]);
+            }
+            peaks[perm[i]] = peak;
+        }
+
+        prev = pivot;
+        pivots++;
+    }
+
+    return cols;
+}
+
+/// Writes the rref held in a fraction-free working copy back into the
+/// matrix, moving the rows to the order the elimination left them in.
+
+template <typename T, Layout L>
+template <typename S>
+void Matrix<T, L>::writeBack(S* work, int width, int* perm, const S& prev) {
+    int* moved = allocateCells<int>(rows, arena);
+    for (int i = 0; i < rows; i++) {
+        moved[i] = order[perm[i]];
+    }
+    memcpy(order, moved, rows * sizeof(int));
+    freeCells<int>(moved, rows, arena);
+
+    for (int i = 0; i < rows; i++) {
+        S* row = &work[perm[i] * width];
+        for (int j = 0; j < cols; j++) {
+            at(i, j) = cellIsZero<S>(row[j]) ? T(0) : T(row[j], prev);
+        }
+    }
+}
+
+/// Runs fraction-free elimination on a copy of the matrix stored with a
+/// narrower cell type, then writes the rref back. If a checked elimination
+/// stops because a value could outgrow the cell type, it carries on from
+/// that column with Integer cells.
+
+template <typename T, Layout L>
+template <typename S, typename W>
+void Matrix<T, L>::reduceWith(bool checked) {
+    int width = paddedLength<S>(cols);
+    S* work = allocateCells<S>(rows * width, arena);
+    int* perm = allocateCells<int>(rows, arena);
+    unsigned long long* peaks = checked ? allocateCells<unsigned long long>(rows, arena) : NULL;
+
+    for (int i = 0; i < rows; i++) {
+        perm[i] = i;
+        if (checked) peaks[i] = 0;
+        for (int j = 0; j < cols; j++) {
+            S& cell = work[i * width + j];
+            loadCell<S>(cell, at(i, j).getNum());
+            if (checked && (unsigned long long) cellSize<S>(cell) > peaks[i]) peaks[i] = cellSize<S>(cell);
+        }
+    }
+
+    S prev(1);
+    int pivots = 0;
+    int stop = eliminate<S, W>(work, width, perm, prev, pivots, 0, peaks);
+
+    if (stop < cols) {
+        int wide = paddedLength<Integer>(cols);
+        Integer* promoted = allocateCells<Integer>(rows * wide, arena);
+        for (int i = 0; i < rows; i++) {
+            for (int j = 0; j < cols; j++) {
+                promoted[i * wide + j] = toInteger<S>(work[i * width + j]);
+            }
+        }
+        Integer last = toInteger<S>(prev);
+        eliminate<Integer, Integer>(promoted, wide, perm, last, pivots, stop, NULL);
+        writeBack<Integer>(promoted, wide, perm, last);
+        freeCells<Integer>(promoted, rows * wide, arena);
+    } else {
+        writeBack<S>(work, width, perm, prev);
+    }
+
+    if (peaks) freeCells<unsigned long long>(peaks, rows, arena);
+    freeCells<int>(perm, rows, arena);
+    freeCells<S>(work, rows * width, arena);
+}
+
+/// Row reduces the matrix to rref with Bareiss fraction-free elimination.
+///
+/// Every value the elimination produces is a minor of the matrix, so the
+/// Hadamard bound on those minors picks the narrowest cell type that can
+/// hold them and the products of two of them. The bound is loose for the
+/// sparse matrices of real equations, so past it the elimination runs in
+/// 64-bit cells for as long as the values actually fit.
+
+template <typename T, Layout L>
+void Matrix<T, L>::reduceFractionFree() {
+    double* norms = allocateCells<double>(cols, arena);
+    bool small = true;
+
+    for (int j = 0; j < cols; j++) {
+        double sum = 0;
+        for (int i = 0; i < rows; i++) {
+            const T& cell = at(i, j);
+            if (!cell.getDen().isOne()) {
+                freeCells<double>(norms, cols, arena);
+                reduce();
+                return;
+            }
+            small &= cell.getNum().isSmall();
+            double value = cell.getNum().toDouble();
+            sum += value * value;
+        }
+        norms[j] = sum > 0 ? log2(sum) / 2 : 0;
+    }
+
+    int minors = rows < cols ? rows : cols;
+    double bound = 0;
+    for (int k = 0; k < minors; k++) {
+        int largest = 0;
+        for (int j = 1; j < cols; j++) {
+            if (norms[j] > norms[largest]) largest = j;
+        }
+        bound += norms[largest];
+        norms[largest] = 0;
+    }
+    freeCells<double>(norms, cols, arena);
+
+    bound += 0.01;
+    if (bound < 15) {
+        reduceWith<short, int>(false);
+    } else if (bound < 31) {
+        reduceWith<int, long long>(false);
+    } else if (small) {
+        reduceWith<long long, __int128>(bound >= 63);
+    } else {
+        reduceWith<Integer, Integer>(false);
+    }
+}
+
+/// Row reduces the matrix to rref by reducing it modulo word-sized primes.
+
+template <typename T, Layout L>
+void Matrix<T, L>::reduceModular() {
+    Integer* values = allocateCells<Integer>(rows * cols, arena);
+
+    for (int i = 0; i < rows; i++) {
+        for (int j = 0; j < cols; j++) {
+            const T& cell = at(i, j);
+            if (!cell.getDen().isOne()) {
+                freeCells<Integer>(values, rows * cols, arena);
+                reduce();
+                return;
+            }
+            values[i * cols + j] = cell.getNum();
+        }
+    }
+
+    ModularReducer reducer(values, rows, cols);
+    if (reducer.reduce()) {
+        for (int i = 0; i < rows; i++) {
+            for (int j = 0; j < cols; j++) {
+                at(i, j) = reducer.getValue(i, j);
+            }
+        }
+    } else {
+        reduceFractionFree();
+    }
+
+    freeCells<Integer>(values, rows * cols, arena);
+}
+
+/// Row reduces the matrix to rref with the chosen engine.
+
+template <typename T, Layout L>
+void Matrix<T, L>::reduce(Engine engine) {
+    if (engine == FRACTION_FREE) {
+        reduceFractionFree();
+    } else if (engine == MODULAR) {
+        reduceModular();
+    } else {
+        reduce();
+    }
+}
+
 /// Returns the simplest non-zero solution to the matrix
 
-Solution Matrix::solve() {
-    Solution solution(cols - 1);
+template <typename T, Layout L>
+Solution Matrix<T, L>::solve() {
+    return solveReduced(*this);
+}
+
+/// Returns the column of the first non-zero entry in a row.
+
+template <typename T, Layout L>
+int Matrix<T, L>::getLead(int row) {
+    for (int j = 0; j < cols; j++) {
+        if (!at(row, j).equals(0)) return j;
+    }
+    return cols;
+}
+
+/// Checks whether any cell of the matrix overflowed while it was
+/// being computed.
+
+template <typename T, Layout L>
+bool Matrix<T, L>::getOverflow() {
+    for (int i = 0; i < rows; i++) {
+        for (int j = 0; j < cols; j++) {
+            if (at(i, j).getOverflow()) return true;
+        }
+    }
+    return false;
+}
+
+/// Returns the simplest non-zero solution to a matrix in rref.
+
+template <typename M>
+Solution solveReduced(M& matrix) {
+    int rows = matrix.getRows();
+    int cols = matrix.getCols();
+    Solution solution(cols - 1, matrix.getArena());
     bool fixed = false;
-    
+
     if (cols == 1) {
+        solution.setUnique(true);
         for (int i = 0; i < rows; i++) {
-            if (!matrix[i][0].equals(0)) {
+            if (!matrix.getValue(i, 0).equals(0)) {
                 solution.setStatus(UNBALANCED);
                 return solution;
             }
@@ -102,61 +618,55 @@ Solution Matrix::solve() {
     }
 
     for (int i = rows - 1; i >= 0; i--) {
-        Fraction total(matrix[i][cols - 1]);
+        Rational total(matrix.getValue(i, cols - 1));
+        int lead = matrix.getLead(i);
         if (!fixed) fixed = !total.equals(0);
         for (int j = cols - 2; j >= 0; j--) {
-            Fraction current = solution.getValue(j);
-            if (current.getNum() >= 0) {
-                Fraction f(matrix[i][j]);
+            Rational current = solution.getValue(j);
+            if (current.getNum().sign() >= 0) {
+                Rational f(matrix.getValue(i, j));
                 f.multiply(current);
                 total.add(f);
                 continue;
             }
-            bool pivot = true;
-            for (int k = j - 1; k >= 0; k--) {
-                if (!matrix[i][k].equals(0)) {
-                    pivot = false;
-                    break;
-                }
-            }
-            if (!pivot) {
-                Fraction f(matrix[i][j]);
-                if (total.equals(0)) {
-                    solution.setValue(Fraction(f.getDen()), j);
-                    total.add(Fraction(f.getNum()));
+            if (j > lead) {
+                Rational f(matrix.getValue(i, j));
+                if (total.equals(0) || f.equals(0)) {
+                    solution.setValue(Rational(f.getDen()), j);
+                    total.add(Rational(f.getNum()));
                 } else {
                     total.multiply(f.getReciprocal());
-                    solution.setValue(Fraction(total.getNum()), j);
+                    solution.setValue(Rational(total.getNum()), j);
                     if (!fixed) {
-                        int den = total.getDen();
-                        if (den != 1) {
+                        Integer den = total.getDen();
+                        if (!den.isOne()) {
                             for (int k = j; k < cols - 1; k++) {
-                                Fraction f = solution.getValue(k);
-                                f.multiply(Fraction(den));
+                                Rational f = solution.getValue(k);
+                                f.multiply(Rational(den));
                                 solution.setValue(f, k);
                             }
                         }
                     }
-                } 
+                }
             } else {
-                Fraction f(matrix[i][j]);
+                Rational f(matrix.getValue(i, j));
                 if (total.equals(0)) {
                     if (f.equals(0)) break;
-                    solution.setValue(Fraction(0), j);
+                    solution.setValue(Rational(0), j);
                 } else if (f.equals(0)) {
                     solution.setStatus(UNSOLVED);
                     return solution;
                 } else {
-                    Fraction reciprocal = f.getReciprocal();
+                    Rational reciprocal = f.getReciprocal();
                     reciprocal.multiply(-1);
                     total.multiply(reciprocal);
-                    solution.setValue(Fraction(total), j);
+                    solution.setValue(Rational(total), j);
                     if (!fixed) {
-                        int den = total.getDen();
-                        if (den != 1) {
+                        Integer den = total.getDen();
+                        if (!den.isOne()) {
                             for (int k = j; k < cols - 1; k++) {
-                                Fraction f = solution.getValue(k);
-                                f.multiply(Fraction(den));
+                                Rational f = solution.getValue(k);
+                                f.multiply(Rational(den));
                                 solution.setValue(f, k);
                             }
                         }
@@ -167,31 +677,90 @@ Solution Matrix::solve() {
             }
         }
     }
-    
-    solution.setStatus(SOLVED);
+
+    bool overflow = matrix.getOverflow();
+    for (int i = 0; i < cols - 1 && !overflow; i++) {
+        overflow = solution.getValue(i).getOverflow();
+    }
+    solution.setStatus(overflow ? OVERFLOWED : SOLVED);
+
+    // Only a one-dimensional null space with every coefficient positive is
+    // reduced to the same coefficients whatever the column order.
+    int pivots = 0;
+    bool unique = !overflow;
+    for (int i = 0; i < rows && unique; i++) {
+        if (matrix.getLead(i) < cols - 1) pivots++;
+        unique = matrix.getValue(i, cols - 1).equals(0);
+    }
+    for (int i = 0; i < cols - 1 && unique; i++) {
+        unique = solution.getValue(i).getNum().sign() > 0;
+    }
+    solution.setUnique(unique && pivots == cols - 2);
     return solution;
 }
 
-/// Sets the value of an entry in the matrix.
+/// Returns the arena the matrix allocates from.
 
-void Matrix::setValue(char* atom, int col, int quantity) {
-    for (int i = 0; i < rows; i++) {
-        if (!strcmp(atoms[i], atom)) {
-            Fraction f(quantity);
-            matrix[i][col] = f;
-            return;
-        }
-    }
+template <typename T, Layout L>
+Arena* Matrix<T, L>::getArena() const {
+    return arena;
+}
+
+/// Returns the number of rows in the matrix.
+
+template <typename T, Layout L>
+int Matrix<T, L>::getRows() const {
+    return rows;
+}
+
+/// Returns the number of columns in the matrix.
+
+template <typename T, Layout L>
+int Matrix<T, L>::getCols() const {
+    return cols;
+}
+
+/// Returns the element a row corresponds to.
+
+template <typename T, Layout L>
+int Matrix<T, L>::getAtom(int row) const {
+    return atoms[order[row]];
+}
+
+/// Returns a reference to a cell in the matrix.
+
+template <typename T, Layout L>
+inline T& Matrix<T, L>::at(int row, int col) {
+    return cells[index(row, col)];
+}
+
+/// Returns a reference to a cell in the matrix.
+
+template <typename T, Layout L>
+inline const T& Matrix<T, L>::at(int row, int col) const {
+    return cells[index(row, col)];
+}
+
+/// Adds a quantity to an entry in the matrix.
+
+template <typename T, Layout L>
+void Matrix<T, L>::addValue(int row, int col, long long quantity) {
+    at(row, col).add(T(quantity));
 }
 
 /// Prints a representation of the entire matrix.
 
-void Matrix::printMatrix() {
+template <typename T, Layout L>
+void Matrix<T, L>::printMatrix() {
     printf("==========MATRIX==========\n");
     for (int i = 0; i < rows; i++) {
-        printf("%s:\t", atoms[i]);
+        printf("%s:\t", PeriodicTable::symbol(getAtom(i)));
         for (int j = 0; j < cols; j++) {
-            printf("%d/%d\t", matrix[i][j].getNum(), matrix[i][j].getDen());
+            std::string cell;
+            at(i, j).getNum().toString(cell);
+            cell += '/';
+            at(i, j).getDen().toString(cell);
+            printf("%s\t", cell.c_str());
         }
         printf("\n");
     }
@@ -199,19 +768,51 @@ void Matrix::printMatrix() {
 
 /// Returns the value of an entry in the matrix.
 
-Fraction Matrix::getValue(int row, int col) {
-    return matrix[row][col];
+template <typename T, Layout L>
+T Matrix<T, L>::getValue(int row, int col) {
+    return at(row, col);
 }
 
 /// Constructor for the Matrix class.
 
-Matrix::Matrix(char** atoms, int rows, int cols) {
+template <typename T, Layout L>
+Matrix<T, L>::Matrix(int* atoms, int rows, int cols, Arena* arena) {
     this->rows = rows;
     this->cols = cols;
     this->atoms = atoms;
-    matrix = (Fraction**) malloc(rows * sizeof(Fraction*));
+    this->arena = arena;
+    stride = paddedLength<T>(L == ROW_MAJOR ? cols : rows);
+    order = allocateCells<int>(rows, arena);
     for (int i = 0; i < rows; i++) {
-        matrix[i] = (Fraction*) malloc(cols * sizeof(Fraction));
+        order[i] = i;
+    }
+    cells = allocateCells<T>(stride * (L == ROW_MAJOR ? rows : cols), arena);
+}
+
+/// Move constructor for the Matrix class.
+
+template <typename T, Layout L>
+Matrix<T, L>::Matrix(Matrix&& other) {
+    rows = other.rows;
+    cols = other.cols;
+    stride = other.stride;
+    atoms = other.atoms;
+    arena = other.arena;
+    order = other.order;
+    cells = other.cells;
+    other.rows = 0;
+    other.cols = 0;
+    other.order = NULL;
+    other.cells = NULL;
+}
+
+/// Destructor for the Matrix class.
+
+template <typename T, Layout L>
+Matrix<T, L>::~Matrix() {
+    if (cells != NULL) {
+        freeCells<T>(cells, stride * (L == ROW_MAJOR ? rows : cols), arena);
+        freeCells<int>(order, rows, arena);
     }
 }
 
@@ -7,33 +7,63 @@
 #ifndef _MATRIX_H_
 #define _MATRIX_H_
 
-#include "fraction.hpp"
+#include "rational.hpp"
 #include "solution.hpp"
+#include "modular.hpp"
+#include "element.hpp"
+#include "arena.hpp"
+
+/// The Engine enum selects the elimination used to reduce a matrix.
+
+enum Engine {
+    GAUSS_JORDAN,
+    FRACTION_FREE,
+    MODULAR,
+    SPARSE
+};
+
+/// The Layout enum selects how the cells of a matrix are laid out
+/// in memory.
+
+enum Layout {
+    ROW_MAJOR,
+    COLUMN_MAJOR
+};
 
 /// The Matrix class represents a matrix where
 /// each row corresponds to an atom and each
 /// column corresponds to a molecule.
+///
+/// The cells are held in one contiguous buffer whose rows (or columns,
+/// for a column-major matrix) are padded to start on a cache line. Rows
+/// are reached through a permutation, so swapping two rows swaps two
+/// indices instead of copying cells.
 
+template <typename T, Layout L = ROW_MAJOR>
 class Matrix {
     private:
         int rows;
         int cols;
-        char** atoms;
-        Fraction** matrix;
+        int stride;
+        int* atoms;
+        int* order;
+        T* cells;
+        Arena* arena;
 
-        /// Swaps two rows in the matrix.
+        /// Returns the position of a cell in the buffer.
         ///
-        /// @param row1 the first row
-        /// @param row2 the second row
+        /// @param row the logical row of the cell
+        /// @param col the column of the cell
+        /// @return the index of the cell
+
+        int index(int row, int col) const;
 
-        void swapRows(int row1, int row2);
-        
         /// Multiplies a row by a scalar.
         ///
         /// @param row the row to multiply
         /// @param scalar the scalar to multiply by
 
-        void multiplyRow(int row, Fraction scalar);
+        void multiplyRow(int row, const T& scalar);
 
         /// Adds a multiple of one row to another.
         ///
@@ -41,37 +71,179 @@ class Matrix {
         /// @param row2 the row to multiply and add
         /// @oaram scalar the scalar to multiply by
 
-        void addRow(int row1, int row2, Fraction scalar);
+        void addRow(int row1, int row2, const T& scalar);
+
+        /// Eliminates a fraction-free working copy of the matrix from a
+        /// given column on.
+        ///
+        /// @tparam S the cell type to eliminate with
+        /// @tparam W a type wide enough to hold the product of two cells
+        /// @param work the working cells, one padded row after another
+        /// @param width the padded length of a working row
+        /// @param perm the working row in each logical row
+        /// @param prev the previous pivot
+        /// @param pivots the number of pivots found so far
+        /// @param col the column to start from
+        /// @param peaks the largest magnitude in each working row, or NULL
+        ///              if the results are known to fit
+        /// @return the column elimination stopped at, which is cols unless
+        ///         a result could outgrow a long long
+
+        template <typename S, typename W>
+        int eliminate(S* work, int width, int* perm, S& prev, int& pivots, int col,
+                unsigned long long* peaks);
+
+        /// Writes the rref held in a fraction-free working copy back into
+        /// the matrix.
+        ///
+        /// @tparam S the cell type of the working copy
+        /// @param work the working cells
+        /// @param width the padded length of a working row
+        /// @param perm the working row in each logical row
+        /// @param prev the last pivot
+
+        template <typename S>
+        void writeBack(S* work, int width, int* perm, const S& prev);
+
+        /// Runs fraction-free elimination on a copy of the matrix stored
+        /// with a narrower cell type, then writes the rref back.
+        ///
+        /// @tparam S the cell type to eliminate with
+        /// @tparam W a type wide enough to hold the product of two cells
+        /// @param checked whether results may outgrow the cell type and
+        ///                must be checked
+
+        template <typename S, typename W>
+        void reduceWith(bool checked);
 
     public:
         /// Constructor for the Matrix class.
         ///
-        /// @param atoms the list of atoms
+        /// @param atoms the element ID of each row
         /// @oaram rows the number of rows
         /// @param cols the number of columns
+        /// @param arena the arena to allocate from, or NULL for the heap
+
+        Matrix(int* atoms, int rows, int cols, Arena* arena = NULL);
+
+        /// Move constructor for the Matrix class.
+        ///
+        /// @param other the matrix to take the cells of
+
+        Matrix(Matrix&& other);
+
+        /// Destructor for the Matrix class.
+
+        ~Matrix();
+
+        Matrix(const Matrix& copy) = delete;
+        Matrix& operator=(const Matrix& copy) = delete;
+
+        /// Returns the arena the matrix allocates from.
+        ///
+        /// @return the arena, or NULL if the matrix uses the heap
+
+        Arena* getArena() const;
+
+        /// Returns the number of rows in the matrix.
+        ///
+        /// @return the number of rows
+
+        int getRows() const;
+
+        /// Returns the number of columns in the matrix.
+        ///
+        /// @return the number of columns
+
+        int getCols() const;
+
+        /// Returns the element a row corresponds to.
+        ///
+        /// @param row the row
+        /// @return the element ID of the row
+
+        int getAtom(int row) const;
+
+        /// Returns a reference to a cell in the matrix.
+        ///
+        /// @param row the row of the cell
+        /// @param col the column of the cell
+        /// @return the cell
+
+        T& at(int row, int col);
+
+        /// Returns a reference to a cell in the matrix.
+        ///
+        /// @param row the row of the cell
+        /// @param col the column of the cell
+        /// @return the cell
+
+        const T& at(int row, int col) const;
+
+        /// Swaps two rows in the matrix.
+        ///
+        /// @param row1 the first row
+        /// @param row2 the second row
+
+        void swapRows(int row1, int row2);
 
-        Matrix(char** atoms, int rows, int cols);
-        
         /// Returns the value of an entry in the matrix.
         ///
         /// @param row the row of the entry
         /// @param col the column of the entry
-        /// @return the Fraction held in the cell
+        /// @return the value held in the cell
+
+        T getValue(int row, int col);
+
+        /// Returns the column of the first non-zero entry in a row.
+        ///
+        /// @param row the row
+        /// @return the column, or the number of columns if the row is zero
 
-        Fraction getValue(int row, int col);
+        int getLead(int row);
 
-        /// Sets the value of an entry in the matrix.
+        /// Checks whether any cell of the matrix overflowed while it was
+        /// being computed.
         ///
-        /// @param atom the atom row to set
-        /// @param col the column to set
-        /// @param quantity the value to set the cell to
+        /// @return whether or not an overflow occurred
+
+        bool getOverflow();
+
+        /// Adds a quantity to an entry in the matrix.
+        ///
+        /// @param row the row of the entry
+        /// @param col the column of the entry
+        /// @param quantity the value to add to the cell
+
+        void addValue(int row, int col, long long quantity);
 
-        void setValue(char* atom, int col, int quantity);
-        
         /// Row reduces the matrix to rref.
 
         void reduce();
 
+        /// Row reduces the matrix to rref with Bareiss fraction-free
+        /// elimination. The cells are eliminated as integers, dividing
+        /// each update exactly by the previous pivot, and only converted
+        /// back to rationals once at the end. The integers are held in the
+        /// narrowest of 16, 32 or 64 bits that fits them, and in Integers
+        /// past that. Falls back to reduce() if any cell is not an integer.
+
+        void reduceFractionFree();
+
+        /// Row reduces the matrix to rref by reducing it modulo word-sized
+        /// primes and rebuilding the rational entries, which avoids the
+        /// coefficient growth of exact elimination on large systems. Falls
+        /// back to reduce() if any cell is not an integer, and to
+        /// reduceFractionFree() if the primes run out.
+
+        void reduceModular();
+
+        /// Row reduces the matrix to rref with the chosen engine.
+        ///
+        /// @param engine the elimination to use
+
+        void reduce(Engine engine);
+
         /// Returns the simplest non-zero solution to the matrix.
         ///
         /// @return the solution for the matrix
@@ -83,4 +255,17 @@ class Matrix {
         void printMatrix();
 };
 
+/// Returns the simplest non-zero solution to a matrix in rref. The
+/// matrix only needs getRows, getCols, getValue, getLead, getOverflow and
+/// getArena, so the dense and sparse matrices share this.
+///
+/// @tparam M the type of the matrix
+/// @param matrix the matrix to solve
+/// @return the solution for the matrix
+
+template <typename M>
+Solution solveReduced(M& matrix);
+
+#include "matrix.cpp"
+
 #endif
@@ -0,0 +1,648 @@
+///
+/// file: modular.cpp
+/// Implementation for the ModularReducer class
+///
+/// @author Dominick Banasik
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <thread>
+
+#include "modular.hpp"
+#include "kernels.hpp"
+
+#ifndef _MODULAR_IMPL_
+#define _MODULAR_IMPL_
+
+#define PRIME_COUNT 1024
+#define PRIME_LIMIT 2147483648U
+
+/// Raises a number to a power modulo a 32-bit modulus.
+///
+/// @param base the number to raise
+/// @param exponent the power to raise it to
+/// @param modulus the modulus
+/// @return the result
+
+static unsigned long long power(unsigned long long base, unsigned long long exponent, unsigned long long modulus) {
+    unsigned long long result = 1;
+    base %= modulus;
+    while (exponent > 0) {
+        if (exponent & 1) result = result * base % modulus;
+        base = base * base % modulus;
+        exponent >>= 1;
+    }
+    return result;
+}
+
+/// Checks whether a 32-bit number is prime with the Miller-Rabin test,
+/// which is deterministic below 2^32 for the bases 2, 7 and 61.
+///
+/// @param n the number to check
+/// @return whether or not the number is prime
+
+static bool isPrime(unsigned int n) {
+    if (n < 2) return false;
+    if (n % 2 == 0) return n == 2;
+
+    unsigned int odd = n - 1;
+    int twos = 0;
+    while (odd % 2 == 0) {
+        odd /= 2;
+        twos++;
+    }
+
+    const unsigned int bases[] = {2, 7, 61};
+    for (int i = 0; i < 3; i++) {
+        if (bases[i] % n == 0) continue;
+        unsigned long long x = power(bases[i], odd, n);
+        if (x == 1 || x == n - 1) continue;
+        bool composite = true;
+        for (int j = 1; j < twos && composite; j++) {
+            x = x * x % n;
+            if (x == n - 1) composite = false;
+        }
+        if (composite) return false;
+    }
+    return true;
+}
+
+/// Fills a table with the largest primes below 2^31, largest first.
+///
+/// @param table the table to fill
+/// @return true once the table is filled
+
+static bool fillPrimes(unsigned int* table) {
+    unsigned int candidate = PRIME_LIMIT - 1;
+    for (int i = 0; i < PRIME_COUNT; candidate -= 2) {
+        if (isPrime(candidate)) table[i++] = candidate;
+    }
+    return true;
+}
+
+/// Returns one of the primes used by the reducer.
+///
+/// @param index the index of the prime
+/// @return the prime
+
+static unsigned int primeAt(int index) {
+    static unsigned int table[PRIME_COUNT];
+    static bool filled = fillPrimes(table);
+    (void) filled;
+    return table[index];
+}
+
+/// Returns the inverse of a number modulo a prime.
+///
+/// @param value the non-zero number to invert
+/// @param prime the prime
+/// @return the inverse
+
+static unsigned int inverse(unsigned int value, unsigned int prime) {
+    long long r0 = prime;
+    long long r1 = value;
+    long long t0 = 0;
+    long long t1 = 1;
+    while (r1 != 0) {
+        long long quotient = r0 / r1;
+        long long r = r0 - quotient * r1;
+        r0 = r1;
+        r1 = r;
+        long long t = t0 - quotient * t1;
+        t0 = t1;
+        t1 = t;
+    }
+    return (unsigned int) (t0 < 0 ? t0 + prime : t0);
+}
+
+/// Rebuilds a fraction from its residue with the extended Euclidean
+/// algorithm, stopping at the first remainder below 2^bits. The fraction
+/// is unique as long as both its parts are below 2^bits and the modulus
+/// is at least 2^(2 * bits + 1).
+///
+/// @param residue the residue, from 0 to modulus - 1
+/// @param modulus the modulus
+/// @param bits the bound on both parts of the fraction
+/// @param num where to store the numerator
+/// @param den where to store the positive denominator
+/// @return whether or not a fraction within the bound exists
+
+static bool rebuild(const Integer& residue, const Integer& modulus, int bits, Integer& num, Integer& den) {
+    Integer r0(modulus);
+    Integer r1(residue);
+    Integer t0(0);
+    Integer t1(1);
+    Integer quotient;
+    Integer remainder;
+
+    while (r1.bitLength() > bits) {
+        quotient = r0;
+        quotient.divide(r1, &remainder);
+        r0 = static_cast<Integer&&>(r1);
+        r1 = static_cast<Integer&&>(remainder);
+        quotient.multiply(t1);
+        t0.subtract(quotient);
+        Integer t(static_cast<Integer&&>(t0));
+        t0 = static_cast<Integer&&>(t1);
+        t1 = static_cast<Integer&&>(t);
+    }
+
+    if (t1.isZero() || t1.bitLength() > bits) return false;
+    if (t1.sign() < 0) {
+        r1.negate();
+        t1.negate();
+    }
+    if (!Integer::gcd(r1, t1).isOne()) return false;
+
+    num = r1;
+    den = t1;
+    return true;
+}
+
+/// Row reduces the matrix modulo a prime into the work buffer.
+
+int ModularReducer::reducePrime(unsigned int prime) {
+    for (int i = 0; i < rows * cols; i++) {
+        const Integer& cell = cells[i];
+        if (cell.isSmall()) {
+            long long residue = cell.toLong() % (long long) prime;
+            work[i] = (unsigned int) (residue < 0 ? residue + prime : residue);
+        } else {
+            work[i] = cell.modulo(prime);
+        }
+    }
+    if (tracker) return reduceBlocked(prime);
+
+    int count = 0;
+    for (int c = 0; c < cols && count < rows; c++) {
+        int found = -1;
+        for (int i = count; i < rows; i++) {
+            if (work[i * cols + c] != 0) {
+                found = i;
+                break;
+            }
+        }
+        if (found == -1) continue;
+
+        unsigned int* pivotRow = &work[count * cols];
+        if (found != count) {
+            unsigned int* row = &work[found * cols];
+            for (int j = c; j < cols; j++) {
+                unsigned int tmp = row[j];
+                row[j] = pivotRow[j];
+                pivotRow[j] = tmp;
+            }
+        }
+
+        // Long rows that are mostly non-zero are updated whole by the
+        // vector kernels; the rest only at the pivot row's non-zeros.
+        unsigned int scale = inverse(pivotRow[c], prime);
+        int length = cols - c;
+        bool dense = length >= KERNEL_MIN_LENGTH && Kernels::countNonzero(&pivotRow[c], length) * 2 >= length;
+        int nonzero = 0;
+        if (dense) {
+            Kernels::scaleMod(&pivotRow[c], length, scale, prime);
+        } else {
+            unsigned long long scaleQuotient = shoup(scale, prime);
+            for (int j = c; j < cols; j++) {
+                if (pivotRow[j] == 0) continue;
+                pivotRow[j] = multiplyMod(pivotRow[j], scale, scaleQuotient, prime);
+                support[nonzero++] = j;
+            }
+        }
+
+        for (int i = 0; i < rows; i++) {
+            if (i == count) continue;
+            unsigned int* row = &work[i * cols];
+            if (row[c] == 0) continue;
+            unsigned int factor = prime - row[c];
+            if (dense) {
+                Kernels::addScaledMod(&row[c], &pivotRow[c], length, factor, prime);
+                continue;
+            }
+            unsigned long long quotient = shoup(factor, prime);
+            for (int k = 0; k < nonzero; k++) {
+                int j = support[k];
+                unsigned int value = row[j] + multiplyMod(pivotRow[j], factor, quotient, prime);
+                row[j] = value >= prime ? value - prime : value;
+            }
+        }
+
+        candidate[count++] = c;
+    }
+
+    return count;
+}
+
+/// Row reduces the work buffer modulo a prime a panel of columns at a
+/// time.
+///
+/// The rows are split evenly between the members of the team for the
+/// steps inside a panel, and member 0 alone finds and swaps each pivot
+/// between two syncs. Rows below the pivots found so far are zero left of
+/// the panel, so swapping them and eliminating with them only changes the
+/// panel and the columns past it. The columns past the panel are left
+/// untouched until the panel is done: a pivot row there becomes the
+/// combination of the old pivot rows given by its tracker row, and any
+/// other row has that combination added to it.
+
+int ModularReducer::reduceBlocked(unsigned int prime) {
+    int threads = team->getSize();
+    int rowTiles = (rows + TILE_ROWS - 1) / TILE_ROWS;
+    int pivotCol = -1;
+    std::atomic<int> nextTile(0);
+
+    auto body = [&](int id) {
+        int first = (int) ((long long) rows * id / threads);
+        int last = (int) ((long long) rows * (id + 1) / threads);
+        int count = 0;
+
+        for (int start = 0; start < cols && count < rows; start += PANEL_WIDTH) {
+            int end = start + PANEL_WIDTH < cols ? start + PANEL_WIDTH : cols;
+            int base = count;
+            memset(&tracker[first * PANEL_WIDTH], 0, (size_t) (last - first) * PANEL_WIDTH * sizeof(unsigned int));
+            team->sync();
+            int c = start;
+
+            while (true) {
+                if (id == 0) {
+                    pivotCol = -1;
+                    for (; c < end && count < rows && pivotCol == -1; c++) {
+                        for (int i = count; i < rows; i++) {
+                            if (work[i * cols + c] == 0) continue;
+                            pivotCol = c;
+                            if (i != count) {
+                                unsigned int* row = &work[i * cols];
+                                unsigned int* other = &work[count * cols];
+                                for (int j = c; j < cols; j++) {
+                                    unsigned int tmp = row[j];
+                                    row[j] = other[j];
+                                    other[j] = tmp;
+                                }
+                                for (int k = 0; k < PANEL_WIDTH; k++) {
+                                    unsigned int tmp = tracker[i * PANEL_WIDTH + k];
+                                    tracker[i * PANEL_WIDTH + k] = tracker[count * PANEL_WIDTH + k];
+                                    tracker[count * PANEL_WIDTH + k] = tmp;
+                                }
+                            }
+                            break;
+                        }
+                    }
+
+                    if (pivotCol != -1) {
+                        unsigned int* pivotRow = &work[count * cols];
+                        unsigned int scale = inverse(pivotRow[pivotCol], prime);
+                        tracker[count * PANEL_WIDTH + count - base] = 1;
+                        Kernels::scaleMod(&pivotRow[pivotCol], end - pivotCol, scale, prime);
+                        Kernels::scaleMod(&tracker[count * PANEL_WIDTH], count - base + 1, scale, prime);
+                        candidate[count] = pivotCol;
+                    }
+                }
+                team->sync();
+                if (pivotCol == -1) break;
+
+                const unsigned int* pivotRow = &work[count * cols];
+                const unsigned int* pivotTracker = &tracker[count * PANEL_WIDTH];
+                for (int i = first; i < last; i++) {
+                    unsigned int* row = &work[i * cols];
+                    if (i == count || row[pivotCol] == 0) continue;
+                    unsigned int factor = prime - row[pivotCol];
+                    Kernels::addScaledMod(&tracker[i * PANEL_WIDTH], pivotTracker, count - base + 1, factor, prime);
+                    Kernels::addScaledMod(&row[pivotCol], &pivotRow[pivotCol], end - pivotCol, factor, prime);
+                }
+                count++;
+                team->sync();
+            }
+
+            // Copy out the old pivot rows past the panel, then rebuild every
+            // row there from them one tile at a time.
+            int found = count - base;
+            int width = cols - end;
+            if (found == 0 || width == 0) continue;
+            for (int k = base + id; k < count; k += threads) {
+                memcpy(&copies[(k - base) * width], &work[k * cols + end], width * sizeof(unsigned int));
+            }
+            if (id == 0) nextTile.store(0);
+            team->sync();
+
+            int colTiles = (width + TILE_COLS - 1) / TILE_COLS;
+            for (int tile = nextTile.fetch_add(1); tile < rowTiles * colTiles; tile = nextTile.fetch_add(1)) {
+                int j0 = tile / rowTiles * TILE_COLS;
+                int length = j0 + TILE_COLS < width ? TILE_COLS : width - j0;
+                int i0 = tile % rowTiles * TILE_ROWS;
+                int i1 = i0 + TILE_ROWS < rows ? i0 + TILE_ROWS : rows;
+                for (int i = i0; i < i1; i++) {
+                    unsigned int* row = &work[i * cols + end + j0];
+                    const unsigned int* combination = &tracker[i * PANEL_WIDTH];
+                    if (i >= base && i < count) memset(row, 0, length * sizeof(unsigned int));
+                    for (int k = 0; k < found; k++) {
+                        if (combination[k] == 0) continue;
+                        Kernels::addScaledMod(row, &copies[k * width + j0], length, combination[k], prime);
+                    }
+                }
+            }
+            team->sync();
+        }
+
+        return count;
+    };
+
+    int result = 0;
+    team->run([&](int id) {
+        int count = body(id);
+        if (id == 0) result = count;
+    });
+    return result;
+}
+
+/// Checks whether the pivots just found are better than the best so far.
+
+int ModularReducer::comparePivots(int count) const {
+    if (count != rank) return count > rank ? 1 : -1;
+    for (int i = 0; i < rank; i++) {
+        if (candidate[i] != pivots[i]) return candidate[i] < pivots[i] ? 1 : -1;
+    }
+    return 0;
+}
+
+/// Makes the pivots just found the best so far.
+
+void ModularReducer::adoptPivots(int count) {
+    rank = count;
+    memcpy(pivots, candidate, count * sizeof(int));
+    for (int j = 0; j < cols; j++) {
+        pivotal[j] = false;
+    }
+    for (int i = 0; i < rank; i++) {
+        pivotal[pivots[i]] = true;
+    }
+    modulus = 1;
+}
+
+/// Combines the rref modulo a prime with the residues so far, lifting
+/// each residue from modulus to modulus * prime.
+
+void ModularReducer::combine(unsigned int prime) {
+    if (modulus.isOne()) {
+        for (int i = 0; i < rank; i++) {
+            for (int j = 0; j < cols; j++) {
+                if (!pivotal[j]) residues[i * cols + j] = (long long) work[i * cols + j];
+            }
+        }
+        modulus = (long long) prime;
+        return;
+    }
+
+    unsigned int lift = inverse(modulus.modulo(prime), prime);
+    Integer step;
+
+    for (int i = 0; i < rank; i++) {
+        for (int j = 0; j < cols; j++) {
+            if (pivotal[j]) continue;
+            Integer& residue = residues[i * cols + j];
+            unsigned long long difference = work[i * cols + j] + prime - residue.modulo(prime);
+            unsigned long long factor = difference % prime * lift % prime;
+            if (factor == 0) continue;
+            step = modulus;
+            step.multiply(Integer((long long) factor));
+            residue.add(step);
+        }
+    }
+
+    modulus.multiply(Integer((long long) prime));
+}
+
+/// Rebuilds the rational rref entries from their residues.
+
+bool ModularReducer::reconstruct() {
+    int bits = (modulus.bitLength() - 2) / 2;
+    if (bits < 1) return false;
+
+    Integer scaled;
+    Integer quotient;
+    Integer num;
+    Integer den;
+    denominator = 1;
+
+    for (int i = 0; i < rank; i++) {
+        for (int j = 0; j < cols; j++) {
+            if (pivotal[j]) {
+                values[i * cols + j] = Rational(pivots[i] == j ? 1 : 0);
+                continue;
+            }
+
+            const Integer& residue = residues[i * cols + j];
+            if (denominator.isOne()) {
+                scaled = residue;
+            } else {
+                quotient = residue;
+                quotient.multiply(denominator);
+                quotient.divide(modulus, &scaled);
+            }
+
+            if (!rebuild(scaled, modulus, bits, num, den)) return false;
+            if (!den.isOne()) {
+                denominator.multiply(den);
+                if (denominator.bitLength() > bits) return false;
+            }
+            values[i * cols + j] = Rational(num, denominator);
+        }
+    }
+
+    return true;
+}
+
+/// Checks the rebuilt rref exactly against the original matrix. The
+/// columns are checked by the members of the team in turn. When the
+/// pivot columns, an rref column and the denominator all fit in 31 bits
+/// and their dot products cannot overflow, the check of that column is
+/// done in machine words.
+
+bool ModularReducer::verify() const {
+    int* narrow = NULL;
+    long long largest = 0;
+    bool fits = denominator.bitLength() < 32;
+    for (int k = 0; k < rows && fits; k++) {
+        for (int i = 0; i < rank && fits; i++) {
+            fits = cells[k * cols + pivots[i]].bitLength() < 32;
+        }
+    }
+    if (fits) {
+        narrow = (int*) malloc(((size_t) rows * rank + 1) * sizeof(int));
+        for (int k = 0; k < rows; k++) {
+            for (int i = 0; i < rank; i++) {
+                long long cell = cells[k * cols + pivots[i]].toLong();
+                narrow[k * rank + i] = (int) cell;
+                if (llabs(cell) > largest) largest = llabs(cell);
+            }
+        }
+    }
+
+    std::atomic<int> nextColumn(0);
+    std::atomic<bool> correct(true);
+    auto body = [&](int /*id*/) {
+        Integer* scaled = new Integer[rank > 0 ? rank : 1];
+        long long* words = (long long*) malloc((rank + 1) * sizeof(long long));
+        Integer sum;
+        Integer product;
+        Integer expected;
+
+        for (int j = nextColumn.fetch_add(1); j < cols && correct.load(std::memory_order_relaxed);
+                j = nextColumn.fetch_add(1)) {
+            if (pivotal[j]) continue;
+
+            bool quick = narrow != NULL;
+            long long peak = 0;
+            for (int i = 0; i < rank; i++) {
+                const Rational& value = values[i * cols + j];
+                scaled[i] = denominator;
+                scaled[i].divide(value.getDen());
+                scaled[i].multiply(value.getNum());
+                if (quick && scaled[i].bitLength() < 32) {
+                    words[i] = scaled[i].toLong();
+                    if (llabs(words[i]) > peak) peak = llabs(words[i]);
+                } else {
+                    quick = false;
+                }
+            }
+            quick = quick && (unsigned __int128) largest * peak * rank < ((unsigned __int128) 1 << 63);
+
+            for (int k = 0; k < rows; k++) {
+                const Integer& cell = cells[k * cols + j];
+                if (quick && cell.bitLength() < 32) {
+                    const int* row = &narrow[k * rank];
+                    long long total = 0;
+                    for (int i = 0; i < rank; i++) {
+                        total += row[i] * words[i];
+                    }
+                    if (total == cell.toLong() * denominator.toLong()) continue;
+                    correct.store(false);
+                    break;
+                }
+
+                sum = 0;
+                for (int i = 0; i < rank; i++) {
+                    const Integer& pivotCell = cells[k * cols + pivots[i]];
+                    if (pivotCell.isZero() || scaled[i].isZero()) continue;
+                    product = pivotCell;
+                    product.multiply(scaled[i]);
+                    sum.add(product);
+                }
+                expected = cell;
+                expected.multiply(denominator);
+                if (sum.compare(expected) == 0) continue;
+                correct.store(false);
+                break;
+            }
+        }
+
+        free(words);
+        delete[] scaled;
+    };
+
+    if (team) {
+        team->run(body);
+    } else {
+        body(0);
+    }
+    free(narrow);
+    return correct.load();
+}
+
+/// Computes the rref of the matrix.
+
+bool ModularReducer::reduce() {
+    long long size = (long long) rows * cols;
+    if (size >= BLOCKED_CELLS) {
+        int threads = getThreadCount();
+        if (threads > size / CELLS_PER_THREAD) threads = (int) (size / CELLS_PER_THREAD);
+        team = new Team(threads);
+        tracker = (unsigned int*) malloc((size_t) rows * PANEL_WIDTH * sizeof(unsigned int));
+        copies = (unsigned int*) malloc((size_t) PANEL_WIDTH * cols * sizeof(unsigned int));
+    }
+
+    bool found = false;
+    for (int k = 0; k < PRIME_COUNT && !found; k++) {
+        unsigned int prime = primeAt(k);
+        int count = reducePrime(prime);
+
+        int order = comparePivots(count);
+        if (order < 0) continue;
+        if (order > 0) adoptPivots(count);
+
+        combine(prime);
+        found = reconstruct() && verify();
+    }
+
+    delete team;
+    free(tracker);
+    free(copies);
+    team = NULL;
+    tracker = NULL;
+    copies = NULL;
+    return found;
+}
+
+/// Returns the rank of the matrix.
+
+int ModularReducer::getRank() const {
+    return rank;
+}
+
+/// Returns an entry of the rref.
+
+Rational ModularReducer::getValue(int row, int col) const {
+    if (row >= rank) return Rational(0);
+    return values[row * cols + col];
+}
+
+std::atomic<int> ModularReducer::threadCount(0);
+
+/// Sets the number of threads large matrices are reduced with.
+
+void ModularReducer::setThreadCount(int threads) {
+    threadCount.store(threads > 0 ? threads : 0);
+}
+
+/// Returns the number of threads large matrices are reduced with.
+
+int ModularReducer::getThreadCount() {
+    int threads = threadCount.load();
+    if (threads == 0) threads = std::thread::hardware_concurrency();
+    return threads > 0 ? threads : 1;
+}
+
+/// Constructor for the ModularReducer class.
+
+ModularReducer::ModularReducer(const Integer* cells, int rows, int cols) {
+    int count = rows * cols > 0 ? rows * cols : 1;
+    this->rows = rows;
+    this->cols = cols;
+    this->cells = cells;
+    rank = -1;
+    pivots = (int*) malloc((rows + 1) * sizeof(int));
+    candidate = (int*) malloc((rows + 1) * sizeof(int));
+    support = (int*) malloc((cols + 1) * sizeof(int));
+    pivotal = (bool*) malloc((cols + 1) * sizeof(bool));
+    work = (unsigned int*) malloc(count * sizeof(unsigned int));
+    residues = new Integer[count];
+    values = new Rational[count];
+    team = NULL;
+    tracker = NULL;
+    copies = NULL;
+}
+
+/// Destructor for the ModularReducer class.
+
+ModularReducer::~ModularReducer() {
+    free(pivots);
+    free(candidate);
+    free(support);
+    free(pivotal);
+    free(work);
+    delete[] residues;
+    delete[] values;
+}
+
+#endif
@@ -0,0 +1,167 @@
+///
+/// file: modular.hpp
+/// Header file for the ModularReducer class
+///
+/// @author Dominick Banasik
+
+#ifndef _MODULAR_H_
+#define _MODULAR_H_
+
+#include <atomic>
+
+#include "rational.hpp"
+#include "team.hpp"
+
+#define PANEL_WIDTH 64
+#define TILE_ROWS 64
+#define TILE_COLS 512
+#define BLOCKED_CELLS (1 << 18)
+#define CELLS_PER_THREAD (1 << 16)
+
+/// The ModularReducer class computes the rref of an integer matrix without
+/// coefficient growth. The matrix is row reduced modulo a series of primes
+/// below 2^31 with word arithmetic, the residues of each rref entry are
+/// combined by Chinese remaindering, and the rational entries are rebuilt
+/// by rational reconstruction. As soon as the rebuilt rref verifies
+/// exactly against the original matrix no more primes are used, so the
+/// number of primes follows the size of the answer rather than a bound.
+///
+/// Matrices of at least BLOCKED_CELLS cells, such as those of reaction
+/// networks with thousands of species, are reduced a panel of columns at
+/// a time on a team of threads, with the rest of the matrix updated once
+/// per panel in cache-sized tiles instead of once per pivot.
+
+class ModularReducer {
+    private:
+        int rows;
+        int cols;
+        const Integer* cells;
+        int rank;
+        int* pivots;
+        int* candidate;
+        int* support;
+        bool* pivotal;
+        unsigned int* work;
+        Integer* residues;
+        Integer modulus;
+        Integer denominator;
+        Rational* values;
+        Team* team;
+        unsigned int* tracker;
+        unsigned int* copies;
+
+        static std::atomic<int> threadCount;
+
+        /// Row reduces the matrix modulo a prime into the work buffer.
+        ///
+        /// @param prime the prime to reduce modulo
+        /// @return the rank of the matrix modulo the prime, with the pivot
+        ///         columns stored in candidate
+
+        int reducePrime(unsigned int prime);
+
+        /// Row reduces the work buffer modulo a prime a panel of columns
+        /// at a time. Within a panel the pivot rows are eliminated from
+        /// the panel's columns only, and every row operation is also
+        /// applied to a tracker that starts as the identity on the pivot
+        /// rows, so the tracker ends up holding the combination of pivot
+        /// rows each row needs. The columns past the panel are then
+        /// updated from the tracker in tiles small enough that the pivot
+        /// rows they read stay in cache.
+        ///
+        /// @param prime the prime to reduce modulo
+        /// @return the rank of the matrix modulo the prime, with the pivot
+        ///         columns stored in candidate
+
+        int reduceBlocked(unsigned int prime);
+
+        /// Checks whether the pivots just found are better than the best
+        /// so far: more of them, or the same number earlier in the matrix.
+        /// The true pivots are the best any prime can give.
+        ///
+        /// @param count the number of pivots just found
+        /// @return a negative number, zero or a positive number if the new
+        ///         pivots are worse, the same or better
+
+        int comparePivots(int count) const;
+
+        /// Makes the pivots just found the best so far, discarding the
+        /// residues combined for the old ones.
+        ///
+        /// @param count the number of pivots just found
+
+        void adoptPivots(int count);
+
+        /// Combines the rref modulo a prime with the residues so far.
+        ///
+        /// @param prime the prime the work buffer was reduced modulo
+
+        void combine(unsigned int prime);
+
+        /// Rebuilds the rational rref entries from their residues. The
+        /// entries share a denominator, so each one is rebuilt after
+        /// scaling by the denominator found so far.
+        ///
+        /// @return whether or not every entry could be rebuilt
+
+        bool reconstruct();
+
+        /// Checks the rebuilt rref exactly against the original matrix:
+        /// every column must be the combination of the pivot columns given
+        /// by its column of the rref.
+        ///
+        /// @return whether or not the rref is correct
+
+        bool verify() const;
+
+    public:
+        /// Constructor for the ModularReducer class.
+        ///
+        /// @param cells the cells of the matrix, one row after another
+        /// @param rows the number of rows
+        /// @param cols the number of columns
+
+        ModularReducer(const Integer* cells, int rows, int cols);
+
+        /// Destructor for the ModularReducer class.
+
+        ~ModularReducer();
+
+        ModularReducer(const ModularReducer& copy) = delete;
+        ModularReducer& operator=(const ModularReducer& copy) = delete;
+
+        /// Computes the rref of the matrix.
+        ///
+        /// @return whether or not the rref was found before the primes
+        ///         ran out
+
+        bool reduce();
+
+        /// Returns the rank of the matrix.
+        ///
+        /// @return the rank
+
+        int getRank() const;
+
+        /// Returns an entry of the rref.
+        ///
+        /// @param row the row of the entry
+        /// @param col the column of the entry
+        /// @return the entry
+
+        Rational getValue(int row, int col) const;
+
+        /// Sets the number of threads large matrices are reduced with.
+        ///
+        /// @param threads the number of threads, or 0 for one per core
+
+        static void setThreadCount(int threads);
+
+        /// Returns the number of threads large matrices are reduced with.
+        ///
+        /// @return the number of threads
+
+        static int getThreadCount();
+};
+
+#endif
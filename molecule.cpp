@@ -7,6 +7,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <ctype.h>
 
 #include "molecule.hpp"
 
@@ -15,78 +16,113 @@
 
 /// Adds atoms to the molecule's atom count.
 
-void Molecule::addAtoms(char* current, int multiplier) {
-    for (int i = 0; i < size; i++) {
-        if (!strcmp(current, atoms[i])) {
-            counts[i] += multiplier;
-            return;
-        }
+void Molecule::addAtoms(int element, int multiplier) {
+    int total;
+    if (__builtin_add_overflow(composition.getCountOf(element), multiplier, &total)) {
+        valid = false;
+        return;
     }
-    
-    char* atom = (char*) malloc(3 * sizeof(char));
-    atoms = (char**) realloc(atoms, (size + 1) * sizeof(char*));
-    counts = (int*) realloc(counts, (size + 1) * sizeof(int));
-    strcpy(atom, current);
-    atoms[size] = atom;
-    counts[size++] = multiplier;
+    composition.add(element, multiplier);
 }
 
 /// Parses a string representation of the molecule
 /// and determines the atoms that make it up.
 
-void Molecule::parseAtoms(char* string) {
+void Molecule::parseAtoms(std::string_view string) {
+    int stack[NESTING_DEPTH];
+    int* multipliers = stack;
+    int depth = NESTING_DEPTH;
     int level = 0;
-    char first;
-    char* current = (char*) malloc(3 * sizeof(char));
-    current[2] = 0;
-    while (first = *string++) {
-        if ('A' <= first && 'Z' >= first) {
-            current[0] = first;
-            char second = *string;
-            if ('a' <= second && 'z' >= second) {
-                current[1] = second;
-                string++;
+    int number = 0;
+    size_t index = string.size();
+
+    multipliers[0] = coefficient;
+    while (index > 0) {
+        char next = string[--index];
+        if ('0' <= next && '9' >= next) {
+            int place = 1;
+            bool placeOverflow = false;
+            number = 0;
+            while (true) {
+                int digit = next - '0';
+                int value;
+                if (digit != 0 && (placeOverflow || __builtin_mul_overflow(digit, place, &value)
+                        || __builtin_add_overflow(number, value, &number))) {
+                    valid = false;
+                }
+                if (index == 0 || string[index - 1] < '0' || string[index - 1] > '9') break;
+                next = string[--index];
+                placeOverflow = placeOverflow || __builtin_mul_overflow(place, 10, &place);
+            }
+        } else if (isspace((unsigned char) next)) {
+            continue;
+        } else if (isalpha((unsigned char) next)) {
+            char first = next;
+            char second = 0;
+            if ('a' <= next) {
+                if (index == 0 || string[index - 1] < 'A' || string[index - 1] > 'Z') {
+                    number = 0;
+                    continue;
+                }
+                second = next;
+                first = string[--index];
+            }
+            int element = PERIODIC_TABLE.lookup(first, second);
+            int count;
+            if (__builtin_mul_overflow(multipliers[level], number ? number : 1, &count)) {
+                valid = false;
+            } else if (element) {
+                addAtoms(element, count);
             } else {
-                current[1] = 0;
+                valid = false;
             }
-            int count = strtol(string, &string, 10);
-            if (!count) count = 1;
-            addAtoms(current, multipliers[level] * count);
-        } else if (first == '(') {
-            char* copy = string;
-            char next;
-            int count = 1;
-            while (next = *copy++) {
-                if (next == '(') count++; else if (next == ')') count--;
-                if (!count) break;
+            number = 0;
+        } else if (next == ')') {
+            if (level + 1 == depth) {
+                depth *= 2;
+                if (multipliers == stack) {
+                    multipliers = (int*) malloc(depth * sizeof(int));
+                    memcpy(multipliers, stack, sizeof(stack));
+                } else {
+                    multipliers = (int*) realloc(multipliers, depth * sizeof(int));
+                }
             }
-            int multiplier = strtol(copy, NULL, 10);
-            if (!multiplier) multiplier = 1;
-            multipliers = (int*) realloc(multipliers, (level + 2) * sizeof(int));
-            multipliers[++level] = multipliers[level] * multiplier;
-        } else if (first == ')') {
-            level--;
+            if (__builtin_mul_overflow(multipliers[level], number ? number : 1, &multipliers[level + 1])) {
+                valid = false;
+            }
+            level++;
+            number = 0;
+        } else {
+            if (next == '(' && level > 0) level--;
+            number = 0;
         }
     }
-    free(current);
+
+    if (multipliers != stack) free(multipliers);
 }
 
 /// Set the coefficient of the entire molecule if
 /// one is provided.
 
-void Molecule::setCoefficient(char* string) {
-    char* copy = string;
-    char next;
+void Molecule::setCoefficient(std::string_view string) {
     fixed = true;
-    
-    while (next = *copy++) {
+    coefficient = 1;
+
+    for (size_t i = 0; i < string.size(); i++) {
+        char next = string[i];
         if (next == '_') {
             fixed = false;
         } else if ('A' <= next && 'Z' >= next) {
-            coefficient = 1;
             return;
         } else if ('0' <= next && '9' >= next) {
-            coefficient = strtol(copy - 1, &string, 10);       
+            coefficient = 0;
+            while (i < string.size() && '0' <= string[i] && '9' >= string[i]) {
+                if (__builtin_mul_overflow(coefficient, 10, &coefficient)
+                        || __builtin_add_overflow(coefficient, string[i] - '0', &coefficient)) {
+                    valid = false;
+                }
+                i++;
+            }
             return;
         }
     }
@@ -94,13 +130,8 @@ void Molecule::setCoefficient(char* string) {
 
 /// Returns the quantity of a particular atom present in the molecule.
 
-int Molecule::getCountOfAtom(char* atom) {
-    for (int i = 0; i < size; i++) {
-        if (!strcmp(atom, atoms[i])) {
-            return counts[i];
-        }
-    }
-    return 0;
+int Molecule::getCountOfAtom(int atom) {
+    return getComposition().getCountOf(atom);
 }
 
 /// Checks whether a coefficient was fixed or not.
@@ -109,38 +140,73 @@ bool Molecule::getFixed() {
     return fixed;
 }
 
-/// Returns the number of different atoms in the molecule.
+/// Returns the coefficient given in front of the molecule.
+
+int Molecule::getCoefficient() {
+    return coefficient;
+}
+
+/// Checks whether every symbol in the molecule is an element.
 
-int Molecule::getSize() {
-    return size;
+bool Molecule::getValid() {
+    return valid;
 }
 
-/// Returns the array of atoms that make up the molecule.
+/// Returns the atoms that make up the molecule and the quantity of each.
 
-char** Molecule::getAtoms() {
-    return atoms;
+const Composition& Molecule::getComposition() {
+    return shared ? *shared : composition;
+}
+
+/// Returns the string the molecule was parsed from.
+
+std::string_view Molecule::getFormula() {
+    return formula;
+}
+
+/// Returns the string the molecule was parsed from without its
+/// coefficient or the '_' that marks it free.
+
+std::string_view Molecule::getBareFormula() {
+    size_t start = 0;
+    while (start < formula.size() && (formula[start] == '_' || isdigit((unsigned char) formula[start])
+            || isspace((unsigned char) formula[start]))) {
+        start++;
+    }
+    return formula.substr(start);
 }
 
 /// Prints a string representing the molecule.
 
 void Molecule::printMolecule() {
-    printf("%s", formula);
+    printf("%.*s", (int) formula.size(), formula.data());
+}
+
+/// Frees the memory the molecule's own composition spilled to the heap.
+
+void Molecule::release() {
+    composition.release();
 }
 
 /// Constructor for the Molecule class.
 
-Molecule::Molecule(char* string) {
-    formula = (char*) malloc(64 * sizeof(char));
-    strcpy(formula, string);
-    size = 0;
-    atoms = (char**) malloc(0);
-    counts = (int*) malloc(0);
+Molecule::Molecule(std::string_view string, FormulaCache* formulas) {
+    formula = string;
+    shared = NULL;
+    valid = true;
     setCoefficient(string);
 
-    multipliers = (int*) malloc(sizeof(int));
-    multipliers[0] = coefficient;
-    
+    if (formulas) {
+        shared = formulas->find(string, &valid);
+        if (shared) return;
+    }
+
     parseAtoms(string);
+
+    if (formulas) {
+        shared = formulas->insert(string, composition, valid);
+        if (shared) composition = Composition();
+    }
 }
 
 #endif
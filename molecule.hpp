@@ -7,39 +7,53 @@
 #ifndef _MOLECULE_H_
 #define _MOLECULE_H_
 
+#include <string_view>
+
+#include "element.hpp"
+#include "composition.hpp"
+#include "cache.hpp"
+
+#define NESTING_DEPTH 16
+
 /// The Molecule class represents a molecule with
 /// individual atoms.
 
 class Molecule {
     private:
-        char** atoms;
-        char* formula;
-        int* counts;
-        int* multipliers;
+        Composition composition;
+        const Composition* shared;
+        std::string_view formula;
         int coefficient;
-        int size;
         bool fixed;
+        bool valid;
         
         /// Sets the coefficient of the entire molecule if
-        /// one is provided.
+        /// one is provided. A coefficient that does not fit in an int
+        /// makes the molecule invalid.
         ///
         /// @param string the input string
 
-        void setCoefficient(char* string);
+        void setCoefficient(std::string_view string);
 
         /// Parses a string representation of the molecule
-        /// and determines that atoms that make it up.
+        /// and determines that atoms that make it up. The string is read
+        /// once, from right to left, so every count is seen before the
+        /// element or group it belongs to and each ')' can push its
+        /// multiplier straight away. The multipliers are kept on a stack
+        /// that lives inline up to NESTING_DEPTH levels. A count that does
+        /// not fit in an int makes the molecule invalid.
         ///
         /// #param string the string representing the molecule
 
-        void parseAtoms(char* string);
+        void parseAtoms(std::string_view string);
 
-        /// Adds atoms to the molecule's atom count.
+        /// Adds atoms to the molecule's atom count, or makes the molecule
+        /// invalid if the count would not fit in an int.
         ///
-        /// @param string the string representing the atom
+        /// @param element the ID of the atom's element
         /// @param multiplier the number of atoms to add
 
-        void addAtoms(char* string, int multiplier);
+        void addAtoms(int element, int multiplier);
 
     public:
         /// Checks whether a coefficient was fixed or not.
@@ -48,31 +62,61 @@ class Molecule {
 
         bool getFixed();
 
-        /// Constructor for the Molecule class.
+        /// Returns the coefficient given in front of the molecule, or 1
+        /// if none was given.
+        ///
+        /// @return the coefficient of the molecule
+
+        int getCoefficient();
+
+        /// Checks whether every symbol in the molecule is an element.
+        ///
+        /// @return whether or not the molecule is valid
+
+        bool getValid();
+
+        /// Constructor for the Molecule class. The molecule keeps a view
+        /// of the string as its formula, so the string must outlive it.
+        /// With a formula cache, a formula seen before is not parsed again
+        /// and the molecule points at the cached composition.
         ///
         /// @param string the string to parse
+        /// @param formulas the cache of parsed formulas, or NULL
+
+        Molecule(std::string_view string, FormulaCache* formulas = NULL);
+
+        /// Frees the memory the molecule's own composition spilled to the
+        /// heap. A cached composition is left alone.
 
-        Molecule(char* string);
+        void release();
         
-        /// Returns the array of atoms that make up the molecule.
+        /// Returns the atoms that make up the molecule and the quantity
+        /// of each.
         ///
-        /// @return the array of atoms
+        /// @return the composition of the molecule
 
-        char** getAtoms();
+        const Composition& getComposition();
 
         /// Returns the quantity of a particular atom present in
         /// the molecule.
         ///
-        /// @param atom the atom to get the quantity of
+        /// @param atom the element ID of the atom to get the quantity of
         /// @return the quantity of that atom
 
-        int getCountOfAtom(char* atom);
+        int getCountOfAtom(int atom);
+
+        /// Returns the string the molecule was parsed from.
+        ///
+        /// @return the formula of the molecule
+
+        std::string_view getFormula();
 
-        /// Returns the number of different atoms in the molecule.
+        /// Returns the string the molecule was parsed from without its
+        /// coefficient or the '_' that marks it free.
         ///
-        /// @return the size of the atom list
+        /// @return the formula of one molecule
 
-        int getSize();
+        std::string_view getBareFormula();
 
         /// Prints a string representing the molecule.
 
@@ -0,0 +1,480 @@
+///
+/// file: network.cpp
+/// Implementation for the Network class
+///
+/// @author Dominick Banasik
+
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+
+#include <algorithm>
+
+#include "network.hpp"
+
+#ifndef _NETWORK_IMPL_
+#define _NETWORK_IMPL_
+
+/// Constructor for an empty Network.
+
+Network::Network(FormulaCache* formulas, Engine engine) : equation(formulas) {
+    this->engine = engine;
+    for (int i = 0; i <= ELEMENT_COUNT; i++) {
+        atomRows[i] = -1;
+    }
+    compositionStarts.push_back(0);
+    reactionStarts.push_back(0);
+    rank = 0;
+    analyzed = false;
+}
+
+/// Returns the index of a species, adding it if it is new.
+
+int Network::addSpecies(std::string_view formula) {
+    auto found = speciesIndex.find(formula);
+    if (found != speciesIndex.end()) return found->second;
+
+    char* copy = names.allocate<char>(formula.size() + 1);
+    memcpy(copy, formula.data(), formula.size());
+    copy[formula.size()] = 0;
+    std::string_view name(copy, formula.size());
+    int index = (int) species.size();
+    speciesIndex.emplace(name, index);
+    species.push_back(name);
+
+    Molecule unit(name, equation.formulas);
+    const Composition& composition = unit.getComposition();
+    for (int j = 0; j < composition.getSize(); j++) {
+        int element = composition.getElement(j);
+        if (atomRows[element] == -1) {
+            atomRows[element] = (int) atoms.size();
+            atoms.push_back(element);
+        }
+        compositionAtoms.push_back(atomRows[element]);
+        compositionCounts.push_back(composition.getCount(j));
+    }
+    compositionStarts.push_back((int) compositionAtoms.size());
+    unit.release();
+    return index;
+}
+
+/// Adds a reaction, written as an equation.
+
+Status Network::addReaction(std::string_view string, int line) {
+    equation.assign(string);
+    if (!equation.valid) return INVALID;
+
+    // Free coefficients are chosen by balancing, and every coefficient is
+    // then scaled by the least common multiple of their denominators.
+    int total = equation.reactantCount + equation.productCount;
+    bool free = equation.freeReactantCount + equation.freeProductCount > 0;
+    Solution solution = free ? equation.balance(engine) : Solution(0, &equation.arena);
+    Integer scale(1);
+    if (free) {
+        if (solution.getStatus() != SOLVED) return solution.getStatus() == OVERFLOWED ? OVERFLOWED : UNSOLVED;
+        for (int i = 0, index = 0; i < total; i++) {
+            if (equation.getMolecule(i).getFixed()) continue;
+            Integer den = solution.getValue(index++).getDen();
+            Integer gcd = Integer::gcd(scale, den);
+            scale.multiply(den);
+            scale.divide(gcd);
+        }
+    }
+
+    size_t start = reactionSpecies.size();
+    for (int i = 0, index = 0; i < total; i++) {
+        Molecule& molecule = equation.getMolecule(i);
+        Integer count(molecule.getFixed() ? molecule.getCoefficient() : 0);
+        if (molecule.getFixed()) {
+            count.multiply(scale);
+        } else {
+            Rational value = solution.getValue(index++);
+            count = value.getNum();
+            count.multiply(scale);
+            count.divide(value.getDen());
+        }
+        if (!count.isSmall()) {
+            reactionSpecies.resize(start);
+            reactionCounts.resize(start);
+            return OVERFLOWED;
+        }
+
+        std::string_view formula = molecule.getBareFormula();
+        while (!formula.empty() && isspace((unsigned char) formula.back())) {
+            formula.remove_suffix(1);
+        }
+        reactionSpecies.push_back(addSpecies(formula));
+        reactionCounts.push_back(i < equation.reactantCount ? -count.toLong() : count.toLong());
+    }
+
+    // A species on both sides appears once, with its net count.
+    size_t end = reactionSpecies.size();
+    std::vector<std::pair<int, long long> > terms;
+    for (size_t i = start; i < end; i++) {
+        terms.push_back(std::make_pair(reactionSpecies[i], reactionCounts[i]));
+    }
+    std::sort(terms.begin(), terms.end());
+    reactionSpecies.resize(start);
+    reactionCounts.resize(start);
+    for (size_t i = 0; i < terms.size(); i++) {
+        if (reactionSpecies.size() > start && reactionSpecies.back() == terms[i].first) {
+            reactionCounts.back() += terms[i].second;
+        } else {
+            reactionSpecies.push_back(terms[i].first);
+            reactionCounts.push_back(terms[i].second);
+        }
+        if (reactionCounts.back() == 0) {
+            reactionSpecies.pop_back();
+            reactionCounts.pop_back();
+        }
+    }
+    reactionStarts.push_back((int) reactionSpecies.size());
+    reactionLines.push_back(line);
+    analyzed = false;
+    return SOLVED;
+}
+
+/// Returns the number of species in the network.
+
+int Network::getSpeciesCount() {
+    return (int) species.size();
+}
+
+/// Returns the number of reactions in the network.
+
+int Network::getReactionCount() {
+    return (int) reactionLines.size();
+}
+
+/// Returns the number of elements in the network.
+
+int Network::getElementCount() {
+    return (int) atoms.size();
+}
+
+/// Returns the formula of a species.
+
+std::string_view Network::getSpecies(int index) {
+    return species[index];
+}
+
+/// Checks whether a reaction conserves every element. The atoms of its
+/// species are summed into one count per element, which is cleared again
+/// on the way out.
+
+bool Network::getBalanced(int reaction) {
+    residual.resize(atoms.size());
+    bool balanced = true;
+    for (int pass = 0; pass < 2; pass++) {
+        for (int i = reactionStarts[reaction]; i < reactionStarts[reaction + 1]; i++) {
+            int s = reactionSpecies[i];
+            for (int j = compositionStarts[s]; j < compositionStarts[s + 1]; j++) {
+                if (pass == 0) {
+                    residual[compositionAtoms[j]] += reactionCounts[i] * compositionCounts[j];
+                } else {
+                    balanced = balanced && residual[compositionAtoms[j]] == 0;
+                }
+            }
+        }
+    }
+    for (int i = reactionStarts[reaction]; i < reactionStarts[reaction + 1]; i++) {
+        int s = reactionSpecies[i];
+        for (int j = compositionStarts[s]; j < compositionStarts[s + 1]; j++) {
+            residual[compositionAtoms[j]] = 0;
+        }
+    }
+    return balanced;
+}
+
+/// Adds a multiple of one row to another, merging the two lists of
+/// entries.
+
+void Network::addRow(Row& target, const Row& source, const Rational& scalar, Row& merged) {
+    size_t a = 0;
+    size_t b = 0;
+
+    merged.clear();
+    while (a < target.size() || b < source.size()) {
+        if (b == source.size() || (a < target.size() && target[a].col < source[b].col)) {
+            merged.push_back(static_cast<SparseEntry<Rational>&&>(target[a++]));
+            continue;
+        }
+
+        SparseEntry<Rational> entry;
+        entry.col = source[b].col;
+        entry.value = source[b++].value;
+        entry.value.multiply(scalar);
+        if (a < target.size() && target[a].col == entry.col) {
+            entry.value.add(target[a++].value);
+        }
+        if (!entry.value.equals(0)) merged.push_back(static_cast<SparseEntry<Rational>&&>(entry));
+    }
+
+    target.swap(merged);
+}
+
+/// Finds a basis of the conservation laws.
+///
+/// Each reaction is a row of the transpose of N, and the rows are kept
+/// in lists by the column they lead in, so each column only visits the
+/// rows that lead in it. Of those the one with the fewest entries becomes
+/// the pivot row, and the others move on to the list of their next
+/// column, or drop out if nothing is left of them. Most reactions of a
+/// large network are combinations of others and drop out this way.
+/// Back substitution from the last pivot to the first then leaves every
+/// pivot row with its pivot and cells in columns without a pivot only.
+///
+/// The species with the most atoms get the first columns, so the species
+/// left without a pivot are the simplest ones and the rows of the rest
+/// stay short. Each law then weighs one of those species by 1 and every
+/// pivot species by the negated cell of its row in that column, which
+/// for a balanced network counts atoms in units of the simple species.
+
+void Network::analyze() {
+    if (analyzed) return;
+    int reactions = getReactionCount();
+    int cols = getSpeciesCount();
+
+    std::vector<int> speciesOf(cols);
+    std::vector<int> columnOf(cols);
+    std::vector<long long> sizes(cols, 0);
+    for (int s = 0; s < cols; s++) {
+        speciesOf[s] = s;
+        for (int j = compositionStarts[s]; j < compositionStarts[s + 1]; j++) {
+            sizes[s] += compositionCounts[j];
+        }
+    }
+    std::stable_sort(speciesOf.begin(), speciesOf.end(), [&sizes](int a, int b) {
+        return sizes[a] > sizes[b];
+    });
+    for (int c = 0; c < cols; c++) {
+        columnOf[speciesOf[c]] = c;
+    }
+
+    std::vector<Row> rows(reactions);
+    std::vector<std::vector<int> > leading(cols);
+    for (int r = 0; r < reactions; r++) {
+        for (int i = reactionStarts[r]; i < reactionStarts[r + 1]; i++) {
+            SparseEntry<Rational> entry;
+            entry.col = columnOf[reactionSpecies[i]];
+            entry.value = Rational(reactionCounts[i]);
+            rows[r].push_back(entry);
+        }
+        std::sort(rows[r].begin(), rows[r].end(), [](const SparseEntry<Rational>& a,
+                const SparseEntry<Rational>& b) {
+            return a.col < b.col;
+        });
+        if (!rows[r].empty()) leading[rows[r][0].col].push_back(r);
+    }
+
+    std::vector<int> pivotRows(cols, -1);
+    Row merged;
+    rank = 0;
+    for (int c = 0; c < cols; c++) {
+        std::vector<int>& candidates = leading[c];
+        if (candidates.empty()) continue;
+        int best = candidates[0];
+        for (size_t i = 1; i < candidates.size(); i++) {
+            if (rows[candidates[i]].size() < rows[best].size()) best = candidates[i];
+        }
+
+        Row& pivot = rows[best];
+        if (!pivot[0].value.equals(1)) {
+            Rational reciprocal = pivot[0].value.getReciprocal();
+            for (size_t j = 0; j < pivot.size(); j++) {
+                pivot[j].value.multiply(reciprocal);
+            }
+        }
+        for (size_t i = 0; i < candidates.size(); i++) {
+            int r = candidates[i];
+            if (r == best) continue;
+            Rational scalar(rows[r][0].value);
+            scalar.multiply(-1);
+            addRow(rows[r], pivot, scalar, merged);
+            if (rows[r].empty()) {
+                Row().swap(rows[r]);
+            } else {
+                leading[rows[r][0].col].push_back(r);
+            }
+        }
+        std::vector<int>().swap(candidates);
+        pivotRows[c] = best;
+        rank++;
+    }
+
+    std::vector<Rational> sums(cols);
+    std::vector<int> touched;
+    for (int c = cols - 1; c >= 0; c--) {
+        if (pivotRows[c] == -1) continue;
+        Row& row = rows[pivotRows[c]];
+        touched.clear();
+        for (size_t j = 1; j < row.size(); j++) {
+            int col = row[j].col;
+            if (pivotRows[col] == -1) {
+                sums[col].add(row[j].value);
+                touched.push_back(col);
+                continue;
+            }
+            const Row& other = rows[pivotRows[col]];
+            for (size_t k = 1; k < other.size(); k++) {
+                Rational value(other[k].value);
+                value.multiply(row[j].value);
+                value.multiply(-1);
+                sums[other[k].col].add(value);
+                touched.push_back(other[k].col);
+            }
+        }
+        std::sort(touched.begin(), touched.end());
+        touched.erase(std::unique(touched.begin(), touched.end()), touched.end());
+        row.resize(1);
+        for (size_t j = 0; j < touched.size(); j++) {
+            int col = touched[j];
+            if (!sums[col].equals(0)) {
+                SparseEntry<Rational> entry;
+                entry.col = col;
+                entry.value = sums[col];
+                row.push_back(entry);
+            }
+            sums[col] = Rational(0);
+        }
+    }
+
+    // Each column without a pivot starts a law, and every pivot row adds
+    // its species to the laws of the columns it has cells in.
+    std::vector<int> lawOf(cols, -1);
+    std::vector<std::vector<std::pair<int, Rational> > > laws;
+    for (int c = 0; c < cols; c++) {
+        if (pivotRows[c] != -1) continue;
+        lawOf[c] = (int) laws.size();
+        laws.emplace_back();
+        laws.back().push_back(std::make_pair(speciesOf[c], Rational(1)));
+    }
+    for (int c = 0; c < cols; c++) {
+        if (pivotRows[c] == -1) continue;
+        const Row& row = rows[pivotRows[c]];
+        for (size_t j = 1; j < row.size(); j++) {
+            Rational value(row[j].value);
+            value.multiply(-1);
+            laws[lawOf[row[j].col]].push_back(std::make_pair(speciesOf[c], value));
+        }
+    }
+
+    // The weights of each law are scaled to whole numbers with no common
+    // factor, and listed in the order their species were first seen.
+    lawStarts.assign(1, 0);
+    lawSpecies.clear();
+    lawCounts.clear();
+    for (size_t law = 0; law < laws.size(); law++) {
+        std::vector<std::pair<int, Rational> >& terms = laws[law];
+        std::sort(terms.begin(), terms.end(), [](const std::pair<int, Rational>& a,
+                const std::pair<int, Rational>& b) {
+            return a.first < b.first;
+        });
+        Integer scale(1);
+        for (size_t i = 0; i < terms.size(); i++) {
+            Integer den = terms[i].second.getDen();
+            Integer gcd = Integer::gcd(scale, den);
+            scale.multiply(den);
+            scale.divide(gcd);
+        }
+        size_t start = lawCounts.size();
+        Integer common(0);
+        for (size_t i = 0; i < terms.size(); i++) {
+            Integer count = terms[i].second.getNum();
+            count.multiply(scale);
+            count.divide(terms[i].second.getDen());
+            common = Integer::gcd(common, count);
+            lawSpecies.push_back(terms[i].first);
+            lawCounts.push_back(count);
+        }
+        for (size_t i = start; i < lawCounts.size(); i++) {
+            lawCounts[i].divide(common);
+        }
+        lawStarts.push_back((int) lawSpecies.size());
+    }
+    analyzed = true;
+}
+
+/// Returns the rank of the stoichiometric matrix.
+
+int Network::getRank() {
+    analyze();
+    return rank;
+}
+
+/// Returns the number of conservation laws in the basis.
+
+int Network::getLawCount() {
+    analyze();
+    return (int) lawStarts.size() - 1;
+}
+
+/// Appends a conservation law to a string as a sum of species.
+
+void Network::formatLaw(int law, std::string& output) {
+    analyze();
+    for (int i = lawStarts[law]; i < lawStarts[law + 1]; i++) {
+        Integer count = lawCounts[i];
+        if (i > lawStarts[law]) {
+            output += count.sign() < 0 ? " - " : " + ";
+        } else if (count.sign() < 0) {
+            output += '-';
+        }
+        if (count.sign() < 0) count.negate();
+        if (!count.isOne()) {
+            count.toString(output);
+            output += ' ';
+        }
+        output += species[lawSpecies[i]];
+    }
+}
+
+/// Appends the net atoms of each element a reaction makes to a string.
+
+void Network::formatImbalance(int reaction, std::string& output) {
+    residual.resize(atoms.size());
+    for (int i = reactionStarts[reaction]; i < reactionStarts[reaction + 1]; i++) {
+        int s = reactionSpecies[i];
+        for (int j = compositionStarts[s]; j < compositionStarts[s + 1]; j++) {
+            residual[compositionAtoms[j]] += reactionCounts[i] * compositionCounts[j];
+        }
+    }
+    bool first = true;
+    for (size_t a = 0; a < atoms.size(); a++) {
+        if (residual[a] == 0) continue;
+        if (!first) output += ", ";
+        first = false;
+        output += PeriodicTable::symbol(atoms[a]);
+        output += ' ';
+        if (residual[a] > 0) output += '+';
+        output += std::to_string(residual[a]);
+        residual[a] = 0;
+    }
+}
+
+/// Appends a report on the network to a string.
+
+void Network::formatReport(std::string& output) {
+    analyze();
+    int reactions = getReactionCount();
+    output += std::to_string(reactions) + " reactions, " + std::to_string(getSpeciesCount()) + " species, "
+            + std::to_string(getElementCount()) + " elements\n";
+
+    int unbalanced = 0;
+    for (int r = 0; r < reactions; r++) {
+        if (getBalanced(r)) continue;
+        unbalanced++;
+        output += "line " + std::to_string(reactionLines[r]) + " is unbalanced: ";
+        formatImbalance(r, output);
+        output += '\n';
+    }
+    output += std::to_string(unbalanced) + " unbalanced reactions\n";
+
+    output += "rank " + std::to_string(rank) + ", " + std::to_string(getLawCount()) + " conservation laws\n";
+    for (int law = 0; law < getLawCount(); law++) {
+        formatLaw(law, output);
+        output += '\n';
+    }
+}
+
+#endif
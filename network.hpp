@@ -0,0 +1,192 @@
+///
+/// file: network.hpp
+/// Header file for the Network class
+///
+/// @author Dominick Banasik
+
+#ifndef _NETWORK_H_
+#define _NETWORK_H_
+
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "element.hpp"
+#include "integer.hpp"
+#include "rational.hpp"
+#include "solution.hpp"
+#include "matrix.hpp"
+#include "sparse.hpp"
+#include "arena.hpp"
+#include "cache.hpp"
+#include "equation.hpp"
+
+/// The Network class is a reaction network: many reactions over one set
+/// of species, each reaction parsed as an equation whose molecules are
+/// looked up by formula, so a species is the same wherever it appears.
+/// The network keeps two sparse matrices, stored as compressed lists of
+/// their cells that are not zero: the atoms of each element in each
+/// species, and the stoichiometric matrix N, with the net number of each
+/// species each reaction makes, reactants negative.
+///
+/// A reaction is balanced when its column of N conserves every element.
+/// A conservation law is a weighting of the species that no reaction
+/// changes, a vector l with l N = 0. The laws form the null space of the
+/// transpose of N, which is read from its rref: one law per species
+/// whose column has no pivot. Every balanced network conserves its
+/// elements, so there are at least as many laws as elements every
+/// reaction balances, and more where groups of atoms always move
+/// together.
+
+class Network {
+    private:
+        typedef std::vector<SparseEntry<Rational> > Row;
+
+        Equation equation;
+        Engine engine;
+        Arena names;
+        std::unordered_map<std::string_view, int> speciesIndex;
+        std::vector<std::string_view> species;
+
+        std::vector<int> compositionStarts;
+        std::vector<int> compositionAtoms;
+        std::vector<int> compositionCounts;
+        int atomRows[ELEMENT_COUNT + 1];
+        std::vector<int> atoms;
+
+        std::vector<int> reactionStarts;
+        std::vector<int> reactionSpecies;
+        std::vector<long long> reactionCounts;
+        std::vector<int> reactionLines;
+        std::vector<long long> residual;
+
+        std::vector<int> lawStarts;
+        std::vector<int> lawSpecies;
+        std::vector<Integer> lawCounts;
+        int rank;
+        bool analyzed;
+
+        /// Returns the index of a species, adding it with its atoms if it
+        /// is new. Elements seen for the first time get a row, as in
+        /// Equation::generateAtoms.
+        ///
+        /// @param formula the formula of one molecule of the species
+        /// @return the index of the species
+
+        int addSpecies(std::string_view formula);
+
+        /// Adds a multiple of one row to another, merging the two lists of
+        /// entries.
+        ///
+        /// @param target the row to add to
+        /// @param source the row to add a multiple of
+        /// @param scalar the scalar to multiply the source row by
+        /// @param merged scratch space for the merged row
+
+        static void addRow(Row& target, const Row& source, const Rational& scalar, Row& merged);
+
+        /// Finds a basis of the conservation laws from the rref of the
+        /// transpose of N, unless the network has not changed since.
+
+        void analyze();
+
+    public:
+        /// Constructor for an empty Network.
+        ///
+        /// @param formulas the cache of parsed formulas to share, or NULL
+        /// @param engine the elimination to balance reactions that have
+        ///               free coefficients with
+
+        Network(FormulaCache* formulas = NULL, Engine engine = SPARSE);
+
+        Network(const Network& copy) = delete;
+        Network& operator=(const Network& copy) = delete;
+
+        /// Adds a reaction, written as an equation. Each molecule's
+        /// coefficient is the one written in front of it; if any molecule
+        /// is free, the reaction is balanced first and every coefficient
+        /// scaled to whole numbers.
+        ///
+        /// @param string the reaction
+        /// @param line the line of input the reaction came from
+        /// @return INVALID if an element is unknown, UNSOLVED or
+        ///         OVERFLOWED if the free coefficients could not be found,
+        ///         in which case the reaction is left out, and SOLVED
+        ///         otherwise
+
+        Status addReaction(std::string_view string, int line);
+
+        /// Returns the number of species in the network.
+        ///
+        /// @return the number of species
+
+        int getSpeciesCount();
+
+        /// Returns the number of reactions in the network.
+        ///
+        /// @return the number of reactions
+
+        int getReactionCount();
+
+        /// Returns the number of elements in the network.
+        ///
+        /// @return the number of elements
+
+        int getElementCount();
+
+        /// Returns the formula of a species.
+        ///
+        /// @param index the index of the species
+        /// @return the formula, as first written
+
+        std::string_view getSpecies(int index);
+
+        /// Checks whether a reaction conserves every element.
+        ///
+        /// @param reaction the index of the reaction
+        /// @return whether or not the reaction is balanced
+
+        bool getBalanced(int reaction);
+
+        /// Returns the rank of the stoichiometric matrix, the number of
+        /// independent reactions.
+        ///
+        /// @return the rank
+
+        int getRank();
+
+        /// Returns the number of conservation laws in the basis, which is
+        /// the number of species less the rank.
+        ///
+        /// @return the number of conservation laws
+
+        int getLawCount();
+
+        /// Appends a conservation law to a string as a sum of species,
+        /// each after its weight unless the weight is 1. The weights are
+        /// whole numbers with no common factor.
+        ///
+        /// @param law the index of the law
+        /// @param output the string to append to
+
+        void formatLaw(int law, std::string& output);
+
+        /// Appends the net atoms of each element a reaction makes to a
+        /// string, for the elements it does not conserve.
+        ///
+        /// @param reaction the index of the reaction
+        /// @param output the string to append to
+
+        void formatImbalance(int reaction, std::string& output);
+
+        /// Appends a report on the network to a string: its size, the
+        /// reactions that are not balanced and a basis of its
+        /// conservation laws.
+        ///
+        /// @param output the string to append to
+
+        void formatReport(std::string& output);
+};
+
+#endif
@@ -0,0 +1,222 @@
+///
+/// file: pool.cpp
+/// Implementation for the WorkDeque and BatchBalancer classes
+///
+/// @author Dominick Banasik
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "pool.hpp"
+#include "equation.hpp"
+#include "reader.hpp"
+
+#ifndef _POOL_IMPL_
+#define _POOL_IMPL_
+
+#define FREE 0
+#define QUEUED 1
+#define DONE 2
+
+/// Adds a job to the back of the deque.
+
+void WorkDeque::push(long job) {
+    std::lock_guard<std::mutex> guard(lock);
+    jobs.push_back(job);
+}
+
+/// Takes the oldest job from the deque.
+
+bool WorkDeque::pop(long* job) {
+    std::lock_guard<std::mutex> guard(lock);
+    if (jobs.empty()) return false;
+    *job = jobs.front();
+    jobs.pop_front();
+    return true;
+}
+
+/// Takes the newest job from the deque.
+
+bool WorkDeque::steal(long* job) {
+    std::lock_guard<std::mutex> guard(lock);
+    if (jobs.empty()) return false;
+    *job = jobs.back();
+    jobs.pop_back();
+    return true;
+}
+
+/// Balances a single equation and appends the result to a string.
+
+void BatchBalancer::balance(Equation& equation, std::string_view line, Engine engine, ResultCache* cache,
+        std::string& result) {
+    equation.assign(line);
+    Solution solution = equation.balance(engine, cache);
+    equation.formatSolution(solution, result);
+}
+
+/// Takes a job from a worker's own deque or steals one from another.
+
+bool BatchBalancer::findJob(int id, long* job) {
+    if (deques[id].pop(job)) return true;
+    for (int i = 1; i < threadCount; i++) {
+        if (deques[(id + i) % threadCount].steal(job)) return true;
+    }
+    return false;
+}
+
+/// Marks a slot as done and wakes the writer if it is waiting on it.
+
+void BatchBalancer::complete(long job) {
+    slots[job % window].state.store(DONE);
+    if (nextToWrite.load() == job) {
+        std::lock_guard<std::mutex> guard(stateLock);
+        slotDone.notify_one();
+    }
+}
+
+/// Runs one worker thread until the input is finished.
+
+void BatchBalancer::work(int id) {
+    Equation equation(formulas);
+    long job;
+
+    while (true) {
+        if (findJob(id, &job)) {
+            pending--;
+            Slot* slot = &slots[job % window];
+            balance(equation, slot->text, engine, cache, slot->result);
+            complete(job);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> guard(stateLock);
+        idle++;
+        workReady.wait(guard, [this] { return pending.load() > 0 || finished; });
+        idle--;
+        if (finished && pending.load() == 0) return;
+    }
+}
+
+/// Writes finished results to a stream in input order.
+
+void BatchBalancer::write(FILE* output) {
+    while (true) {
+        long next = nextToWrite.load();
+        Slot* slot = &slots[next % window];
+        {
+            std::unique_lock<std::mutex> guard(stateLock);
+            slotDone.wait(guard, [&] {
+                return slot->state.load() == DONE || (finished && next >= lineCount);
+            });
+        }
+        if (slot->state.load() != DONE) return;
+
+        fwrite(slot->result.data(), 1, slot->result.size(), output);
+        {
+            std::lock_guard<std::mutex> guard(stateLock);
+            slot->state.store(FREE);
+            nextToWrite.store(next + 1);
+        }
+        slotFree.notify_one();
+    }
+}
+
+/// Balances every line of a stream, writing one result line per
+/// input line in input order.
+
+void BatchBalancer::run(FILE* input, FILE* output) {
+    LineReader reader(input);
+    std::string_view line;
+    long count = 0;
+    pending = 0;
+    idle = 0;
+    nextToWrite = 0;
+    lineCount = 0;
+    finished = false;
+
+    for (int i = 0; i < threadCount; i++) {
+        workers.push_back(std::thread(&BatchBalancer::work, this, i));
+    }
+    std::thread writer(&BatchBalancer::write, this, output);
+
+    while (true) {
+        Slot* slot = &slots[count % window];
+        {
+            std::unique_lock<std::mutex> guard(stateLock);
+            slotFree.wait(guard, [&] { return slot->state.load() == FREE; });
+        }
+
+        if (!reader.next(&line)) break;
+        if (!reader.getMapped()) {
+            if (slot->capacity < line.size() + 1) {
+                slot->capacity = line.size() + 1;
+                slot->line = (char*) realloc(slot->line, slot->capacity);
+            }
+            memcpy(slot->line, line.data(), line.size());
+            slot->line[line.size()] = 0;
+            line = std::string_view(slot->line, line.size());
+        }
+        slot->text = line;
+
+        slot->result.clear();
+        if (line.empty()) {
+            slot->result += '\n';
+            complete(count++);
+            continue;
+        }
+
+        slot->state.store(QUEUED);
+        pending++;
+        deques[count % threadCount].push(count);
+        count++;
+        if (idle.load() > 0) {
+            std::lock_guard<std::mutex> guard(stateLock);
+            workReady.notify_one();
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> guard(stateLock);
+        lineCount = count;
+        finished = true;
+    }
+    workReady.notify_all();
+    slotDone.notify_all();
+
+    for (size_t i = 0; i < workers.size(); i++) {
+        workers[i].join();
+    }
+    workers.clear();
+    writer.join();
+}
+
+/// Constructor for the BatchBalancer class.
+
+BatchBalancer::BatchBalancer(int threads, int window, Engine engine, ResultCache* cache,
+        FormulaCache* formulas) {
+    this->engine = engine;
+    this->cache = cache;
+    this->formulas = formulas;
+    threadCount = threads > 0 ? threads : 1;
+    this->window = window > threadCount ? window : threadCount;
+    slots = new Slot[this->window];
+    for (int i = 0; i < this->window; i++) {
+        slots[i].line = NULL;
+        slots[i].capacity = 0;
+        slots[i].state.store(FREE);
+    }
+    deques = new WorkDeque[threadCount];
+}
+
+/// Destructor for the BatchBalancer class.
+
+BatchBalancer::~BatchBalancer() {
+    for (int i = 0; i < window; i++) {
+        free(slots[i].line);
+    }
+    delete[] slots;
+    delete[] deques;
+}
+
+#endif
@@ -0,0 +1,160 @@
+///
+/// file: pool.hpp
+/// Header file for the WorkDeque and BatchBalancer classes
+///
+/// @author Dominick Banasik
+
+#ifndef _POOL_H_
+#define _POOL_H_
+
+#include <stdio.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "matrix.hpp"
+#include "equation.hpp"
+#include "cache.hpp"
+
+/// The WorkDeque class is a double ended queue of job numbers owned
+/// by one worker. The owner takes jobs from the front, in input order,
+/// while idle workers steal from the back.
+
+class WorkDeque {
+    private:
+        std::mutex lock;
+        std::deque<long> jobs;
+
+    public:
+        /// Adds a job to the back of the deque.
+        ///
+        /// @param job the job to add
+
+        void push(long job);
+
+        /// Takes the oldest job from the deque.
+        ///
+        /// @param job where to store the job
+        /// @return whether a job was taken
+
+        bool pop(long* job);
+
+        /// Takes the newest job from the deque.
+        ///
+        /// @param job where to store the job
+        /// @return whether a job was taken
+
+        bool steal(long* job);
+};
+
+/// The Slot struct holds one line of input and its formatted result
+/// while it travels through the reorder buffer. The line is a view of the
+/// mapped input, or of the slot's own copy when the input is a pipe.
+
+struct Slot {
+    std::string_view text;
+    char* line;
+    size_t capacity;
+    std::string result;
+    std::atomic<int> state;
+};
+
+/// The BatchBalancer class balances a stream of equations on a pool of
+/// worker threads. Lines are read into a ring of slots, handed out
+/// through work-stealing deques, and written back in input order once
+/// every earlier line is done.
+
+class BatchBalancer {
+    private:
+        int threadCount;
+        int window;
+        Engine engine;
+        ResultCache* cache;
+        FormulaCache* formulas;
+        Slot* slots;
+        WorkDeque* deques;
+        std::vector<std::thread> workers;
+
+        std::mutex stateLock;
+        std::condition_variable workReady;
+        std::condition_variable slotDone;
+        std::condition_variable slotFree;
+        std::atomic<long> pending;
+        std::atomic<int> idle;
+        std::atomic<long> nextToWrite;
+        long lineCount;
+        bool finished;
+
+        /// Runs one worker thread until the input is finished.
+        ///
+        /// @param id the index of the worker
+
+        void work(int id);
+
+        /// Takes a job from a worker's own deque or steals one from another.
+        ///
+        /// @param id the index of the worker
+        /// @param job where to store the job
+        /// @return whether a job was found
+
+        bool findJob(int id, long* job);
+
+        /// Marks a slot as done and wakes the writer if it is waiting on it.
+        ///
+        /// @param job the job the slot belongs to
+
+        void complete(long job);
+
+        /// Writes finished results to a stream in input order.
+        ///
+        /// @param output the stream to write to
+
+        void write(FILE* output);
+
+    public:
+        /// Constructor for the BatchBalancer class.
+        ///
+        /// @param threads the number of worker threads
+        /// @param window the number of lines that may be in flight at once
+        /// @param engine the elimination to balance with
+        /// @param cache the cache of earlier solutions shared by the
+        ///              workers, or NULL
+        /// @param formulas the cache of parsed formulas shared by the
+        ///                 workers, or NULL
+
+        BatchBalancer(int threads, int window, Engine engine, ResultCache* cache = NULL,
+                FormulaCache* formulas = NULL);
+
+        /// Destructor for the BatchBalancer class.
+
+        ~BatchBalancer();
+
+        /// Balances every line of a stream, writing one result line per
+        /// input line in input order. Blank input lines produce blank
+        /// output lines. The lines of a regular file are balanced where
+        /// they lie in its mapping, without being copied.
+        ///
+        /// @param input the stream to read equations from
+        /// @param output the stream to write results to
+
+        void run(FILE* input, FILE* output);
+
+        /// Balances a single equation and appends the result to a string.
+        ///
+        /// @param equation the equation to parse the line into
+        /// @param line the equation to balance
+        /// @param engine the elimination to balance with
+        /// @param cache the cache of earlier solutions, or NULL
+        /// @param result the string to append to
+
+        static void balance(Equation& equation, std::string_view line, Engine engine, ResultCache* cache,
+                std::string& result);
+};
+
+#endif
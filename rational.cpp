@@ -0,0 +1,120 @@
+///
+/// file: rational.cpp
+/// Implementation for the Rational class
+///
+/// @author Dominick Banasik
+
+#include "rational.hpp"
+
+#ifndef _RATIONAL_IMPL_
+#define _RATIONAL_IMPL_
+
+/// Simplifies the rational.
+
+void Rational::simplify() {
+    if (numerator.isZero()) {
+        denominator = 1;
+        return;
+    }
+
+    Integer g = Integer::gcd(numerator, denominator);
+    if (!g.isOne()) {
+        numerator.divide(g);
+        denominator.divide(g);
+    }
+
+    if (denominator.sign() < 0) {
+        numerator.negate();
+        denominator.negate();
+    }
+}
+
+/// Adds another rational with Integer arithmetic, cancelling the common
+/// factor of the denominators as Fraction::add does.
+
+void Rational::addSlow(const Rational& other) {
+    if (denominator.compare(other.denominator) == 0) {
+        numerator.add(other.numerator);
+        simplify();
+        return;
+    }
+
+    Integer g = Integer::gcd(denominator, other.denominator);
+    Integer left(other.denominator);
+    Integer right(denominator);
+    left.divide(g);
+    right.divide(g);
+
+    Integer scaled(other.numerator);
+    scaled.multiply(right);
+    numerator.multiply(left);
+    numerator.add(scaled);
+
+    if (numerator.isZero()) {
+        denominator = 1;
+        return;
+    }
+
+    Integer g2 = g.isOne() ? Integer(1) : Integer::gcd(numerator, g);
+    Integer otherDen(other.denominator);
+    if (!g2.isOne()) {
+        numerator.divide(g2);
+        otherDen.divide(g2);
+    }
+    denominator = right;
+    denominator.multiply(otherDen);
+}
+
+/// Multiplies by another rational with Integer arithmetic, cancelling
+/// across the two rationals first.
+
+void Rational::multiplySlow(const Rational& other) {
+    if (numerator.isZero() || other.numerator.isZero()) {
+        numerator = 0;
+        denominator = 1;
+        return;
+    }
+
+    Integer g1 = Integer::gcd(numerator, other.denominator);
+    Integer g2 = Integer::gcd(other.numerator, denominator);
+    Integer otherNum(other.numerator);
+    Integer otherDen(other.denominator);
+
+    numerator.divide(g1);
+    otherDen.divide(g1);
+    denominator.divide(g2);
+    otherNum.divide(g2);
+
+    numerator.multiply(otherNum);
+    denominator.multiply(otherDen);
+}
+
+/// Returns the reciprocal of the rational.
+
+Rational Rational::getReciprocal() const {
+    Rational reciprocal(denominator);
+    reciprocal.denominator = numerator;
+    if (reciprocal.denominator.sign() < 0) {
+        reciprocal.numerator.negate();
+        reciprocal.denominator.negate();
+    }
+    return reciprocal;
+}
+
+/// Constructor for the Rational class.
+
+Rational::Rational(const Integer& val) : numerator(val), denominator(1) {
+}
+
+/// Constructor for the Rational class.
+
+Rational::Rational(const Integer& num, const Integer& den) : numerator(num), denominator(den) {
+    simplify();
+}
+
+/// Constructor for the Rational class.
+
+Rational::Rational(Fraction fraction) : numerator(fraction.getNum()), denominator(fraction.getDen()) {
+}
+
+#endif
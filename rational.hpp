@@ -0,0 +1,201 @@
+///
+/// file: rational.hpp
+/// Header file for the Rational class
+///
+/// @author Dominick Banasik
+
+#ifndef _RATIONAL_H_
+#define _RATIONAL_H_
+
+#include "integer.hpp"
+#include "fraction.hpp"
+
+/// The Rational class represents an exact rational number of any size,
+/// kept in lowest terms with a positive denominator. While both parts
+/// fit in machine words, arithmetic goes through the Fraction kernel;
+/// only a result that overflows falls back to Integer arithmetic.
+
+class Rational {
+    private:
+        Integer numerator;
+        Integer denominator;
+
+        /// Simplifies the rational.
+
+        void simplify();
+
+        /// Adds another rational with Integer arithmetic.
+        ///
+        /// @param other the rational to add
+
+        void addSlow(const Rational& other);
+
+        /// Multiplies by another rational with Integer arithmetic.
+        ///
+        /// @param other the rational to multiply by
+
+        void multiplySlow(const Rational& other);
+
+    public:
+        /// Constructor for the Rational class.
+        ///
+        /// @param val value of the rational
+
+        Rational(long long val = 0);
+
+        /// Constructor for the Rational class.
+        ///
+        /// @param num numerator of the rational
+        /// @param den denominator of the rational
+
+        Rational(long long num, long long den);
+
+        /// Constructor for the Rational class.
+        ///
+        /// @param val value of the rational
+
+        Rational(const Integer& val);
+
+        /// Constructor for the Rational class.
+        ///
+        /// @param num numerator of the rational
+        /// @param den denominator of the rational
+
+        Rational(const Integer& num, const Integer& den);
+
+        /// Constructor for the Rational class.
+        ///
+        /// @param fraction the fraction to convert
+
+        Rational(Fraction fraction);
+
+        /// Returns the reciprocal of the rational.
+        ///
+        /// @return the reciprocal
+
+        Rational getReciprocal() const;
+
+        /// Returns the numerator of the rational.
+        ///
+        /// @return the numerator
+
+        const Integer& getNum() const;
+
+        /// Returns the denominator of the rational.
+        ///
+        /// @return the denominator
+
+        const Integer& getDen() const;
+
+        /// Checks whether an operation on the rational overflowed. Rational
+        /// arithmetic is exact, so this is always false.
+        ///
+        /// @return whether or not the value is still exact
+
+        bool getOverflow() const;
+
+        /// Multiplies the rational by another.
+        ///
+        /// @param other the rational to multiply by
+
+        void multiply(const Rational& other);
+
+        /// Multiplies the rational by a scalar.
+        ///
+        /// @param scalar the scalar to multiply by
+
+        void multiply(long long scalar);
+
+        /// Adds another rational.
+        ///
+        /// @param other the rational to add
+
+        void add(const Rational& other);
+
+        /// Checks whether the rational equals a decimal value.
+        ///
+        /// @param d the value to compare to
+        /// @return whether or not the rational is equal
+
+        bool equals(double d) const;
+};
+
+/// Returns the numerator of the rational.
+
+inline const Integer& Rational::getNum() const {
+    return numerator;
+}
+
+/// Returns the denominator of the rational.
+
+inline const Integer& Rational::getDen() const {
+    return denominator;
+}
+
+/// Checks whether an operation on the rational overflowed.
+
+inline bool Rational::getOverflow() const {
+    return false;
+}
+
+/// Checks whether the rational equals a decimal value.
+
+inline bool Rational::equals(double d) const {
+    if (d == 0) return numerator.isZero();
+    return d == numerator.toDouble() / denominator.toDouble();
+}
+
+/// Adds another rational.
+
+inline void Rational::add(const Rational& other) {
+    if (numerator.isSmall() && denominator.isSmall() && other.numerator.isSmall() && other.denominator.isSmall()) {
+        Fraction f = Fraction::reduced(numerator.toLong(), denominator.toLong());
+        f.add(Fraction::reduced(other.numerator.toLong(), other.denominator.toLong()));
+        if (!f.getOverflow()) {
+            numerator = f.getNum();
+            denominator = f.getDen();
+            return;
+        }
+    }
+    addSlow(other);
+}
+
+/// Multiplies the rational by another.
+
+inline void Rational::multiply(const Rational& other) {
+    if (numerator.isSmall() && denominator.isSmall() && other.numerator.isSmall() && other.denominator.isSmall()) {
+        Fraction f = Fraction::reduced(numerator.toLong(), denominator.toLong());
+        f.multiply(Fraction::reduced(other.numerator.toLong(), other.denominator.toLong()));
+        if (!f.getOverflow()) {
+            numerator = f.getNum();
+            denominator = f.getDen();
+            return;
+        }
+    }
+    multiplySlow(other);
+}
+
+/// Multiplies the rational by a scalar.
+
+inline void Rational::multiply(long long scalar) {
+    multiply(Rational(scalar));
+}
+
+/// Constructor for the Rational class.
+
+inline Rational::Rational(long long val) : numerator(val), denominator(1) {
+}
+
+/// Constructor for the Rational class.
+
+inline Rational::Rational(long long num, long long den) : numerator(num), denominator(den) {
+    Fraction f(num, den);
+    if (!f.getOverflow()) {
+        numerator = f.getNum();
+        denominator = f.getDen();
+        return;
+    }
+    simplify();
+}
+
+#endif
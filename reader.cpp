@@ -0,0 +1,91 @@
+///
+/// file: reader.cpp
+/// Implementation for the LineReader class
+///
+/// @author Dominick Banasik
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "reader.hpp"
+
+#ifndef _READER_IMPL_
+#define _READER_IMPL_
+
+/// Constructor for the LineReader class.
+
+LineReader::LineReader(FILE* input) {
+    this->input = input;
+    text = NULL;
+    size = 0;
+    position = 0;
+    block = 0;
+    scanned = 0;
+    newlines = 0;
+    mapped = false;
+    buffer = NULL;
+    capacity = 0;
+
+    int descriptor = fileno(input);
+    off_t start = ftello(input);
+    struct stat status;
+    if (descriptor == -1 || start == -1 || fstat(descriptor, &status) != 0 || !S_ISREG(status.st_mode)
+            || status.st_size <= start) {
+        return;
+    }
+
+    void* memory = mmap(NULL, status.st_size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+    if (memory == MAP_FAILED) return;
+    madvise(memory, status.st_size, MADV_SEQUENTIAL);
+    text = (const char*) memory;
+    size = status.st_size;
+    position = start;
+    scanned = start;
+    mapped = true;
+}
+
+/// Destructor for the LineReader class.
+
+LineReader::~LineReader() {
+    if (mapped) munmap((void*) text, size);
+    free(buffer);
+}
+
+/// Checks whether the stream was mapped.
+
+bool LineReader::getMapped() {
+    return mapped;
+}
+
+/// Finds the newlines of the next block of the mapping. The last block of
+/// the file is copied out first, since the mapping ends with it.
+
+void LineReader::scan() {
+    block = scanned;
+    if (size - block >= MATCH_BLOCK) {
+        newlines = Kernels::matchBytes(text + block, '\n');
+    } else {
+        char tail[MATCH_BLOCK];
+        memset(tail, 0, MATCH_BLOCK);
+        memcpy(tail, text + block, size - block);
+        newlines = Kernels::matchBytes(tail, '\n');
+    }
+    scanned = block + MATCH_BLOCK < size ? block + MATCH_BLOCK : size;
+}
+
+/// Reads the next line of a stream that is not mapped.
+
+bool LineReader::readLine(std::string_view* line) {
+    ssize_t length = getline(&buffer, &capacity, input);
+    if (length == -1) return false;
+    while (length > 0 && (buffer[length - 1] == '\n' || buffer[length - 1] == '\r')) {
+        length--;
+    }
+    *line = std::string_view(buffer, length);
+    return true;
+}
+
+#endif
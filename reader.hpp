@@ -0,0 +1,105 @@
+///
+/// file: reader.hpp
+/// Header file for the LineReader class
+///
+/// @author Dominick Banasik
+
+#ifndef _READER_H_
+#define _READER_H_
+
+#include <stdio.h>
+
+#include <string_view>
+
+#include "kernels.hpp"
+
+/// The LineReader class splits a stream into lines. A regular file is
+/// mapped into memory whole, and each line is a view of the mapping, so
+/// a corpus of any size is read without copying a line or limiting its
+/// length. The ends of the lines are found a block of MATCH_BLOCK bytes
+/// at a time with Kernels::matchBytes, which gives the positions of every
+/// newline in the block at once. Any other stream, such as a pipe, is
+/// read with getline into a buffer of the reader's own.
+
+class LineReader {
+    private:
+        FILE* input;
+        const char* text;
+        size_t size;
+        size_t position;
+        size_t block;
+        size_t scanned;
+        unsigned long long newlines;
+        bool mapped;
+        char* buffer;
+        size_t capacity;
+
+        /// Finds the newlines of the next block of the mapping.
+
+        void scan();
+
+        /// Reads the next line of a stream that is not mapped.
+        ///
+        /// @param line where to store the line
+        /// @return whether a line was read before the end of the stream
+
+        bool readLine(std::string_view* line);
+
+    public:
+        /// Constructor for the LineReader class. The stream is mapped if
+        /// it is a regular file, from where it has been read up to.
+        ///
+        /// @param input the stream to read, which the reader does not close
+
+        LineReader(FILE* input);
+
+        /// Destructor for the LineReader class.
+
+        ~LineReader();
+
+        LineReader(const LineReader& copy) = delete;
+        LineReader& operator=(const LineReader& copy) = delete;
+
+        /// Checks whether the stream was mapped, in which case every line
+        /// stays valid as long as the reader.
+        ///
+        /// @return whether or not the stream was mapped
+
+        bool getMapped();
+
+        /// Reads the next line, without its newline or any carriage
+        /// returns before it.
+        ///
+        /// @param line where to store the line, valid until the reader is
+        ///             destroyed if the stream was mapped and until the
+        ///             next line is read if not
+        /// @return whether a line was read before the end of the stream
+
+        bool next(std::string_view* line);
+};
+
+/// Reads the next line. In a mapping, the line ends at the first newline
+/// left in the mask of the current block, or at the end of the file.
+
+inline bool LineReader::next(std::string_view* line) {
+    if (!mapped) return readLine(line);
+    if (position >= size) return false;
+    while (newlines == 0 && scanned < size) {
+        scan();
+    }
+
+    size_t end = size;
+    if (newlines != 0) {
+        end = block + __builtin_ctzll(newlines);
+        newlines &= newlines - 1;
+    }
+    size_t length = end - position;
+    while (length > 0 && text[position + length - 1] == '\r') {
+        length--;
+    }
+    *line = std::string_view(text + position, length);
+    position = end + 1;
+    return true;
+}
+
+#endif
@@ -0,0 +1,437 @@
+///
+/// file: server.cpp
+/// Implementation for the Server class
+///
+/// @author Dominick Banasik
+
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/signalfd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+#include <algorithm>
+
+#include "server.hpp"
+#include "equation.hpp"
+#include "pool.hpp"
+
+#ifndef _SERVER_IMPL_
+#define _SERVER_IMPL_
+
+/// Runs one worker thread until the server stops.
+
+void Server::work() {
+    Equation equation(formulas);
+
+    while (true) {
+        Request* request;
+        {
+            std::unique_lock<std::mutex> guard(lock);
+            ready.wait(guard, [this] { return !queue.empty() || stopping; });
+            if (queue.empty()) return;
+            request = queue.front();
+            queue.pop_front();
+        }
+
+        BatchBalancer::balance(equation, request->line, engine, cache, request->result);
+
+        bool wake;
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            wake = done.empty();
+            done.push_back(request);
+        }
+        if (wake) {
+            unsigned long long one = 1;
+            if (write(wakeup, &one, sizeof(one)) < 0) perror("eventfd");
+        }
+    }
+}
+
+/// Accepts every waiting client.
+
+void Server::accept() {
+    while (true) {
+        int fd = accept4(listener, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) perror("accept");
+            return;
+        }
+
+        Connection* connection = new Connection;
+        connection->fd = fd;
+        connection->outstanding = 0;
+        connection->eof = false;
+        connection->closed = false;
+        connections[fd] = connection;
+
+        struct epoll_event event;
+        event.events = EPOLLIN;
+        event.data.fd = fd;
+        epoll_ctl(events, EPOLL_CTL_ADD, fd, &event);
+    }
+}
+
+/// Reads from a client and queues each complete line.
+
+void Server::receive(Connection* connection) {
+    char buffer[READ_SIZE];
+    ssize_t length = read(connection->fd, buffer, sizeof(buffer));
+    if (length < 0) {
+        if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) close(connection);
+        return;
+    }
+    if (length == 0) {
+        // A last line without a newline still gets its answer.
+        connection->eof = true;
+        if (!connection->input.empty()) connection->input += '\n';
+    } else {
+        connection->input.append(buffer, length);
+    }
+
+    size_t first = connection->requests.size();
+    size_t start = 0;
+    size_t end;
+    int queued = 0;
+    while ((end = connection->input.find('\n', start)) != std::string::npos) {
+        size_t stop = end;
+        while (stop > start && connection->input[stop - 1] == '\r') stop--;
+
+        Request* request = new Request;
+        request->connection = connection;
+        request->done = stop == start;
+        if (request->done) {
+            request->result += '\n';
+        } else {
+            request->line.assign(connection->input, start, stop - start);
+            connection->outstanding++;
+            queued++;
+        }
+        connection->requests.push_back(request);
+        start = end + 1;
+    }
+    connection->input.erase(0, start);
+
+    if (queued > 0) {
+        std::lock_guard<std::mutex> guard(lock);
+        for (size_t i = first; i < connection->requests.size(); i++) {
+            if (!connection->requests[i]->done) queue.push_back(connection->requests[i]);
+        }
+    }
+    if (queued == 1) {
+        ready.notify_one();
+    } else if (queued > 1) {
+        ready.notify_all();
+    }
+
+    if (connection->input.size() > MAX_REQUEST) {
+        close(connection);
+        return;
+    }
+    flush(connection);
+}
+
+/// Hands the results the workers finished back to their clients.
+
+void Server::collect() {
+    unsigned long long count;
+    if (read(wakeup, &count, sizeof(count)) < 0 && errno != EAGAIN) perror("eventfd");
+
+    std::vector<Request*> finished;
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        finished.swap(done);
+    }
+
+    // Each client is flushed once, however many of its results arrived.
+    std::vector<Connection*> touched;
+    for (size_t i = 0; i < finished.size(); i++) {
+        finished[i]->done = true;
+        finished[i]->connection->outstanding--;
+        touched.push_back(finished[i]->connection);
+    }
+    std::sort(touched.begin(), touched.end());
+    touched.erase(std::unique(touched.begin(), touched.end()), touched.end());
+
+    for (size_t i = 0; i < touched.size(); i++) {
+        if (!touched[i]->closed) {
+            flush(touched[i]);
+        } else if (touched[i]->outstanding == 0) {
+            release(touched[i]);
+        }
+    }
+}
+
+/// Writes the finished results of a client in order.
+
+void Server::flush(Connection* connection) {
+    if (connection->closed) return;
+
+    while (!connection->requests.empty() && connection->requests.front()->done) {
+        Request* request = connection->requests.front();
+        connection->output += request->result;
+        connection->requests.pop_front();
+        delete request;
+    }
+
+    while (!connection->output.empty()) {
+        ssize_t length = send(connection->fd, connection->output.data(), connection->output.size(), MSG_NOSIGNAL);
+        if (length < 0) {
+            if (errno == EINTR) continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                close(connection);
+                return;
+            }
+            break;
+        }
+        connection->output.erase(0, length);
+    }
+
+    if (connection->eof && connection->requests.empty() && connection->output.empty()) {
+        close(connection);
+        return;
+    }
+    watch(connection);
+}
+
+/// Chooses the events to wait for on a client. A client that has sent too
+/// many requests ahead is not read from until it takes its results.
+
+void Server::watch(Connection* connection) {
+    struct epoll_event event;
+    event.events = 0;
+    if (!connection->eof && connection->requests.size() < MAX_PIPELINE) event.events |= EPOLLIN;
+    if (!connection->output.empty()) event.events |= EPOLLOUT;
+    event.data.fd = connection->fd;
+    epoll_ctl(events, EPOLL_CTL_MOD, connection->fd, &event);
+}
+
+/// Closes a client.
+
+void Server::close(Connection* connection) {
+    if (connection->closed) return;
+    connection->closed = true;
+    epoll_ctl(events, EPOLL_CTL_DEL, connection->fd, NULL);
+    ::close(connection->fd);
+    connections.erase(connection->fd);
+    if (connection->outstanding == 0) {
+        release(connection);
+    } else {
+        closing.push_back(connection);
+    }
+}
+
+/// Frees a closed client whose requests are all done.
+
+void Server::release(Connection* connection) {
+    auto found = std::find(closing.begin(), closing.end(), connection);
+    if (found != closing.end()) closing.erase(found);
+    for (size_t i = 0; i < connection->requests.size(); i++) {
+        delete connection->requests[i];
+    }
+    delete connection;
+}
+
+/// Handles a signal sent to the server.
+
+bool Server::handleSignal() {
+    struct signalfd_siginfo info;
+    if (read(signals, &info, sizeof(info)) != sizeof(info)) return false;
+    if (info.ssi_signo != SIGUSR1) return true;
+
+    std::string output;
+    Stats::exportAs(statsFormat, output);
+    fputs(output.c_str(), stderr);
+    fflush(stderr);
+    return false;
+}
+
+/// Removes a socket left behind at the path by a server that is gone.
+
+bool Server::removeStale(const struct sockaddr_un& address) {
+    struct stat info;
+    if (lstat(path, &info) < 0) {
+        if (errno == ENOENT) return true;
+        perror(path);
+        return false;
+    }
+    if (!S_ISSOCK(info.st_mode)) {
+        fprintf(stderr, "%s: file exists and is not a socket\n", path);
+        return false;
+    }
+
+    int probe = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (probe < 0) {
+        perror("socket");
+        return false;
+    }
+    int connected = connect(probe, (const struct sockaddr*) &address, sizeof(address));
+    int error = errno;
+    ::close(probe);
+    if (connected == 0) {
+        fprintf(stderr, "%s: another server is listening\n", path);
+        return false;
+    }
+    if (error != ECONNREFUSED) {
+        errno = error;
+        perror(path);
+        return false;
+    }
+    if (unlink(path) < 0 && errno != ENOENT) {
+        perror(path);
+        return false;
+    }
+    return true;
+}
+
+/// Listens on the socket and serves clients until a signal stops it.
+
+bool Server::run() {
+    struct sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(address.sun_path)) {
+        fprintf(stderr, "%s: socket path too long\n", path);
+        return false;
+    }
+    strcpy(address.sun_path, path);
+
+    listener = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listener < 0) {
+        perror("socket");
+        return false;
+    }
+    if (!removeStale(address)) return false;
+    if (bind(listener, (struct sockaddr*) &address, sizeof(address)) < 0
+            || listen(listener, SOMAXCONN) < 0) {
+        perror(path);
+        return false;
+    }
+
+    // Workers inherit the mask, so the signals only reach the signalfd.
+    sigset_t mask;
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGINT);
+    sigaddset(&mask, SIGTERM);
+    sigaddset(&mask, SIGUSR1);
+    pthread_sigmask(SIG_BLOCK, &mask, NULL);
+    auto fail = [this, &mask](const char* call) {
+        perror(call);
+        pthread_sigmask(SIG_UNBLOCK, &mask, NULL);
+        unlink(path);
+        return false;
+    };
+    signals = signalfd(-1, &mask, SFD_NONBLOCK | SFD_CLOEXEC);
+    if (signals < 0) return fail("signalfd");
+    wakeup = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (wakeup < 0) return fail("eventfd");
+    events = epoll_create1(EPOLL_CLOEXEC);
+    if (events < 0) return fail("epoll_create1");
+
+    int watched[] = {listener, wakeup, signals};
+    for (int i = 0; i < 3; i++) {
+        struct epoll_event event;
+        event.events = EPOLLIN;
+        event.data.fd = watched[i];
+        if (epoll_ctl(events, EPOLL_CTL_ADD, watched[i], &event) < 0) return fail("epoll_ctl");
+    }
+
+    stopping = false;
+    for (int i = 0; i < threadCount; i++) {
+        workers.push_back(std::thread(&Server::work, this));
+    }
+
+    struct epoll_event happened[MAX_EVENTS];
+    bool running = true;
+    while (running) {
+        int count = epoll_wait(events, happened, MAX_EVENTS, -1);
+        if (count < 0) {
+            if (errno == EINTR) continue;
+            perror("epoll_wait");
+            break;
+        }
+
+        for (int i = 0; i < count; i++) {
+            int fd = happened[i].data.fd;
+            if (fd == listener) {
+                accept();
+            } else if (fd == wakeup) {
+                collect();
+            } else if (fd == signals) {
+                running = !handleSignal();
+            } else {
+                auto found = connections.find(fd);
+                if (found == connections.end()) continue;
+                Connection* connection = found->second;
+                if (happened[i].events & (EPOLLERR | EPOLLHUP) && !(happened[i].events & EPOLLIN)) {
+                    close(connection);
+                } else if (happened[i].events & EPOLLIN) {
+                    receive(connection);
+                } else if (happened[i].events & EPOLLOUT) {
+                    flush(connection);
+                }
+            }
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        stopping = true;
+        queue.clear();
+    }
+    ready.notify_all();
+    for (size_t i = 0; i < workers.size(); i++) {
+        workers[i].join();
+    }
+    workers.clear();
+
+    // The workers are gone, so every request left is freed with its client,
+    // including the clients that closed while their requests were pending.
+    done.clear();
+    while (!connections.empty()) {
+        Connection* connection = connections.begin()->second;
+        connection->outstanding = 0;
+        close(connection);
+    }
+    while (!closing.empty()) {
+        release(closing.back());
+    }
+    unlink(path);
+    return true;
+}
+
+/// Constructor for the Server class.
+
+Server::Server(const char* path, int threads, Engine engine, ResultCache* cache, FormulaCache* formulas,
+        StatsFormat statsFormat) {
+    this->path = path;
+    this->statsFormat = statsFormat;
+    this->engine = engine;
+    this->cache = cache;
+    this->formulas = formulas;
+    threadCount = threads > 0 ? threads : 1;
+    listener = -1;
+    events = -1;
+    wakeup = -1;
+    signals = -1;
+    stopping = false;
+}
+
+/// Destructor for the Server class.
+
+Server::~Server() {
+    int descriptors[] = {listener, events, wakeup, signals};
+    for (int i = 0; i < 4; i++) {
+        if (descriptors[i] >= 0) ::close(descriptors[i]);
+    }
+}
+
+#endif
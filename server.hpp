@@ -0,0 +1,172 @@
+///
+/// file: server.hpp
+/// Header file for the Server class
+///
+/// @author Dominick Banasik
+
+#ifndef _SERVER_H_
+#define _SERVER_H_
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <sys/un.h>
+
+#include "matrix.hpp"
+#include "cache.hpp"
+#include "stats.hpp"
+
+#define READ_SIZE (1 << 16)
+#define MAX_REQUEST (1 << 20)
+#define MAX_PIPELINE 4096
+#define MAX_EVENTS 64
+
+struct Connection;
+
+/// The Request struct holds one equation sent by a client and its
+/// formatted result while it travels through the worker pool.
+
+struct Request {
+    Connection* connection;
+    std::string line;
+    std::string result;
+    bool done;
+};
+
+/// The Connection struct holds the state of one client: the bytes read
+/// but not yet split into lines, its requests in the order they arrived,
+/// and the results not yet written back.
+
+struct Connection {
+    int fd;
+    std::string input;
+    std::string output;
+    std::deque<Request*> requests;
+    int outstanding;
+    bool eof;
+    bool closed;
+};
+
+/// The Server class balances equations for clients of a Unix domain
+/// socket. Each client sends one equation per line and gets one result
+/// line back per equation, in the order it sent them, so requests may be
+/// pipelined. One thread runs an epoll loop over every connection while a
+/// pool of workers balances, sharing the caches for as long as the server
+/// runs. SIGINT or SIGTERM stops it, and SIGUSR1 writes its stats to
+/// stderr.
+
+class Server {
+    private:
+        const char* path;
+        int threadCount;
+        Engine engine;
+        ResultCache* cache;
+        FormulaCache* formulas;
+        StatsFormat statsFormat;
+        int listener;
+        int events;
+        int wakeup;
+        int signals;
+        std::unordered_map<int, Connection*> connections;
+        std::vector<Connection*> closing;
+        std::vector<std::thread> workers;
+
+        std::mutex lock;
+        std::condition_variable ready;
+        std::deque<Request*> queue;
+        std::vector<Request*> done;
+        bool stopping;
+
+        /// Runs one worker thread until the server stops.
+
+        void work();
+
+        /// Accepts every waiting client.
+
+        void accept();
+
+        /// Reads from a client and queues each complete line.
+        ///
+        /// @param connection the client to read from
+
+        void receive(Connection* connection);
+
+        /// Hands the results the workers finished back to their clients.
+
+        void collect();
+
+        /// Writes the finished results of a client in order, as far as
+        /// the socket allows, and closes it once it is done.
+        ///
+        /// @param connection the client to write to
+
+        void flush(Connection* connection);
+
+        /// Chooses the events to wait for on a client.
+        ///
+        /// @param connection the client to watch
+
+        void watch(Connection* connection);
+
+        /// Reads a signal sent to the server and writes the stats if it
+        /// asks for them.
+        ///
+        /// @return whether the signal stops the server
+
+        bool handleSignal();
+
+        /// Closes a client. Its memory is freed once the workers are done
+        /// with its requests, and until then it is kept in closing.
+        ///
+        /// @param connection the client to close
+
+        void close(Connection* connection);
+
+        /// Removes the socket a server that is no longer running left at
+        /// the path. Anything else at the path is left alone.
+        ///
+        /// @param address the address of the socket
+        /// @return whether the path is free to bind
+
+        bool removeStale(const struct sockaddr_un& address);
+
+        /// Frees a closed client whose requests are all done.
+        ///
+        /// @param connection the client to free
+
+        void release(Connection* connection);
+
+    public:
+        /// Constructor for the Server class.
+        ///
+        /// @param path the path of the socket to listen on
+        /// @param threads the number of worker threads
+        /// @param engine the elimination to balance with
+        /// @param cache the cache of earlier solutions, or NULL
+        /// @param formulas the cache of parsed formulas, or NULL
+        /// @param statsFormat the format SIGUSR1 writes stats in
+
+        Server(const char* path, int threads, Engine engine, ResultCache* cache = NULL,
+                FormulaCache* formulas = NULL, StatsFormat statsFormat = STATS_JSON);
+
+        /// Destructor for the Server class.
+
+        ~Server();
+
+        Server(const Server& copy) = delete;
+        Server& operator=(const Server& copy) = delete;
+
+        /// Listens on the socket and serves clients until a signal stops
+        /// the server, then removes the socket.
+        ///
+        /// @return whether or not the socket could be set up
+
+        bool run();
+};
+
+#endif
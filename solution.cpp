@@ -8,18 +8,19 @@
 #include <stdlib.h>
 
 #include "solution.hpp"
-#include "fraction.hpp"
+#include "rational.hpp"
 
 #ifndef _SOLUTION_IMPL_
 #define _SOLUTION_IMPL_
 
 /// Constructor for the Solution class.
 
-Solution::Solution(int size) {
-    solution = (Fraction*) malloc(size * sizeof(Fraction));
+Solution::Solution(int size, Arena* arena) {
+    solution = arena ? arena->create<Rational>(size) : new Rational[size];
+    unique = false;
 
     for (int i = 0; i < size; i++) {
-        solution[i] = Fraction(-1, 1);
+        solution[i] = Rational(-1);
     }
 }
 
@@ -31,7 +32,7 @@ void Solution::setStatus(Status status) {
 
 /// Sets a value for a coefficient in the solution.
 
-void Solution::setValue(Fraction value, int index) {
+void Solution::setValue(const Rational& value, int index) {
     solution[index] = value;
 }
 
@@ -41,9 +42,21 @@ Status Solution::getStatus() {
     return status;
 }
 
+/// Marks whether the equation has only this solution.
+
+void Solution::setUnique(bool unique) {
+    this->unique = unique;
+}
+
+/// Checks whether the equation has only this solution.
+
+bool Solution::getUnique() {
+    return unique;
+}
+
 /// Returns a coefficient value from the solution.
 
-Fraction Solution::getValue(int index) {
+Rational Solution::getValue(int index) {
     return solution[index];
 }
 
@@ -7,7 +7,8 @@
 #ifndef _SOLUTION_H_
 #define _SOLUTION_H_
 
-#include "fraction.hpp"
+#include "rational.hpp"
+#include "arena.hpp"
 
 /// The Status enum represents the type of solution
 /// that a chemical equation has.
@@ -16,7 +17,9 @@ enum Status {
     BALANCED,
     UNBALANCED,
     SOLVED,
-    UNSOLVED
+    UNSOLVED,
+    OVERFLOWED,
+    INVALID
 };
 
 /// The Solution class represents the solution to
@@ -24,15 +27,18 @@ enum Status {
 
 class Solution {
     private:
-        Fraction* solution;
+        Rational* solution;
         Status status;
+        bool unique;
 
     public:
-        /// Constructor for the Solution class.
+        /// Constructor for the Solution class. Copies of a solution share
+        /// its coefficients, which live until the arena is reset.
         ///
         /// @param size the number of coefficients in the solution
+        /// @param arena the arena to allocate from, or NULL for the heap
 
-        Solution(int size);
+        Solution(int size, Arena* arena = NULL);
         
         /// Sets the status of the solution.
         ///
@@ -45,20 +51,35 @@ class Solution {
         /// @param value the value to set
         /// @param index the index of the coefficient to set
 
-        void setValue(Fraction value, int index);
+        void setValue(const Rational& value, int index);
 
         /// Returns a coefficient value from the solution.
         ///
         /// @param index the index of the coefficient to return
         /// @return the coefficient at the specified index
 
-        Fraction getValue(int index);
+        Rational getValue(int index);
 
         /// Returns the status of the solution.
         ///
         /// @return the status
 
         Status getStatus();
+
+        /// Marks whether the equation has only this solution, up to scale,
+        /// with every coefficient positive.
+        ///
+        /// @param unique whether the solution is unique
+
+        void setUnique(bool unique);
+
+        /// Checks whether the equation has only this solution, up to scale,
+        /// with every coefficient positive. A unique solution does not depend
+        /// on the order the molecules were given in.
+        ///
+        /// @return whether the solution is unique
+
+        bool getUnique();
 };
 
 #endif
@@ -0,0 +1,272 @@
+///
+/// file: sparse.cpp
+/// Implementation for the SparseMatrix class
+///
+/// @author Dominick Banasik
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <new>
+
+#include "sparse.hpp"
+
+#ifndef _SPARSE_IMPL_
+#define _SPARSE_IMPL_
+
+/// Finds the entry of a row in a column.
+
+template <typename T>
+int SparseMatrix<T>::find(int row, int col) const {
+    const Row& entries = cells[row];
+    int low = 0;
+    int high = (int) entries.size() - 1;
+    while (low <= high) {
+        int middle = (low + high) / 2;
+        if (entries[middle].col == col) return middle;
+        if (entries[middle].col < col) {
+            low = middle + 1;
+        } else {
+            high = middle - 1;
+        }
+    }
+    return -1;
+}
+
+/// Adds a multiple of the pivot row to another row.
+
+template <typename T>
+void SparseMatrix<T>::addRow(int row, int pivot, const T& scalar, Row& merged) {
+    Row& target = cells[row];
+    const Row& source = cells[pivot];
+    size_t a = 0;
+    size_t b = 0;
+
+    merged.clear();
+    while (a < target.size() || b < source.size()) {
+        if (b == source.size() || (a < target.size() && target[a].col < source[b].col)) {
+            merged.push_back(static_cast<SparseEntry<T>&&>(target[a++]));
+            continue;
+        }
+
+        SparseEntry<T> entry;
+        entry.col = source[b].col;
+        entry.value = source[b++].value;
+        entry.value.multiply(scalar);
+        if (a < target.size() && target[a].col == entry.col) {
+            entry.value.add(target[a++].value);
+        }
+        if (!entry.value.equals(0)) merged.push_back(static_cast<SparseEntry<T>&&>(entry));
+    }
+
+    target.swap(merged);
+}
+
+/// Row reduces the matrix to rref.
+
+template <typename T>
+void SparseMatrix<T>::reduce() {
+    ArenaAllocator<SparseEntry<T> > allocator(arena);
+    Row merged(allocator);
+    int pivots = 0;
+
+    for (int c = 0; c < cols && pivots < rows; c++) {
+        int best = -1;
+        for (int i = pivots; i < rows; i++) {
+            if (cells[i].empty() || cells[i][0].col != c) continue;
+            if (best == -1 || cells[i].size() < cells[best].size()) best = i;
+        }
+        if (best == -1) continue;
+
+        if (best != pivots) {
+            cells[best].swap(cells[pivots]);
+            int tmp = order[best];
+            order[best] = order[pivots];
+            order[pivots] = tmp;
+        }
+
+        Row& pivotRow = cells[pivots];
+        if (!pivotRow[0].value.equals(1)) {
+            T reciprocal = pivotRow[0].value.getReciprocal();
+            for (size_t j = 0; j < pivotRow.size(); j++) {
+                pivotRow[j].value.multiply(reciprocal);
+            }
+        }
+
+        for (int i = 0; i < rows; i++) {
+            if (i == pivots || cells[i].empty()) continue;
+            int index = i > pivots ? (cells[i][0].col == c ? 0 : -1) : find(i, c);
+            if (index == -1) continue;
+            T scalar(cells[i][index].value);
+            scalar.multiply(-1);
+            addRow(i, pivots, scalar, merged);
+        }
+
+        pivots++;
+    }
+}
+
+/// Returns the simplest non-zero solution to the matrix
+
+template <typename T>
+Solution SparseMatrix<T>::solve() {
+    return solveReduced(*this);
+}
+
+/// Returns the arena the matrix allocates from.
+
+template <typename T>
+Arena* SparseMatrix<T>::getArena() const {
+    return arena;
+}
+
+/// Returns the number of rows in the matrix.
+
+template <typename T>
+int SparseMatrix<T>::getRows() const {
+    return rows;
+}
+
+/// Returns the number of columns in the matrix.
+
+template <typename T>
+int SparseMatrix<T>::getCols() const {
+    return cols;
+}
+
+/// Returns the number of non-zero cells in the matrix.
+
+template <typename T>
+int SparseMatrix<T>::getNonzeros() const {
+    int count = 0;
+    for (int i = 0; i < rows; i++) {
+        count += cells[i].size();
+    }
+    return count;
+}
+
+/// Returns the element a row corresponds to.
+
+template <typename T>
+int SparseMatrix<T>::getAtom(int row) const {
+    return atoms[order[row]];
+}
+
+/// Adds a quantity to an entry in the matrix. Entries are usually added
+/// in column order, which appends to the row.
+
+template <typename T>
+void SparseMatrix<T>::addValue(int row, int col, long long quantity) {
+    Row& entries = cells[row];
+    size_t index = entries.size();
+    while (index > 0 && entries[index - 1].col > col) index--;
+
+    if (index > 0 && entries[index - 1].col == col) {
+        entries[index - 1].value.add(T(quantity));
+        if (entries[index - 1].value.equals(0)) entries.erase(entries.begin() + (index - 1));
+        return;
+    }
+    if (quantity == 0) return;
+
+    SparseEntry<T> entry;
+    entry.col = col;
+    entry.value = T(quantity);
+    entries.insert(entries.begin() + index, static_cast<SparseEntry<T>&&>(entry));
+}
+
+/// Returns the value of an entry in the matrix.
+
+template <typename T>
+T SparseMatrix<T>::getValue(int row, int col) {
+    int index = find(row, col);
+    return index == -1 ? T(0) : cells[row][index].value;
+}
+
+/// Returns the column of the first non-zero entry in a row.
+
+template <typename T>
+int SparseMatrix<T>::getLead(int row) {
+    return cells[row].empty() ? cols : cells[row][0].col;
+}
+
+/// Checks whether any cell of the matrix overflowed while it was
+/// being computed.
+
+template <typename T>
+bool SparseMatrix<T>::getOverflow() {
+    for (int i = 0; i < rows; i++) {
+        for (size_t j = 0; j < cells[i].size(); j++) {
+            if (cells[i][j].value.getOverflow()) return true;
+        }
+    }
+    return false;
+}
+
+/// Prints a representation of the entire matrix.
+
+template <typename T>
+void SparseMatrix<T>::printMatrix() {
+    printf("==========MATRIX==========\n");
+    for (int i = 0; i < rows; i++) {
+        printf("%s:\t", PeriodicTable::symbol(getAtom(i)));
+        for (size_t j = 0; j < cells[i].size(); j++) {
+            std::string cell;
+            cells[i][j].value.getNum().toString(cell);
+            cell += '/';
+            cells[i][j].value.getDen().toString(cell);
+            printf("%d:%s\t", cells[i][j].col, cell.c_str());
+        }
+        printf("\n");
+    }
+}
+
+/// Constructor for the SparseMatrix class.
+
+template <typename T>
+SparseMatrix<T>::SparseMatrix(int* atoms, int rows, int cols, Arena* arena) {
+    this->rows = rows;
+    this->cols = cols;
+    this->atoms = atoms;
+    this->arena = arena;
+    if (arena) {
+        order = arena->allocate<int>(rows);
+        cells = arena->allocate<Row>(rows);
+    } else {
+        order = (int*) malloc((rows > 0 ? rows : 1) * sizeof(int));
+        cells = (Row*) malloc((rows > 0 ? rows : 1) * sizeof(Row));
+    }
+    for (int i = 0; i < rows; i++) {
+        order[i] = i;
+        new (&cells[i]) Row(ArenaAllocator<SparseEntry<T> >(arena));
+    }
+}
+
+/// Move constructor for the SparseMatrix class.
+
+template <typename T>
+SparseMatrix<T>::SparseMatrix(SparseMatrix&& other) {
+    rows = other.rows;
+    cols = other.cols;
+    atoms = other.atoms;
+    arena = other.arena;
+    order = other.order;
+    cells = other.cells;
+    other.rows = 0;
+    other.order = NULL;
+    other.cells = NULL;
+}
+
+/// Destructor for the SparseMatrix class.
+
+template <typename T>
+SparseMatrix<T>::~SparseMatrix() {
+    for (int i = 0; i < rows; i++) {
+        cells[i].~Row();
+    }
+    if (!arena) {
+        free(order);
+        free(cells);
+    }
+}
+
+#endif
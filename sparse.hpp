@@ -0,0 +1,163 @@
+///
+/// file: sparse.hpp
+/// Header file for the SparseMatrix class
+///
+/// @author Dominick Banasik
+
+#ifndef _SPARSE_H_
+#define _SPARSE_H_
+
+#include <vector>
+
+#include "matrix.hpp"
+#include "arena.hpp"
+
+/// The SparseEntry struct holds one non-zero cell of a sparse row.
+
+template <typename T>
+struct SparseEntry {
+    int col;
+    T value;
+};
+
+/// The SparseMatrix class represents the same matrix as the Matrix class,
+/// with each row corresponding to an atom and each column to a molecule,
+/// but stores only the non-zero cells. Every row is a list of entries
+/// sorted by column, so memory and elimination time follow the number of
+/// non-zero cells rather than atoms times molecules.
+
+template <typename T>
+class SparseMatrix {
+    private:
+        typedef std::vector<SparseEntry<T>, ArenaAllocator<SparseEntry<T> > > Row;
+
+        int rows;
+        int cols;
+        int* atoms;
+        int* order;
+        Row* cells;
+        Arena* arena;
+
+        /// Finds the entry of a row in a column.
+        ///
+        /// @param row the row to search
+        /// @param col the column to find
+        /// @return the index of the entry, or -1 if the cell is zero
+
+        int find(int row, int col) const;
+
+        /// Adds a multiple of the pivot row to another row, merging the
+        /// two lists of entries.
+        ///
+        /// @param row the row to add to
+        /// @param pivot the pivot row
+        /// @param scalar the scalar to multiply the pivot row by
+        /// @param merged scratch space for the merged row
+
+        void addRow(int row, int pivot, const T& scalar, Row& merged);
+
+    public:
+        /// Constructor for the SparseMatrix class.
+        ///
+        /// @param atoms the element ID of each row
+        /// @param rows the number of rows
+        /// @param cols the number of columns
+        /// @param arena the arena to allocate from, or NULL for the heap
+
+        SparseMatrix(int* atoms, int rows, int cols, Arena* arena = NULL);
+
+        /// Move constructor for the SparseMatrix class.
+        ///
+        /// @param other the matrix to take the cells of
+
+        SparseMatrix(SparseMatrix&& other);
+
+        /// Destructor for the SparseMatrix class.
+
+        ~SparseMatrix();
+
+        SparseMatrix(const SparseMatrix& copy) = delete;
+        SparseMatrix& operator=(const SparseMatrix& copy) = delete;
+
+        /// Returns the arena the matrix allocates from.
+        ///
+        /// @return the arena, or NULL if the matrix uses the heap
+
+        Arena* getArena() const;
+
+        /// Returns the number of rows in the matrix.
+        ///
+        /// @return the number of rows
+
+        int getRows() const;
+
+        /// Returns the number of columns in the matrix.
+        ///
+        /// @return the number of columns
+
+        int getCols() const;
+
+        /// Returns the number of non-zero cells in the matrix.
+        ///
+        /// @return the number of non-zero cells
+
+        int getNonzeros() const;
+
+        /// Returns the element a row corresponds to.
+        ///
+        /// @param row the row
+        /// @return the element ID of the row
+
+        int getAtom(int row) const;
+
+        /// Adds a quantity to an entry in the matrix.
+        ///
+        /// @param row the row of the entry
+        /// @param col the column of the entry
+        /// @param quantity the value to add to the cell
+
+        void addValue(int row, int col, long long quantity);
+
+        /// Returns the value of an entry in the matrix.
+        ///
+        /// @param row the row of the entry
+        /// @param col the column of the entry
+        /// @return the value held in the cell
+
+        T getValue(int row, int col);
+
+        /// Returns the column of the first non-zero entry in a row.
+        ///
+        /// @param row the row
+        /// @return the column, or the number of columns if the row is zero
+
+        int getLead(int row);
+
+        /// Checks whether any cell of the matrix overflowed while it was
+        /// being computed.
+        ///
+        /// @return whether or not an overflow occurred
+
+        bool getOverflow();
+
+        /// Row reduces the matrix to rref with Gauss-Jordan elimination
+        /// that only visits non-zero cells. Of the rows that can supply a
+        /// pivot, the one with the fewest entries is chosen to keep the
+        /// fill-in of the other rows down.
+
+        void reduce();
+
+        /// Returns the simplest non-zero solution to the matrix.
+        ///
+        /// @return the solution for the matrix
+
+        Solution solve();
+
+        /// Prints a representation of the entire matrix.
+
+        void printMatrix();
+};
+
+#include "sparse.cpp"
+
+#endif
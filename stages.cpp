@@ -0,0 +1,457 @@
+///
+/// file: stages.cpp
+/// A benchmark that times each stage of balancing separately on seeded,
+/// synthetic reactions, sweeping one property of the reactions at a time
+/// and writing the results as CSV or JSON. Build separately from the
+/// balancer, for example:
+///
+///     g++ -std=c++17 -O2 -pthread -o stages stages.cpp arena.cpp cache.cpp composition.cpp
+///         equation.cpp hash.cpp integer.cpp kernels.cpp matrix.cpp modular.cpp molecule.cpp rational.cpp
+///         solution.cpp sparse.cpp stats.cpp team.cpp
+///
+/// @author Dominick Banasik
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "element.hpp"
+#include "equation.hpp"
+
+#define STAGES 5
+#define WARMUP 64
+
+/// The names of the stages, in the order they run.
+
+static const char* STAGE_NAMES[STAGES] = {"parse", "atoms", "matrix", "reduce", "solve"};
+
+/// The Shape struct holds the properties of the reactions to generate.
+
+struct Shape {
+    int species;
+    int elements;
+    int depth;
+    int coefficient;
+};
+
+/// The Options struct holds the settings chosen on the command line.
+
+struct Options {
+    int equations;
+    unsigned int seed;
+    Engine engine;
+    const char* engineName;
+    bool json;
+    bool single;
+    Shape shape;
+};
+
+/// The ReactionGenerator class makes random reactions that are known to
+/// balance. Every species but two gets a random formula and coefficient;
+/// one extra reactant and one extra product then take up whatever atoms
+/// the others leave over, so the chosen coefficients are a solution.
+
+class ReactionGenerator {
+    private:
+        std::mt19937 random;
+        std::vector<int> pool;
+        std::vector<long long> counts;
+        std::vector<long long> balance;
+
+        /// Returns a random number in a range.
+        ///
+        /// @param low the smallest number
+        /// @param high the largest number
+        /// @return the number
+
+        int between(int low, int high) {
+            return std::uniform_int_distribution<int>(low, high)(random);
+        }
+
+        /// Appends a random formula with groups nested a number of levels
+        /// deep, adding up its atoms.
+        ///
+        /// @param depth the number of nested groups
+        /// @param multiplier the number of times the formula is repeated
+        /// @param formula the string to append to
+
+        void appendFormula(int depth, long long multiplier, std::string& formula) {
+            int parts = between(1, 2);
+            for (int i = 0; i < parts; i++) {
+                int element = pool[between(0, pool.size() - 1)];
+                int count = between(1, 4);
+                formula += PeriodicTable::symbol(element);
+                if (count > 1) formula += std::to_string(count);
+                counts[element] += count * multiplier;
+            }
+            if (depth > 0) {
+                int repeat = between(2, 3);
+                formula += '(';
+                appendFormula(depth - 1, multiplier * repeat, formula);
+                formula += ')';
+                formula += std::to_string(repeat);
+            }
+        }
+
+        /// Appends the species that takes up the atoms on one side.
+        ///
+        /// @param sign 1 for the atoms left over on the reactants, -1 for
+        ///             those on the products
+        /// @param side the side to append to
+        /// @return whether any atoms were left over
+
+        bool appendRemainder(int sign, std::string& side) {
+            std::string formula;
+            for (int element = 1; element <= ELEMENT_COUNT; element++) {
+                long long count = balance[element] * sign;
+                if (count <= 0) continue;
+                formula += PeriodicTable::symbol(element);
+                if (count > 1) formula += std::to_string(count);
+            }
+            if (formula.empty()) return false;
+            if (!side.empty()) side += " + ";
+            side += '_';
+            side += formula;
+            return true;
+        }
+
+    public:
+        /// Constructor for the ReactionGenerator class.
+        ///
+        /// @param seed the seed of the random numbers
+
+        ReactionGenerator(unsigned int seed) : random(seed), counts(ELEMENT_COUNT + 1),
+                balance(ELEMENT_COUNT + 1) {
+        }
+
+        /// Makes a reaction.
+        ///
+        /// @param shape the properties of the reaction
+        /// @return the reaction, with every coefficient left free
+
+        std::string next(const Shape& shape) {
+            pool.clear();
+            for (int element = 1; element <= ELEMENT_COUNT; element++) {
+                pool.push_back(element);
+            }
+            int elements = shape.elements < ELEMENT_COUNT ? shape.elements : ELEMENT_COUNT;
+            for (int i = 0; i < elements; i++) {
+                std::swap(pool[i], pool[between(i, ELEMENT_COUNT - 1)]);
+            }
+            pool.resize(elements);
+            std::fill(balance.begin(), balance.end(), 0);
+
+            std::string reactants;
+            std::string products;
+            int chosen = shape.species > 2 ? shape.species - 2 : 1;
+            for (int i = 0; i < chosen; i++) {
+                bool reactant = i < chosen / 2 || i == 0;
+                std::string& side = reactant ? reactants : products;
+                int coefficient = between(1, shape.coefficient);
+
+                std::fill(counts.begin(), counts.end(), 0);
+                if (!side.empty()) side += " + ";
+                side += '_';
+                appendFormula(shape.depth, 1, side);
+                for (int element = 1; element <= ELEMENT_COUNT; element++) {
+                    balance[element] += (reactant ? coefficient : -coefficient) * counts[element];
+                }
+            }
+            appendRemainder(-1, reactants);
+            appendRemainder(1, products);
+            return reactants + " = " + products;
+        }
+};
+
+/// The StageTimer class runs the stages of Equation::balance one at a
+/// time, timing each.
+
+class StageTimer {
+    public:
+        /// Balances an equation, adding the time each stage took.
+        ///
+        /// @param equation the equation to parse the line into
+        /// @param line the equation to balance
+        /// @param engine the elimination to reduce the matrix with
+        /// @param stages the nanoseconds spent in each stage so far
+        /// @return whether the equation was solved
+
+        static bool time(Equation& equation, std::string_view line, Engine engine, double* stages) {
+            auto start = std::chrono::steady_clock::now();
+            equation.clear();
+            equation.arena.reset();
+            equation.parse(line);
+            auto parsed = std::chrono::steady_clock::now();
+            equation.generateAtoms(true);
+            equation.generateAtoms(false);
+            auto counted = std::chrono::steady_clock::now();
+            stages[0] += std::chrono::duration<double, std::nano>(parsed - start).count();
+            stages[1] += std::chrono::duration<double, std::nano>(counted - parsed).count();
+            if (!equation.valid) return false;
+
+            if (engine == SPARSE) {
+                SparseMatrix<Rational> matrix = equation.createSparseMatrixFromEquation();
+                return timeMatrix(matrix, engine, counted, stages);
+            }
+            Matrix<Rational> matrix = equation.createMatrixFromEquation();
+            return timeMatrix(matrix, engine, counted, stages);
+        }
+
+    private:
+        /// Reduces and solves a matrix, adding the time each stage took.
+        ///
+        /// @tparam M the type of the matrix
+        /// @param matrix the matrix, just built
+        /// @param engine the elimination to reduce the matrix with
+        /// @param start when the matrix started being built
+        /// @param stages the nanoseconds spent in each stage so far
+        /// @return whether the equation was solved
+
+        template <typename M>
+        static bool timeMatrix(M& matrix, Engine engine, std::chrono::steady_clock::time_point start,
+                double* stages) {
+            auto built = std::chrono::steady_clock::now();
+            reduce(matrix, engine);
+            auto reduced = std::chrono::steady_clock::now();
+            Solution solution = matrix.solve();
+            auto solved = std::chrono::steady_clock::now();
+            stages[2] += std::chrono::duration<double, std::nano>(built - start).count();
+            stages[3] += std::chrono::duration<double, std::nano>(reduced - built).count();
+            stages[4] += std::chrono::duration<double, std::nano>(solved - reduced).count();
+            return solution.getStatus() == SOLVED;
+        }
+
+        /// Reduces a sparse matrix, which has only one engine. It is only
+        /// built when the sparse engine was chosen, so the engine the
+        /// dense overload takes is not needed here.
+        ///
+        /// @param matrix the matrix to reduce
+
+        static void reduce(SparseMatrix<Rational>& matrix, Engine /*engine*/) {
+            matrix.reduce();
+        }
+
+        /// Reduces a dense matrix with the chosen engine.
+        ///
+        /// @param matrix the matrix to reduce
+        /// @param engine the elimination to reduce the matrix with
+
+        static void reduce(Matrix<Rational>& matrix, Engine engine) {
+            matrix.reduce(engine);
+        }
+};
+
+/// Prints a usage message.
+
+void usage() {
+    fprintf(stderr, "usage: ./stages [-j] [-n equations] [-r seed] [-e engine]"
+            " [-s species] [-l elements] [-d depth] [-c coefficient]\n");
+}
+
+/// Parses the name of an elimination engine.
+///
+/// @param name the name given on the command line
+/// @param engine where to store the engine
+/// @return whether or not the name was recognized
+
+bool parseEngine(const char* name, Engine* engine) {
+    if (!strcmp(name, "bareiss")) {
+        *engine = FRACTION_FREE;
+    } else if (!strcmp(name, "gauss")) {
+        *engine = GAUSS_JORDAN;
+    } else if (!strcmp(name, "modular")) {
+        *engine = MODULAR;
+    } else if (!strcmp(name, "sparse")) {
+        *engine = SPARSE;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+/// Processes all command line flags. Giving any property of the reactions
+/// runs that one shape instead of the sweeps.
+///
+/// @param argc the number of command line arguments
+/// @param argv the array of command line arguments
+/// @param options the options to fill in
+
+void processFlags(int argc, char** argv, Options* options) {
+    int opt;
+
+    options->equations = 500;
+    options->seed = 1;
+    options->engine = SPARSE;
+    options->engineName = "sparse";
+    options->json = false;
+    options->single = false;
+    options->shape.species = 8;
+    options->shape.elements = 6;
+    options->shape.depth = 1;
+    options->shape.coefficient = 5;
+
+    while ((opt = getopt(argc, argv, "jn:r:e:s:l:d:c:")) != -1) {
+        switch (opt) {
+            case 'j':
+                options->json = true;
+                break;
+            case 'n':
+                options->equations = atoi(optarg);
+                break;
+            case 'r':
+                options->seed = strtoul(optarg, NULL, 10);
+                break;
+            case 'e':
+                if (!parseEngine(optarg, &options->engine)) {
+                    usage();
+                    exit(1);
+                }
+                options->engineName = optarg;
+                break;
+            case 's':
+                options->shape.species = atoi(optarg);
+                options->single = true;
+                break;
+            case 'l':
+                options->shape.elements = atoi(optarg);
+                options->single = true;
+                break;
+            case 'd':
+                options->shape.depth = atoi(optarg);
+                options->single = true;
+                break;
+            case 'c':
+                options->shape.coefficient = atoi(optarg);
+                options->single = true;
+                break;
+            default:
+                usage();
+                exit(1);
+        }
+    }
+
+    Shape& shape = options->shape;
+    if (optind < argc || options->equations < 1 || shape.species < 2 || shape.elements < 1 || shape.depth < 0
+            || shape.coefficient < 1) {
+        usage();
+        exit(1);
+    }
+}
+
+/// Times every stage over a batch of generated reactions of one shape and
+/// prints the mean time of each.
+///
+/// @param sweep the name of the property being swept
+/// @param shape the properties of the reactions
+/// @param options the options chosen on the command line
+/// @param first whether this is the first result printed
+
+void runShape(const char* sweep, const Shape& shape, Options* options, bool first) {
+    ReactionGenerator generator(options->seed);
+    std::vector<std::string> lines;
+    for (int i = 0; i < options->equations; i++) {
+        lines.push_back(generator.next(shape));
+    }
+
+    Equation equation;
+    double stages[STAGES] = {0};
+    for (int i = 0; i < WARMUP && i < options->equations; i++) {
+        StageTimer::time(equation, lines[i], options->engine, stages);
+    }
+
+    memset(stages, 0, sizeof(stages));
+    int solved = 0;
+    for (int i = 0; i < options->equations; i++) {
+        if (StageTimer::time(equation, lines[i], options->engine, stages)) solved++;
+    }
+
+    double total = 0;
+    for (int i = 0; i < STAGES; i++) {
+        stages[i] /= options->equations;
+        total += stages[i];
+    }
+
+    if (options->json) {
+        printf("%s  {\"sweep\": \"%s\", \"species\": %d, \"elements\": %d, \"depth\": %d, \"coefficient\": %d, "
+                "\"engine\": \"%s\", \"equations\": %d, \"solved\": %d", first ? "" : ",\n", sweep,
+                shape.species, shape.elements, shape.depth, shape.coefficient, options->engineName,
+                options->equations, solved);
+        for (int i = 0; i < STAGES; i++) {
+            printf(", \"%s_ns\": %.1f", STAGE_NAMES[i], stages[i]);
+        }
+        printf(", \"total_ns\": %.1f}", total);
+    } else {
+        printf("%s,%d,%d,%d,%d,%s,%d,%d", sweep, shape.species, shape.elements, shape.depth, shape.coefficient,
+                options->engineName, options->equations, solved);
+        for (int i = 0; i < STAGES; i++) {
+            printf(",%.1f", stages[i]);
+        }
+        printf(",%.1f\n", total);
+    }
+    fflush(stdout);
+}
+
+/// The main function sweeps the species count, element count, nesting
+/// depth and coefficient size in turn, holding the others at the chosen
+/// values, or runs the one shape chosen.
+///
+/// @param argc the number of command line arguments
+/// @param argv the array of command line arguments
+/// @return EXIT_SUCCESS
+
+int main(int argc, char** argv) {
+    Options options;
+    processFlags(argc, argv, &options);
+
+    if (options.json) {
+        printf("[\n");
+    } else {
+        printf("sweep,species,elements,depth,coefficient,engine,equations,solved");
+        for (int i = 0; i < STAGES; i++) {
+            printf(",%s_ns", STAGE_NAMES[i]);
+        }
+        printf(",total_ns\n");
+    }
+
+    if (options.single) {
+        runShape("single", options.shape, &options, true);
+    } else {
+        int species[] = {4, 8, 16, 32, 64};
+        int elements[] = {2, 4, 8, 16, 32, 64};
+        int depths[] = {0, 1, 2, 4, 8, 12};
+        int coefficients[] = {1, 10, 100, 1000, 10000};
+        bool first = true;
+
+        for (int value : species) {
+            Shape shape = options.shape;
+            shape.species = value;
+            runShape("species", shape, &options, first);
+            first = false;
+        }
+        for (int value : elements) {
+            Shape shape = options.shape;
+            shape.elements = value;
+            runShape("elements", shape, &options, false);
+        }
+        for (int value : depths) {
+            Shape shape = options.shape;
+            shape.depth = value;
+            runShape("depth", shape, &options, false);
+        }
+        for (int value : coefficients) {
+            Shape shape = options.shape;
+            shape.coefficient = value;
+            runShape("coefficient", shape, &options, false);
+        }
+    }
+
+    if (options.json) printf("\n]\n");
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,269 @@
+///
+/// file: stats.cpp
+/// Implementation for the Histogram and Stats classes
+///
+/// @author Dominick Banasik
+
+#include <stdio.h>
+
+#include <mutex>
+#include <vector>
+
+#include "stats.hpp"
+
+#ifndef _STATS_IMPL_
+#define _STATS_IMPL_
+
+/// The names of the stages, in the order of the Stage enum.
+
+static const char* STAGE_LABELS[STAGE_COUNT] = {"parse", "atoms", "matrix", "reduce", "solve"};
+
+/// The names of the counters, in the order of the Counter enum.
+
+static const char* COUNTER_NAMES[COUNTER_COUNT] = {
+    "equations", "solved", "matrices", "matrix_rows", "matrix_columns", "fraction_normalizations"
+};
+
+/// The names of the maxima, in the order of the Maximum enum.
+
+static const char* MAXIMUM_NAMES[MAXIMUM_COUNT] = {
+    "largest_matrix_rows", "largest_matrix_columns", "largest_coefficient_bits"
+};
+
+/// The quantiles of each stage that are exported.
+
+static const double QUANTILES[] = {0.5, 0.9, 0.99, 0.999};
+static const char* QUANTILE_NAMES[] = {"p50", "p90", "p99", "p999"};
+#define QUANTILE_COUNT 4
+
+/// The stats of every thread that has recorded, kept after the thread
+/// exits so its work still counts.
+
+static std::mutex registryLock;
+static std::vector<ThreadStats*> registry;
+
+/// When the process started, in ticks and in nanoseconds, to convert
+/// between the two.
+
+static const unsigned long long START_TICKS = Stats::now();
+static const std::chrono::steady_clock::time_point START_TIME = std::chrono::steady_clock::now();
+
+/// Constructor for the Histogram class.
+
+Histogram::Histogram() {
+    for (int i = 0; i < HISTOGRAM_BUCKETS; i++) {
+        buckets[i].store(0, std::memory_order_relaxed);
+    }
+    count.store(0, std::memory_order_relaxed);
+    sum.store(0, std::memory_order_relaxed);
+    max.store(0, std::memory_order_relaxed);
+}
+
+/// Returns the smallest value that falls in a bucket.
+
+unsigned long long Histogram::lowestIn(int bucket) {
+    if (bucket < 2 * SUB_BUCKETS) return bucket;
+    int exponent = (bucket - 2 * SUB_BUCKETS) / SUB_BUCKETS + SUB_BUCKET_BITS + 1;
+    unsigned long long mantissa = (bucket - 2 * SUB_BUCKETS) % SUB_BUCKETS;
+    return (SUB_BUCKETS + mantissa) << (exponent - SUB_BUCKET_BITS);
+}
+
+/// Adds every value of another histogram.
+
+void Histogram::merge(const Histogram& other) {
+    for (int i = 0; i < HISTOGRAM_BUCKETS; i++) {
+        buckets[i].fetch_add(other.buckets[i].load(std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+    count.fetch_add(other.count.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    sum.fetch_add(other.sum.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    unsigned long long largest = other.max.load(std::memory_order_relaxed);
+    if (largest > max.load(std::memory_order_relaxed)) max.store(largest, std::memory_order_relaxed);
+}
+
+/// Returns the number of values recorded.
+
+unsigned long long Histogram::getCount() const {
+    return count.load(std::memory_order_relaxed);
+}
+
+/// Returns the sum of the values recorded.
+
+unsigned long long Histogram::getSum() const {
+    return sum.load(std::memory_order_relaxed);
+}
+
+/// Returns the largest value recorded.
+
+unsigned long long Histogram::getMax() const {
+    return max.load(std::memory_order_relaxed);
+}
+
+/// Returns the value below which a fraction of the values fall.
+
+unsigned long long Histogram::getQuantile(double quantile) const {
+    unsigned long long total = 0;
+    for (int i = 0; i < HISTOGRAM_BUCKETS; i++) {
+        total += buckets[i].load(std::memory_order_relaxed);
+    }
+    if (total == 0) return 0;
+
+    unsigned long long rank = (unsigned long long) (quantile * (total - 1));
+    unsigned long long seen = 0;
+    for (int i = 0; i < HISTOGRAM_BUCKETS; i++) {
+        seen += buckets[i].load(std::memory_order_relaxed);
+        if (seen > rank) return lowestIn(i);
+    }
+    return getMax();
+}
+
+/// Constructor for the ThreadStats struct.
+
+ThreadStats::ThreadStats() {
+    for (int i = 0; i < COUNTER_COUNT; i++) {
+        counters[i].store(0, std::memory_order_relaxed);
+    }
+    for (int i = 0; i < MAXIMUM_COUNT; i++) {
+        maxima[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+/// Creates and registers the calling thread's stats.
+
+ThreadStats* Stats::attach() {
+    ThreadStats* stats = new ThreadStats;
+    std::lock_guard<std::mutex> guard(registryLock);
+    registry.push_back(stats);
+    local = stats;
+    return stats;
+}
+
+/// Returns the number of ticks in a nanosecond.
+
+double Stats::ticksPerNanosecond() {
+#ifdef STATS_TSC
+    double elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - START_TIME).count();
+    unsigned long long ticks = now() - START_TICKS;
+    return elapsed > 0 && ticks > 0 ? ticks / elapsed : 1;
+#else
+    return 1;
+#endif
+}
+
+/// Merges the stats of every thread.
+
+void Stats::collect(ThreadStats& total) {
+    std::lock_guard<std::mutex> guard(registryLock);
+    for (size_t i = 0; i < registry.size(); i++) {
+        ThreadStats* stats = registry[i];
+        for (int j = 0; j < STAGE_COUNT; j++) {
+            total.stages[j].merge(stats->stages[j]);
+        }
+        for (int j = 0; j < COUNTER_COUNT; j++) {
+            total.counters[j].fetch_add(stats->counters[j].load(std::memory_order_relaxed));
+        }
+        for (int j = 0; j < MAXIMUM_COUNT; j++) {
+            long long value = stats->maxima[j].load(std::memory_order_relaxed);
+            if (value > total.maxima[j].load()) total.maxima[j].store(value);
+        }
+    }
+}
+
+/// Appends the stats of every thread as a JSON object.
+
+void Stats::exportJson(std::string& output) {
+    ThreadStats* total = new ThreadStats;
+    collect(*total);
+    double scale = ticksPerNanosecond();
+    char buffer[128];
+
+    output += "{\"enabled\": ";
+    output += getEnabled() ? "true" : "false";
+    snprintf(buffer, sizeof(buffer), ", \"sample_rate\": %d", SAMPLE_RATE);
+    output += buffer;
+    for (int i = 0; i < COUNTER_COUNT; i++) {
+        snprintf(buffer, sizeof(buffer), ", \"%s\": %lld", COUNTER_NAMES[i], total->counters[i].load());
+        output += buffer;
+    }
+    for (int i = 0; i < MAXIMUM_COUNT; i++) {
+        snprintf(buffer, sizeof(buffer), ", \"%s\": %lld", MAXIMUM_NAMES[i], total->maxima[i].load());
+        output += buffer;
+    }
+
+    output += ", \"stages\": {";
+    for (int i = 0; i < STAGE_COUNT; i++) {
+        const Histogram& stage = total->stages[i];
+        snprintf(buffer, sizeof(buffer), "%s\"%s\": {\"count\": %llu, \"sum_ns\": %.0f, \"max_ns\": %.0f",
+                i > 0 ? ", " : "", STAGE_LABELS[i], stage.getCount(), stage.getSum() / scale,
+                stage.getMax() / scale);
+        output += buffer;
+        for (int j = 0; j < QUANTILE_COUNT; j++) {
+            snprintf(buffer, sizeof(buffer), ", \"%s_ns\": %.0f", QUANTILE_NAMES[j],
+                    stage.getQuantile(QUANTILES[j]) / scale);
+            output += buffer;
+        }
+        output += '}';
+    }
+    output += "}}\n";
+    delete total;
+}
+
+/// Appends the stats of every thread in the Prometheus text format. Each
+/// stage is a summary of its sampled latency in seconds.
+
+void Stats::exportPrometheus(std::string& output) {
+    ThreadStats* total = new ThreadStats;
+    collect(*total);
+    double scale = ticksPerNanosecond() * 1e9;
+    char buffer[160];
+
+    for (int i = 0; i < COUNTER_COUNT; i++) {
+        snprintf(buffer, sizeof(buffer), "# TYPE balancer_%s_total counter\nbalancer_%s_total %lld\n",
+                COUNTER_NAMES[i], COUNTER_NAMES[i], total->counters[i].load());
+        output += buffer;
+    }
+    for (int i = 0; i < MAXIMUM_COUNT; i++) {
+        snprintf(buffer, sizeof(buffer), "# TYPE balancer_%s gauge\nbalancer_%s %lld\n",
+                MAXIMUM_NAMES[i], MAXIMUM_NAMES[i], total->maxima[i].load());
+        output += buffer;
+    }
+
+    snprintf(buffer, sizeof(buffer), "# HELP balancer_stage_seconds Time spent in each stage, sampled from one "
+            "equation in %d\n", SAMPLE_RATE);
+    output += buffer;
+    output += "# TYPE balancer_stage_seconds summary\n";
+    for (int i = 0; i < STAGE_COUNT; i++) {
+        const Histogram& stage = total->stages[i];
+        for (int j = 0; j < QUANTILE_COUNT; j++) {
+            snprintf(buffer, sizeof(buffer), "balancer_stage_seconds{stage=\"%s\",quantile=\"%g\"} %.9f\n",
+                    STAGE_LABELS[i], QUANTILES[j], stage.getQuantile(QUANTILES[j]) / scale);
+            output += buffer;
+        }
+        snprintf(buffer, sizeof(buffer), "balancer_stage_seconds_sum{stage=\"%s\"} %.9f\n"
+                "balancer_stage_seconds_count{stage=\"%s\"} %llu\n", STAGE_LABELS[i], stage.getSum() / scale,
+                STAGE_LABELS[i], stage.getCount());
+        output += buffer;
+    }
+    delete total;
+}
+
+/// Appends the stats of every thread in a format.
+
+void Stats::exportAs(StatsFormat format, std::string& output) {
+    if (format == STATS_JSON) {
+        exportJson(output);
+    } else if (format == STATS_PROMETHEUS) {
+        exportPrometheus(output);
+    }
+}
+
+/// Checks whether recording was compiled in.
+
+bool Stats::getEnabled() {
+#ifdef BALANCER_STATS
+    return true;
+#else
+    return false;
+#endif
+}
+
+#endif
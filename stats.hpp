@@ -0,0 +1,360 @@
+///
+/// file: stats.hpp
+/// Header file for the Histogram and Stats classes, which count what the
+/// balancer does and how long each stage takes. Recording is compiled in
+/// only when BALANCER_STATS is defined; otherwise the STATS_ macros are
+/// empty and cost nothing.
+///
+/// @author Dominick Banasik
+
+#ifndef _STATS_H_
+#define _STATS_H_
+
+#include <atomic>
+#include <chrono>
+#include <string>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define STATS_TSC
+#endif
+
+#define SAMPLE_RATE 16
+#define SUB_BUCKETS 16
+#define SUB_BUCKET_BITS 4
+#define HISTOGRAM_BUCKETS (2 * SUB_BUCKETS + (64 - SUB_BUCKET_BITS - 1) * SUB_BUCKETS)
+
+/// The Stage enum names the stages of balancing that are timed.
+
+enum Stage {
+    STAGE_PARSE,
+    STAGE_ATOMS,
+    STAGE_MATRIX,
+    STAGE_REDUCE,
+    STAGE_SOLVE,
+    STAGE_COUNT
+};
+
+/// The Counter enum names the events that are counted.
+
+enum Counter {
+    COUNT_EQUATIONS,
+    COUNT_SOLVED,
+    COUNT_MATRICES,
+    COUNT_MATRIX_ROWS,
+    COUNT_MATRIX_COLUMNS,
+    COUNT_NORMALIZATIONS,
+    COUNTER_COUNT
+};
+
+/// The Maximum enum names the largest values that are kept.
+
+enum Maximum {
+    MAX_MATRIX_ROWS,
+    MAX_MATRIX_COLUMNS,
+    MAX_COEFFICIENT_BITS,
+    MAXIMUM_COUNT
+};
+
+/// The StatsFormat enum selects how stats are exported.
+
+enum StatsFormat {
+    STATS_NONE,
+    STATS_JSON,
+    STATS_PROMETHEUS
+};
+
+/// The Histogram class counts values in buckets whose width grows with
+/// the value, as HdrHistogram does: values below 2 * SUB_BUCKETS get a
+/// bucket each, and every power of two above is split into SUB_BUCKETS
+/// buckets, so any value is known to within 1 / SUB_BUCKETS. Only the
+/// thread that owns a histogram records into it; others may read it at
+/// any time.
+
+class Histogram {
+    private:
+        std::atomic<unsigned long long> buckets[HISTOGRAM_BUCKETS];
+        std::atomic<unsigned long long> count;
+        std::atomic<unsigned long long> sum;
+        std::atomic<unsigned long long> max;
+
+    public:
+        /// Constructor for the Histogram class.
+
+        Histogram();
+
+        /// Returns the bucket a value falls in.
+        ///
+        /// @param value the value
+        /// @return the index of its bucket
+
+        static int bucketOf(unsigned long long value);
+
+        /// Returns the smallest value that falls in a bucket.
+        ///
+        /// @param bucket the index of the bucket
+        /// @return the smallest value in it
+
+        static unsigned long long lowestIn(int bucket);
+
+        /// Adds a value. Only the owning thread may call this.
+        ///
+        /// @param value the value to add
+
+        void record(unsigned long long value);
+
+        /// Adds every value of another histogram.
+        ///
+        /// @param other the histogram to add
+
+        void merge(const Histogram& other);
+
+        /// Returns the number of values recorded.
+        ///
+        /// @return the number of values
+
+        unsigned long long getCount() const;
+
+        /// Returns the sum of the values recorded.
+        ///
+        /// @return the sum
+
+        unsigned long long getSum() const;
+
+        /// Returns the largest value recorded.
+        ///
+        /// @return the largest value
+
+        unsigned long long getMax() const;
+
+        /// Returns the value below which a fraction of the values fall.
+        ///
+        /// @param quantile the fraction, from 0 to 1
+        /// @return the lowest value of the bucket the quantile falls in
+
+        unsigned long long getQuantile(double quantile) const;
+};
+
+/// The ThreadStats struct holds everything one thread has recorded.
+
+struct alignas(64) ThreadStats {
+    Histogram stages[STAGE_COUNT];
+    std::atomic<long long> counters[COUNTER_COUNT];
+    std::atomic<long long> maxima[MAXIMUM_COUNT];
+
+    /// Constructor for the ThreadStats struct.
+
+    ThreadStats();
+};
+
+/// The Stats class records into the calling thread's stats and merges
+/// the stats of every thread when they are exported. Each thread gets its
+/// own ThreadStats the first time it records, so recording never takes a
+/// lock or shares a cache line. Reading the clock costs more than the
+/// counters, so only one equation in SAMPLE_RATE on each thread has its
+/// stages timed. Times are kept in clock ticks, which are converted to
+/// nanoseconds on export.
+
+class Stats {
+    private:
+        static inline thread_local ThreadStats* local = NULL;
+        static inline thread_local unsigned int equations = 0;
+        static inline thread_local bool timing = false;
+
+        /// Creates and registers the calling thread's stats.
+        ///
+        /// @return the stats of the calling thread
+
+        static ThreadStats* attach();
+
+        /// Returns the number of ticks in a nanosecond, measured over the
+        /// life of the process.
+        ///
+        /// @return the ticks per nanosecond
+
+        static double ticksPerNanosecond();
+
+    public:
+        /// The number of fraction normalizations on this thread not yet
+        /// added to its counters. Kept apart so the arithmetic only bumps
+        /// a thread local.
+
+        static inline thread_local long long normalized = 0;
+
+        /// Returns the calling thread's stats.
+        ///
+        /// @return the stats of the calling thread
+
+        static ThreadStats* current();
+
+        /// Starts an equation, deciding whether its stages are timed.
+
+        static void sample();
+
+        /// Returns the time a stage starts if the equation is timed.
+        ///
+        /// @return the time in ticks, or 0 if the equation is not timed
+
+        static unsigned long long start();
+
+        /// Adds the fraction normalizations counted since the last flush
+        /// to the calling thread's counters.
+
+        static void flush();
+
+        /// Returns the current time in ticks of a cheap clock: the time
+        /// stamp counter where there is one, nanoseconds otherwise.
+        ///
+        /// @return the time in ticks
+
+        static unsigned long long now();
+
+        /// Records how long a stage took, if it was timed.
+        ///
+        /// @param stage the stage
+        /// @param start the time in ticks the stage started, or 0
+
+        static void record(Stage stage, unsigned long long start);
+
+        /// Adds to a counter.
+        ///
+        /// @param counter the counter
+        /// @param amount the amount to add
+
+        static void count(Counter counter, long long amount = 1);
+
+        /// Raises a maximum if a value is larger.
+        ///
+        /// @param maximum the maximum
+        /// @param value the value seen
+
+        static void raise(Maximum maximum, long long value);
+
+        /// Merges the stats of every thread.
+        ///
+        /// @param total where to add the stats
+
+        static void collect(ThreadStats& total);
+
+        /// Appends the stats of every thread as a JSON object.
+        ///
+        /// @param output the string to append to
+
+        static void exportJson(std::string& output);
+
+        /// Appends the stats of every thread in the Prometheus text format.
+        ///
+        /// @param output the string to append to
+
+        static void exportPrometheus(std::string& output);
+
+        /// Appends the stats of every thread in a format.
+        ///
+        /// @param format the format to export in
+        /// @param output the string to append to
+
+        static void exportAs(StatsFormat format, std::string& output);
+
+        /// Checks whether recording was compiled in.
+        ///
+        /// @return whether BALANCER_STATS was defined
+
+        static bool getEnabled();
+};
+
+#ifdef BALANCER_STATS
+#define STATS_SAMPLE() Stats::sample()
+#define STATS_START(name) unsigned long long name = Stats::start()
+#define STATS_STAGE(stage, start) Stats::record(stage, start)
+#define STATS_COUNT(counter, amount) Stats::count(counter, amount)
+#define STATS_RAISE(maximum, value) Stats::raise(maximum, value)
+#define STATS_NORMALIZED() if (!__builtin_is_constant_evaluated()) Stats::normalized++
+#define STATS_FLUSH() Stats::flush()
+#else
+#define STATS_SAMPLE() ((void) 0)
+#define STATS_START(name)
+#define STATS_STAGE(stage, start) ((void) 0)
+#define STATS_COUNT(counter, amount) ((void) 0)
+#define STATS_RAISE(maximum, value) ((void) 0)
+#define STATS_NORMALIZED() ((void) 0)
+#define STATS_FLUSH() ((void) 0)
+#endif
+
+/// Returns the bucket a value falls in.
+
+inline int Histogram::bucketOf(unsigned long long value) {
+    if (value < 2 * SUB_BUCKETS) return (int) value;
+    int exponent = 63 - __builtin_clzll(value);
+    int mantissa = (int) (value >> (exponent - SUB_BUCKET_BITS)) & (SUB_BUCKETS - 1);
+    return 2 * SUB_BUCKETS + (exponent - SUB_BUCKET_BITS - 1) * SUB_BUCKETS + mantissa;
+}
+
+/// Adds a value.
+
+inline void Histogram::record(unsigned long long value) {
+    std::atomic<unsigned long long>& bucket = buckets[bucketOf(value)];
+    bucket.store(bucket.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    count.store(count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    sum.store(sum.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+    if (value > max.load(std::memory_order_relaxed)) max.store(value, std::memory_order_relaxed);
+}
+
+/// Returns the calling thread's stats.
+
+inline ThreadStats* Stats::current() {
+    ThreadStats* stats = local;
+    return stats ? stats : attach();
+}
+
+/// Returns the current time in ticks of a cheap clock.
+
+inline unsigned long long Stats::now() {
+#ifdef STATS_TSC
+    return __rdtsc();
+#else
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+/// Starts an equation, deciding whether its stages are timed.
+
+inline void Stats::sample() {
+    timing = equations++ % SAMPLE_RATE == 0;
+}
+
+/// Returns the time a stage starts if the equation is timed.
+
+inline unsigned long long Stats::start() {
+    return timing ? now() : 0;
+}
+
+/// Records how long a stage took, if it was timed.
+
+inline void Stats::record(Stage stage, unsigned long long start) {
+    if (start != 0) current()->stages[stage].record(now() - start);
+}
+
+/// Adds the fraction normalizations counted since the last flush.
+
+inline void Stats::flush() {
+    if (normalized == 0) return;
+    count(COUNT_NORMALIZATIONS, normalized);
+    normalized = 0;
+}
+
+/// Adds to a counter.
+
+inline void Stats::count(Counter counter, long long amount) {
+    std::atomic<long long>& value = current()->counters[counter];
+    value.store(value.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+}
+
+/// Raises a maximum if a value is larger.
+
+inline void Stats::raise(Maximum maximum, long long value) {
+    std::atomic<long long>& largest = current()->maxima[maximum];
+    if (value > largest.load(std::memory_order_relaxed)) largest.store(value, std::memory_order_relaxed);
+}
+
+#endif
@@ -0,0 +1,107 @@
+///
+/// file: team.cpp
+/// Implementation for the Team class
+///
+/// @author Dominick Banasik
+
+#include "team.hpp"
+
+#ifndef _TEAM_IMPL_
+#define _TEAM_IMPL_
+
+/// Runs one member thread until the team is destroyed.
+
+void Team::work(int id) {
+    long seen = 0;
+
+    while (true) {
+        const std::function<void(int)>* current;
+        {
+            std::unique_lock<std::mutex> guard(lock);
+            started.wait(guard, [&] { return generation != seen || stopping; });
+            if (stopping) return;
+            seen = generation;
+            current = job;
+        }
+
+        (*current)(id);
+
+        std::lock_guard<std::mutex> guard(lock);
+        if (--running == 0) stopped.notify_one();
+    }
+}
+
+/// Constructor for the Team class.
+
+Team::Team(int size) {
+    this->size = size > 0 ? size : 1;
+    job = NULL;
+    generation = 0;
+    running = 0;
+    stopping = false;
+    arrived.store(0);
+    phase.store(0);
+    for (int i = 1; i < this->size; i++) {
+        members.push_back(std::thread(&Team::work, this, i));
+    }
+}
+
+/// Destructor for the Team class.
+
+Team::~Team() {
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        stopping = true;
+    }
+    started.notify_all();
+    for (size_t i = 0; i < members.size(); i++) {
+        members[i].join();
+    }
+}
+
+/// Returns the number of members.
+
+int Team::getSize() const {
+    return size;
+}
+
+/// Runs a job on every member and returns once all are done.
+
+void Team::run(const std::function<void(int)>& job) {
+    if (size == 1) {
+        job(0);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        this->job = &job;
+        running = size - 1;
+        generation++;
+    }
+    started.notify_all();
+
+    job(0);
+
+    std::unique_lock<std::mutex> guard(lock);
+    stopped.wait(guard, [this] { return running == 0; });
+}
+
+/// Waits until every member of the running job has reached this point.
+/// The last to arrive starts the next phase; the others watch for it.
+
+void Team::sync() {
+    if (size == 1) return;
+
+    long current = phase.load(std::memory_order_acquire);
+    if (arrived.fetch_add(1, std::memory_order_acq_rel) == size - 1) {
+        arrived.store(0, std::memory_order_relaxed);
+        phase.store(current + 1, std::memory_order_release);
+        return;
+    }
+    for (int spins = 0; phase.load(std::memory_order_acquire) == current; spins++) {
+        if (spins >= SPIN_LIMIT) std::this_thread::yield();
+    }
+}
+
+#endif
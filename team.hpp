@@ -0,0 +1,80 @@
+///
+/// file: team.hpp
+/// Header file for the Team class
+///
+/// @author Dominick Banasik
+
+#ifndef _TEAM_H_
+#define _TEAM_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#define SPIN_LIMIT 4096
+
+/// The Team class runs one job on a fixed group of threads at once, for
+/// splitting a single large computation rather than balancing many
+/// equations. The calling thread takes part as member 0, and the other
+/// members sleep between jobs. Members of a running job meet at sync(),
+/// which spins briefly before yielding, since the steps between syncs of
+/// an elimination are short.
+
+class Team {
+    private:
+        int size;
+        std::vector<std::thread> members;
+
+        std::mutex lock;
+        std::condition_variable started;
+        std::condition_variable stopped;
+        const std::function<void(int)>* job;
+        long generation;
+        int running;
+        bool stopping;
+
+        std::atomic<int> arrived;
+        std::atomic<long> phase;
+
+        /// Runs one member thread until the team is destroyed.
+        ///
+        /// @param id the index of the member
+
+        void work(int id);
+
+    public:
+        /// Constructor for the Team class.
+        ///
+        /// @param size the number of members, including the caller
+
+        Team(int size);
+
+        /// Destructor for the Team class.
+
+        ~Team();
+
+        Team(const Team& copy) = delete;
+        Team& operator=(const Team& copy) = delete;
+
+        /// Returns the number of members.
+        ///
+        /// @return the number of members
+
+        int getSize() const;
+
+        /// Runs a job on every member and returns once all are done.
+        ///
+        /// @param job the job, given the index of the member running it
+
+        void run(const std::function<void(int)>& job);
+
+        /// Waits until every member of the running job has reached this
+        /// point. Every member must call it the same number of times.
+
+        void sync();
+};
+
+#endif